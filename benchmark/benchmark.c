@@ -7,15 +7,29 @@
  * v1.2 2015-11-25 / 2017-11-22 Pirmin Schmid, MIT License
  */
 
+#define _GNU_SOURCE // sched_getcpu(), syscall()
+
 #include "benchmark.h"
 
 #include <assert.h>
+#include <cpuid.h>
 #include <float.h>
 #include <inttypes.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/resource.h>
+#include <sys/utsname.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 //--- private data ---------------------------------------------------------------------------------
 //    some internal variables
@@ -23,23 +37,113 @@
 static uint64_t baseline_ = 0;
 static uint64_t baseline_backup_ = 0; // used to handle baseline reset by development_map_values()
 
-// raw data stored from measurement
+// raw data stored from measurement; allocated by testbench_alloc_buffer()
 static uint64_t *data_ = NULL;
+static unsigned data_properties_ = 0;
 
 // temporary internal data for outlier removal
-// allocated at the beginning to avoid lots of mallocs() later
+// allocated at first use (see analysis_buffer())
 static uint64_t *data_without_outliers_ = NULL;
 
-// additional temporary internal data for outlier removal (histogram method)
-// allocated at the beginning to avoid mallocs() later
+// optional start timestamps of the measurements (see set_timestamps())
+static uint64_t *timestamps_ = NULL;
+static bool timestamps_enabled_ = false;
+
+// warmup trimming (see set_warmup_trimming())
+static bool warmup_trimming_ = false;
+static size_t warmup_trimmed_ = 0;
+
+// event accounting (see set_event_accounting())
+struct event_snapshot {
+    uint64_t voluntary_switches;
+    uint64_t involuntary_switches;
+    uint64_t minor_faults;
+    uint64_t major_faults;
+    uint64_t interrupts;
+    bool interrupts_available;
+    int cpu;
+};
+
+struct event_record {
+    size_t first; // index of the first value of the batch
+    size_t count;
+    uint64_t voluntary_switches;
+    uint64_t involuntary_switches;
+    uint64_t minor_faults;
+    uint64_t major_faults;
+    uint64_t interrupts;
+    uint64_t migrations;
+};
+
+static enum testbench_event_accounting_mode event_mode_ = TESTBENCH_EVENTS_OFF;
+static size_t event_batch_size_ = TESTBENCH_STD_EVENT_BATCH;
+static struct event_record *event_records_ = NULL; // one batch per value at most
+static size_t event_records_cap_ = 0;
+static size_t event_records_n_ = 0;
+static size_t event_batch_first_ = 0;
+static struct event_snapshot event_before_;
+static bool event_interrupts_available_ = false;
+
+// BATCH: /proc/interrupts is read at the start and the end of the series only (parsing it
+// takes tens of microseconds); the interrupts of the series are attributed over all values
+// the end is read once when the series is closed by the first analysis call; later calls use
+// the stored count (interrupts while printing / analysing are not part of the series) until
+// the next add_measurement() or reset_testbench()
+static struct event_snapshot event_series_before_;
+static bool event_series_started_ = false;
+static bool event_series_closed_ = false;
+static uint64_t event_series_interrupts_ = 0;
+
+// per value: attributed to an event; filled by attribute_events()
+static bool *event_disturbed_ = NULL;
+
+// line buffer for reading /proc/interrupts
+static char *interrupts_line_ = NULL;
+static size_t interrupts_line_size_ = 0;
+
+// additional temporary internal data for outlier removal (histogram method), sorting
+// allocated at first use (see analysis_buffer())
 static uint64_t *data_working_temp_ = NULL;
 
 static size_t cap_ = 0;
 static size_t count_ = 0;
 static size_t denominator_ = 1;
 
+// smallest step between consecutive RDTSC reads; determined in create_testbench()
+static uint64_t resolution_ = 1;
+
+// set by testbench_calibrate_denominator()
+static uint64_t loop_overhead_ = 0;
+static bool denominator_calibrated_ = false;
+
 static enum testbench_outlier_detection_mode outlier_detection_mode_ = TESTBENCH_OUTLIER_DETECTION_OFF;
 
+// cache state control
+struct cache_buffer {
+    const char *start;
+    size_t size;
+};
+
+static enum testbench_cache_mode cache_mode_ = TESTBENCH_CACHE_AS_IS;
+// mode of the stored values (reported with the statistics and the export): recorded by
+// reset_testbench(), testbench_prepare_cache() and the load functions
+static enum testbench_cache_mode values_cache_mode_ = TESTBENCH_CACHE_AS_IS;
+static struct cache_buffer cache_buffers_[TESTBENCH_MAX_CACHE_BUFFERS];
+static size_t cache_buffers_n_ = 0;
+
+// sweep buffer for COLD mode; allocated at first use
+static char *eviction_buffer_ = NULL;
+static size_t eviction_size_ = 0;
+
+// additional conditions (see set_conditions_note())
+static char conditions_note_[TESTBENCH_MAX_NOTE] = "";
+static bool conditions_note_keep_ = false;
+
+// sink for the pre-touching and sweeping reads
+static volatile char cache_sink_ = 0;
+
+#define CACHE_LINE_SIZE 64
+
 // default unit
 static struct testbench_time_unit cycles_ = {
     .name = "cycles",
@@ -104,6 +208,168 @@ static double get_t_value(size_t n)
     return 0.0;
 }
 
+static const char *cache_mode_name(enum testbench_cache_mode mode)
+{
+    switch (mode) {
+        case TESTBENCH_CACHE_AS_IS:
+            return "as is";
+        case TESTBENCH_CACHE_WARM:
+            return "warm";
+        case TESTBENCH_CACHE_COLD:
+            return "cold";
+        default:
+            assert(false);
+            return "unknown";
+    }
+}
+
+/**
+ * determines the size of the largest cache reported by CPUID leaf 4
+ * (deterministic cache parameters); 0 if not available
+ */
+static size_t detect_llc_size(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid_max(0, NULL) < 4) {
+        return 0;
+    }
+
+    size_t llc = 0;
+    for (unsigned int i = 0; i < 16; i++) {
+        __cpuid_count(4, i, eax, ebx, ecx, edx);
+        if ((eax & 0x1f) == 0) {
+            // no more caches
+            break;
+        }
+
+        size_t ways = ((ebx >> 22) & 0x3ff) + 1;
+        size_t partitions = ((ebx >> 12) & 0x3ff) + 1;
+        size_t line_size = (ebx & 0xfff) + 1;
+        size_t sets = (size_t)ecx + 1;
+        size_t size = ways * partitions * line_size * sets;
+        if (size > llc) {
+            llc = size;
+        }
+    }
+
+    return llc;
+}
+
+static bool has_clflushopt(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid_max(0, NULL) < 7) {
+        return false;
+    }
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    return (ebx & (1u << 23)) != 0;
+}
+
+static void flush_buffer(const char *start, size_t size, bool use_clflushopt)
+{
+    const char *end = start + size;
+    const char *p = (const char *)((uintptr_t)start & ~(uintptr_t)(CACHE_LINE_SIZE - 1));
+    if (use_clflushopt) {
+        for (; p < end; p += CACHE_LINE_SIZE) {
+            __asm__ volatile("clflushopt %0" :: "m" (*p));
+        }
+    }
+    else {
+        for (; p < end; p += CACHE_LINE_SIZE) {
+            __asm__ volatile("clflush %0" :: "m" (*p));
+        }
+    }
+}
+
+static void touch_buffer(const char *start, size_t size)
+{
+    char sum = 0;
+    for (size_t i = 0; i < size; i += CACHE_LINE_SIZE) {
+        sum += ((const volatile char *)start)[i];
+    }
+    if (size > 0) {
+        sum += ((const volatile char *)start)[size - 1];
+    }
+    cache_sink_ = sum;
+}
+
+static inline uint64_t read_tsc(void)
+{
+    unsigned int high, low;
+    __asm__ volatile("RDTSC" : "=a" (low), "=d" (high));
+    return ((uint64_t)high << 32) | low;
+}
+
+static uint64_t measure_resolution(void)
+{
+    uint64_t resolution = UINT64_MAX;
+    for (size_t i = 0; i < 1024; i++) {
+        uint64_t t0 = read_tsc();
+        uint64_t t1 = read_tsc();
+        while (t1 == t0) {
+            t1 = read_tsc();
+        }
+        if (t1 - t0 < resolution) {
+            resolution = t1 - t0;
+        }
+    }
+    return resolution;
+}
+
+/**
+ * the repetition loop used by testbench_calibrate_denominator() and testbench_measure_kernel()
+ * noinline: calibration and measurement must run exactly the same code
+ */
+static __attribute__((noinline)) void time_kernel_loop(testbench_kernel_function_t kernel, void *context, size_t n,
+                                                       uint64_t *ret_start, uint64_t *ret_stop)
+{
+    uint64_t start = 0;
+    uint64_t stop = 0;
+    RDTSC_START(start);
+    for (size_t i = 0; i < n; i++) {
+        kernel(context);
+    }
+    RDTSC_STOP(stop);
+    *ret_start = start;
+    *ret_stop = stop;
+}
+
+static __attribute__((noinline)) void empty_kernel(void *context)
+{
+    (void)context;
+    __asm__ volatile("" ::: "memory");
+}
+
+/**
+ * minimum of TESTBENCH_CALIBRATION_TRIALS measurements of the repetition loop; baseline subtracted
+ */
+static uint64_t min_kernel_loop_cycles(testbench_kernel_function_t kernel, void *context, size_t n)
+{
+    uint64_t min = UINT64_MAX;
+    for (size_t i = 0; i < TESTBENCH_CALIBRATION_TRIALS; i++) {
+        uint64_t start = 0;
+        uint64_t stop = 0;
+        time_kernel_loop(kernel, context, n, &start, &stop);
+        if (stop - start < min) {
+            min = stop - start;
+        }
+    }
+    return min > baseline_ ? min - baseline_ : 0;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double a2 = *((const double *)a);
+    double b2 = *((const double *)b);
+    if (a2 < b2) {
+        return -1;
+    }
+    if (a2 > b2) {
+        return 1;
+    }
+    return 0;
+}
+
 static int cmp_uint64_t(const void *a, const void *b)
 {
     uint64_t a2 = *((uint64_t *)a);
@@ -170,6 +436,15 @@ static double get_percentile(uint64_t *sorted_values, size_t n_values, double pe
 
 static struct testbench_statistics calc_statistics(uint64_t *values, size_t n_values);
 
+static void trim_values(size_t n);
+
+static void prepare_cache(void);
+
+static size_t attribute_events(const uint64_t *values, size_t n_values, double fence);
+
+static size_t find_modes(const uint64_t *sorted_values, size_t n_values, double sd, double iqr,
+                         struct testbench_modes *ret_modes);
+
 static bool fprint_testbench_statistics_including_outliers(FILE *stream, const char *title,
                                                            const struct testbench_statistics *stat,
                                                            const struct testbench_time_unit *unit,
@@ -182,221 +457,2383 @@ static struct testbench_statistics fprint_histogram_and_remove_outliers(FILE *st
                                                                         bool test_for_outliers,
                                                                         bool *ret_ok);
 
-//--- implementation of the public API -------------------------------------------------------------
-//    see header file for information about the functions
+//--- execution environment ------------------------------------------------------------------------
 
-bool create_testbench(size_t capacity)
+static void append_string(char *buffer, size_t size, const char *separator, const char *text)
 {
-    uint64_t start = 0;
-    uint64_t stop = 0;
+    size_t len = strlen(buffer);
+    if (len > 0 && len < size) {
+        snprintf(buffer + len, size - len, "%s", separator);
+        len = strlen(buffer);
+    }
+    if (len < size) {
+        snprintf(buffer + len, size - len, "%s", text);
+    }
+}
 
-    if (capacity < 1) {
-        goto error_wrong_capacity;
+static void capture_cpuid(struct testbench_environment *env)
+{
+    unsigned int regs[12];
+    unsigned int eax, ebx, ecx, edx;
+
+    snprintf(env->cpu_model, sizeof(env->cpu_model), "unknown");
+    if (__get_cpuid_max(0x80000000, NULL) >= 0x80000004) {
+        for (unsigned int i = 0; i < 3; i++) {
+            __cpuid(0x80000002 + i, regs[4 * i], regs[4 * i + 1], regs[4 * i + 2], regs[4 * i + 3]);
+        }
+        char brand[49];
+        memcpy(brand, regs, 48);
+        brand[48] = '\0';
+        const char *b = brand;
+        while (*b == ' ') {
+            b++;
+        }
+        snprintf(env->cpu_model, sizeof(env->cpu_model), "%s", b);
     }
 
-    if (data_) {
-        delete_testbench();
+    env->cpu_flags[0] = '\0';
+    unsigned int max_leaf = __get_cpuid_max(0, NULL);
+    if (max_leaf >= 1) {
+        __cpuid(1, eax, ebx, ecx, edx);
+        if (edx & (1u << 26)) {
+            append_string(env->cpu_flags, sizeof(env->cpu_flags), " ", "sse2");
+        }
+        if (ecx & (1u << 28)) {
+            append_string(env->cpu_flags, sizeof(env->cpu_flags), " ", "avx");
+        }
+        if (ecx & (1u << 12)) {
+            append_string(env->cpu_flags, sizeof(env->cpu_flags), " ", "fma");
+        }
+        env->hypervisor = (ecx & (1u << 31)) != 0;
     }
+    if (max_leaf >= 7) {
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        if (ebx & (1u << 5)) {
+            append_string(env->cpu_flags, sizeof(env->cpu_flags), " ", "avx2");
+        }
+        if (ebx & (1u << 16)) {
+            append_string(env->cpu_flags, sizeof(env->cpu_flags), " ", "avx512f");
+        }
+        if (ebx & (1u << 30)) {
+            append_string(env->cpu_flags, sizeof(env->cpu_flags), " ", "avx512bw");
+        }
+        if (ecx & (1u << 11)) {
+            append_string(env->cpu_flags, sizeof(env->cpu_flags), " ", "avx512vnni");
+        }
+        if (ebx & (1u << 9)) {
+            append_string(env->cpu_flags, sizeof(env->cpu_flags), " ", "erms");
+        }
+        if (ebx & (1u << 23)) {
+            append_string(env->cpu_flags, sizeof(env->cpu_flags), " ", "clflushopt");
+        }
+    }
+    if (__get_cpuid_max(0x80000000, NULL) >= 0x80000007) {
+        __cpuid(0x80000007, eax, ebx, ecx, edx);
+        if (edx & (1u << 8)) {
+            append_string(env->cpu_flags, sizeof(env->cpu_flags), " ", "invariant_tsc");
+        }
+    }
+    if (env->hypervisor) {
+        append_string(env->cpu_flags, sizeof(env->cpu_flags), " ", "hypervisor");
+    }
+}
 
-    data_ = malloc(capacity * sizeof(*data_));
-    if (!data_) {
-        goto error_malloc_data;
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
+
+/**
+ * TSC frequency measured against the monotonic clock (busy waiting for about 20 ms)
+ */
+static double measure_tsc_ghz(void)
+{
+    double t0 = now_seconds();
+    uint64_t c0 = read_tsc();
+    double t1 = t0;
+    while (t1 - t0 < 0.02) {
+        t1 = now_seconds();
     }
+    uint64_t c1 = read_tsc();
+    return (double)(c1 - c0) / (t1 - t0) * 1e-9;
+}
 
-    data_without_outliers_ = malloc(capacity * sizeof(*data_without_outliers_));
-    if (!data_without_outliers_) {
-        goto error_malloc_data_without_outliers;
+#ifdef __linux__
+
+// perf_event file descriptors for the effective frequency; -1 if not available
+// cycles in user and kernel mode vs. task clock; if counting the kernel is not permitted
+// (perf_event_paranoid), user mode cycles vs. user time of this thread
+static int perf_cycles_fd_ = -1;
+static int perf_task_clock_fd_ = -1;
+static bool perf_cycles_user_only_ = false;
+static uint64_t perf_cycles_start_ = 0;
+static uint64_t perf_task_clock_start_ = 0; // ns; user time if perf_cycles_user_only_
+
+static bool read_file_string(const char *path, char *buffer, size_t size)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        return false;
     }
+    bool ok = fgets(buffer, (int)size, f) != NULL;
+    fclose(f);
+    if (ok) {
+        buffer[strcspn(buffer, "\n")] = '\0';
+    }
+    return ok;
+}
 
-    data_working_temp_ = malloc(capacity * sizeof(*data_working_temp_));
-    if (!data_working_temp_) {
-        goto error_malloc_data_working_temp;
+static long read_file_long(const char *path)
+{
+    char buffer[64];
+    if (!read_file_string(path, buffer, sizeof(buffer))) {
+        return -1;
     }
+    return strtol(buffer, NULL, 10);
+}
 
-    cap_ = capacity;
-    denominator_ = 1;
+static int open_perf_counter(uint32_t type, uint64_t config, bool exclude_kernel)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.exclude_kernel = exclude_kernel ? 1 : 0;
+    attr.exclude_hv = 1;
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
 
-    // establish baseline
-    // have 2 full dry runs of size cap_ (warming up) and then one measurement
-    for (size_t i = 0; i < 3; i++) {
-        for (size_t j = 0; j < cap_; j++) {
-            RDTSC_START(start);
-            // nothing
-            RDTSC_STOP(stop);
-            data_[j] = stop - start;
-        }
+/**
+ * user time of this thread in ns
+ */
+static bool read_user_time(uint64_t *ret_value)
+{
+    struct rusage usage;
+#ifdef RUSAGE_THREAD
+    int ret = getrusage(RUSAGE_THREAD, &usage);
+#else
+    int ret = getrusage(RUSAGE_SELF, &usage);
+#endif
+    if (ret != 0) {
+        return false;
     }
-
-    count_ = cap_;
-    struct testbench_statistics baseline_stat = calc_statistics(data_, count_);
-    print_testbench_statistics("baseline", &baseline_stat, NULL);
-    print_histogram("baseline", &baseline_stat, NULL);
-    baseline_ = baseline_stat.absMin;
-    baseline_backup_ = baseline_;
-    printf("Benchmark library: %" PRIu64 " cycles will be used as baseline.\n", baseline_);
-    count_ = 0;
-    denominator_ = TESTBENCH_STD_DENOMINATOR;
+    *ret_value = (uint64_t)usage.ru_utime.tv_sec * 1000000000ull + (uint64_t)usage.ru_utime.tv_usec * 1000ull;
     return true;
+}
 
-    // error handling
-//error_next:
-    free(data_working_temp_);
-    data_working_temp_ = NULL;
-error_malloc_data_working_temp:
-    free(data_without_outliers_);
-    data_without_outliers_ = NULL;
-error_malloc_data_without_outliers:
-    free(data_);
-    data_ = NULL;
-error_malloc_data:
-error_wrong_capacity:
-    return false;
+static bool read_perf_counter(int fd, uint64_t *ret_value)
+{
+    return fd >= 0 && read(fd, ret_value, sizeof(*ret_value)) == (ssize_t)sizeof(*ret_value);
 }
 
-void set_denominator(size_t denominator)
+static void close_perf_counters(void)
 {
-    if (denominator < 1) {
-        return;
+    if (perf_cycles_fd_ >= 0) {
+        close(perf_cycles_fd_);
+        perf_cycles_fd_ = -1;
+    }
+    if (perf_task_clock_fd_ >= 0) {
+        close(perf_task_clock_fd_);
+        perf_task_clock_fd_ = -1;
     }
+}
 
-    denominator_ = denominator;
+static void open_perf_counters(void)
+{
+    close_perf_counters();
+    // the task clock includes the time in the kernel: thus, cycles of both modes
+    perf_cycles_user_only_ = false;
+    perf_cycles_fd_ = open_perf_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, false);
+    if (perf_cycles_fd_ < 0) {
+        perf_cycles_user_only_ = true;
+        perf_cycles_fd_ = open_perf_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, true);
+    }
+    else {
+        perf_task_clock_fd_ = open_perf_counter(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, false);
+    }
+    bool ok = read_perf_counter(perf_cycles_fd_, &perf_cycles_start_);
+    if (perf_cycles_user_only_) {
+        ok = ok && read_user_time(&perf_task_clock_start_);
+    }
+    else {
+        ok = ok && read_perf_counter(perf_task_clock_fd_, &perf_task_clock_start_);
+    }
+    if (!ok) {
+        close_perf_counters();
+    }
 }
 
-void set_outlier_detection_mode(enum testbench_outlier_detection_mode mode)
+/**
+ * cycles per ns of task clock (user time if only user mode cycles are available) since
+ * open_perf_counters(); -1 if not available
+ */
+static double effective_ghz(void)
 {
-    outlier_detection_mode_ = mode;
+    uint64_t cycles = 0;
+    uint64_t task_clock = 0;
+    if (!read_perf_counter(perf_cycles_fd_, &cycles)) {
+        return -1.0;
+    }
+    bool ok = perf_cycles_user_only_ ? read_user_time(&task_clock)
+                                     : read_perf_counter(perf_task_clock_fd_, &task_clock);
+    if (!ok) {
+        return -1.0;
+    }
+    if (task_clock <= perf_task_clock_start_) {
+        return -1.0;
+    }
+    return (double)(cycles - perf_cycles_start_) / (double)(task_clock - perf_task_clock_start_);
 }
 
-void reset_testbench(void)
+/**
+ * parses a CPU list such as "0,4" or "0-1" of sysfs; returns the number of CPUs stored
+ */
+static size_t parse_cpu_list(const char *list, int *cpus, size_t capacity)
 {
-    count_ = 0;
-    baseline_ = baseline_backup_;
+    size_t n = 0;
+    const char *p = list;
+    while (*p) {
+        char *end = NULL;
+        long first = strtol(p, &end, 10);
+        if (end == p) {
+            break;
+        }
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            p++;
+            last = strtol(p, &end, 10);
+            p = end;
+        }
+        for (long c = first; c <= last && n < capacity; c++) {
+            cpus[n++] = (int)c;
+        }
+        if (*p == ',') {
+            p++;
+        }
+        else {
+            break;
+        }
+    }
+    return n;
 }
 
-void delete_testbench(void)
+/**
+ * reads busy and total jiffies of the given cpu from /proc/stat
+ */
+static bool read_cpu_jiffies(int cpu, uint64_t *ret_busy, uint64_t *ret_total)
 {
-    if (data_working_temp_) {
-        free(data_working_temp_);
-        data_working_temp_ = NULL;
+    FILE *f = fopen("/proc/stat", "r");
+    if (!f) {
+        return false;
     }
 
-    if (data_without_outliers_) {
-        free(data_without_outliers_);
-        data_without_outliers_ = NULL;
+    char line[512];
+    char name[32];
+    snprintf(name, sizeof(name), "cpu%d ", cpu);
+    bool found = false;
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, name, strlen(name)) != 0) {
+            continue;
+        }
+        unsigned long long v[8] = {0};
+        int n = sscanf(line + strlen(name), "%llu %llu %llu %llu %llu %llu %llu %llu",
+                       &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7]);
+        if (n >= 4) {
+            uint64_t total = 0;
+            for (int i = 0; i < n; i++) {
+                total += v[i];
+            }
+            uint64_t idle = v[3] + (n > 4 ? v[4] : 0); // idle + iowait
+            *ret_busy = total - idle;
+            *ret_total = total;
+            found = true;
+        }
+        break;
     }
 
-    if (data_) {
-        free(data_);
-        data_ = NULL;
-        cap_ = 0;
-        count_ = 0;
-        baseline_ = 0;
-        denominator_ = TESTBENCH_STD_DENOMINATOR;
+    fclose(f);
+    return found;
+}
+
+static void capture_linux(struct testbench_environment *env)
+{
+    char path[128];
+    char buffer[256];
+
+    env->cpu = sched_getcpu();
+    int cpu = env->cpu >= 0 ? env->cpu : 0;
+
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/scaling_governor", cpu);
+    if (!read_file_string(path, env->governor, sizeof(env->governor))) {
+        env->governor[0] = '\0';
+    }
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/scaling_min_freq", cpu);
+    env->freq_min_khz = read_file_long(path);
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/scaling_max_freq", cpu);
+    env->freq_max_khz = read_file_long(path);
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/scaling_cur_freq", cpu);
+    env->freq_cur_khz = read_file_long(path);
+
+    long no_turbo = read_file_long("/sys/devices/system/cpu/intel_pstate/no_turbo");
+    long boost = read_file_long("/sys/devices/system/cpu/cpufreq/boost");
+    if (no_turbo >= 0) {
+        env->turbo = no_turbo == 0;
+    }
+    else if (boost >= 0) {
+        env->turbo = boost != 0;
+    }
+
+    if (read_file_string("/proc/loadavg", buffer, sizeof(buffer))) {
+        env->loadavg = strtod(buffer, NULL);
+    }
+
+    // SMT siblings and their load over a short interval
+    int siblings[16];
+    size_t n_siblings = 0;
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", cpu);
+    if (read_file_string(path, buffer, sizeof(buffer))) {
+        int cpus[16];
+        size_t n = parse_cpu_list(buffer, cpus, 16);
+        for (size_t i = 0; i < n; i++) {
+            if (cpus[i] != cpu) {
+                siblings[n_siblings++] = cpus[i];
+            }
+        }
+        env->smt_siblings = (int)n_siblings;
+    }
+
+    if (n_siblings > 0) {
+        uint64_t busy0[16];
+        uint64_t total0[16];
+        bool ok = true;
+        for (size_t i = 0; i < n_siblings; i++) {
+            ok = ok && read_cpu_jiffies(siblings[i], &busy0[i], &total0[i]);
+        }
+        struct timespec pause = { .tv_sec = 0, .tv_nsec = 50 * 1000 * 1000 };
+        nanosleep(&pause, NULL);
+        double load = 0.0;
+        for (size_t i = 0; ok && i < n_siblings; i++) {
+            uint64_t busy1 = 0;
+            uint64_t total1 = 0;
+            ok = read_cpu_jiffies(siblings[i], &busy1, &total1);
+            if (ok && total1 > total0[i]) {
+                load += (double)(busy1 - busy0[i]) / (double)(total1 - total0[i]);
+            }
+        }
+        if (ok) {
+            env->smt_sibling_load = load / (double)n_siblings;
+        }
     }
+
+    open_perf_counters();
 }
 
-void add_measurement(uint64_t start, uint64_t stop)
+#endif // __linux__
+
+static struct testbench_environment environment_;
+static bool environment_capture_ = TESTBENCH_STD_CAPTURE_ENVIRONMENT;
+
+#ifndef TESTBENCH_COMPILER_FLAGS
+#define TESTBENCH_COMPILER_FLAGS "unknown (compile benchmark.c with -DTESTBENCH_COMPILER_FLAGS)"
+#endif
+
+/**
+ * determines the noise reasons; called at capture and for each updated effective frequency
+ */
+static void assess_noise(struct testbench_environment *env)
+{
+    char reason[64];
+    env->noise_reasons[0] = '\0';
+
+    if (env->governor[0] && strcmp(env->governor, "performance") != 0) {
+        snprintf(reason, sizeof(reason), "governor %s", env->governor);
+        append_string(env->noise_reasons, sizeof(env->noise_reasons), ", ", reason);
+    }
+    if (env->turbo == 1) {
+        append_string(env->noise_reasons, sizeof(env->noise_reasons), ", ", "turbo enabled");
+    }
+    if (env->hypervisor) {
+        append_string(env->noise_reasons, sizeof(env->noise_reasons), ", ", "hypervisor");
+    }
+    if (env->smt_sibling_load > TESTBENCH_NOISY_SMT_LOAD) {
+        snprintf(reason, sizeof(reason), "SMT siblings %.0f %% busy", 100.0 * env->smt_sibling_load);
+        append_string(env->noise_reasons, sizeof(env->noise_reasons), ", ", reason);
+    }
+    // the benchmark itself contributes 1.0 to the load average
+    if (env->loadavg - 1.0 > TESTBENCH_NOISY_LOADAVG) {
+        snprintf(reason, sizeof(reason), "load average %.2f", env->loadavg);
+        append_string(env->noise_reasons, sizeof(env->noise_reasons), ", ", reason);
+    }
+    if (env->effective_ghz > 0.0 && env->tsc_ghz > 0.0
+        && fabs(env->effective_ghz - env->tsc_ghz) > TESTBENCH_NOISY_FREQUENCY_DEVIATION * env->tsc_ghz) {
+        snprintf(reason, sizeof(reason), "effective frequency %.2f GHz vs TSC %.2f GHz",
+                 env->effective_ghz, env->tsc_ghz);
+        append_string(env->noise_reasons, sizeof(env->noise_reasons), ", ", reason);
+    }
+
+    env->noisy = env->noise_reasons[0] != '\0';
+}
+
+static void capture_environment(void)
+{
+    struct testbench_environment *env = &environment_;
+    memset(env, 0, sizeof(*env));
+    env->freq_min_khz = -1;
+    env->freq_max_khz = -1;
+    env->freq_cur_khz = -1;
+    env->turbo = -1;
+    env->cpu = -1;
+    env->smt_siblings = -1;
+    env->smt_sibling_load = -1.0;
+    env->loadavg = -1.0;
+    env->effective_ghz = -1.0;
+
+    capture_cpuid(env);
+
+    struct utsname uts;
+    if (uname(&uts) == 0) {
+        snprintf(env->kernel, sizeof(env->kernel), "%s %s %s", uts.sysname, uts.release, uts.machine);
+    }
+    else {
+        snprintf(env->kernel, sizeof(env->kernel), "unknown");
+    }
+
+#if defined(__clang__)
+    snprintf(env->compiler, sizeof(env->compiler), "clang %s", __clang_version__);
+#elif defined(__GNUC__)
+    snprintf(env->compiler, sizeof(env->compiler), "gcc %s", __VERSION__);
+#else
+    snprintf(env->compiler, sizeof(env->compiler), "unknown");
+#endif
+    snprintf(env->compiler_flags, sizeof(env->compiler_flags), "%s", TESTBENCH_COMPILER_FLAGS);
+
+#ifdef __linux__
+    capture_linux(env);
+#endif
+
+    env->tsc_ghz = measure_tsc_ghz();
+#ifdef __linux__
+    // the TSC measurement above was busy waiting: first estimate of the effective frequency
+    env->effective_ghz = effective_ghz();
+#endif
+
+    assess_noise(env);
+    env->captured = true;
+}
+
+void set_environment_capture(bool enabled)
+{
+    environment_capture_ = enabled;
+}
+
+struct testbench_environment testbench_get_environment(void)
+{
+#ifdef __linux__
+    if (environment_.captured) {
+        double ghz = effective_ghz();
+        if (ghz > 0.0) {
+            environment_.effective_ghz = ghz;
+            assess_noise(&environment_);
+        }
+    }
+#endif
+    return environment_;
+}
+
+bool fprint_testbench_environment(FILE *stream, const char *prefix, const struct testbench_environment *env)
+{
+    assert(stream);
+    assert(env);
+    // prefix is optional
+
+    if (!prefix) {
+        prefix = "";
+    }
+
+    if (!env->captured) {
+        return fprintf(stream, "%senvironment: not captured\n", prefix) >= 0;
+    }
+
+    int ret = fprintf(stream, "%senvironment: %s (%s), %s\n", prefix, env->cpu_model, env->cpu_flags, env->kernel);
+    if (ret < 0) {
+        return false;
+    }
+
+    ret = fprintf(stream, "%scompiler:    %s; flags: %s\n", prefix, env->compiler, env->compiler_flags);
+    if (ret < 0) {
+        return false;
+    }
+
+    ret = fprintf(stream, "%sfrequency:   TSC %.3f GHz, effective ", prefix, env->tsc_ghz);
+    if (ret >= 0) {
+        ret = env->effective_ghz > 0.0 ? fprintf(stream, "%.3f GHz", env->effective_ghz) : fprintf(stream, "n/a");
+    }
+    if (ret >= 0 && env->freq_cur_khz >= 0) {
+        ret = fprintf(stream, ", current %.3f GHz [min %.3f, max %.3f]", 1e-6 * (double)env->freq_cur_khz,
+                      1e-6 * (double)env->freq_min_khz, 1e-6 * (double)env->freq_max_khz);
+    }
+    if (ret >= 0) {
+        ret = fprintf(stream, ", governor %s, turbo %s\n", env->governor[0] ? env->governor : "n/a",
+                      env->turbo < 0 ? "n/a" : (env->turbo ? "on" : "off"));
+    }
+    if (ret < 0) {
+        return false;
+    }
+
+    ret = fprintf(stream, "%sload:        cpu %d, ", prefix, env->cpu);
+    if (ret >= 0) {
+        ret = env->smt_siblings < 0 ? fprintf(stream, "SMT siblings n/a")
+                                    : fprintf(stream, "%d SMT sibling(s)", env->smt_siblings);
+    }
+    if (ret >= 0 && env->smt_sibling_load >= 0.0) {
+        ret = fprintf(stream, " %.0f %% busy", 100.0 * env->smt_sibling_load);
+    }
+    if (ret >= 0) {
+        ret = env->loadavg >= 0.0 ? fprintf(stream, ", load average %.2f\n", env->loadavg)
+                                  : fprintf(stream, ", load average n/a\n");
+    }
+    if (ret < 0) {
+        return false;
+    }
+
+    if (env->noisy) {
+        ret = fprintf(stream, "%sWARNING: noisy environment: %s\n", prefix, env->noise_reasons);
+        if (ret < 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//--- buffer allocation ----------------------------------------------------------------------------
+
+#ifdef __linux__
+// huge page sizes in bytes; read at the first allocation; 0 if not read yet
+static size_t hugetlb_page_size_ = 0; // default size of MAP_HUGETLB (Hugepagesize in /proc/meminfo)
+static size_t thp_page_size_ = 0;     // transparent huge pages (PMD size)
+
+static bool is_power_of_2(size_t value)
+{
+    return value > 0 && (value & (value - 1)) == 0;
+}
+
+/**
+ * returns the default size of MAP_HUGETLB; TESTBENCH_HUGE_PAGE_SIZE if not available
+ */
+static size_t hugetlb_page_size(void)
+{
+    if (hugetlb_page_size_ > 0) {
+        return hugetlb_page_size_;
+    }
+
+    size_t size = 0;
+    FILE *f = fopen("/proc/meminfo", "r");
+    if (f) {
+        char line[128];
+        unsigned long kib;
+        while (fgets(line, sizeof(line), f)) {
+            if (sscanf(line, "Hugepagesize: %lu kB", &kib) == 1) {
+                size = (size_t)kib * 1024;
+                break;
+            }
+        }
+        fclose(f);
+    }
+    hugetlb_page_size_ = is_power_of_2(size) ? size : TESTBENCH_HUGE_PAGE_SIZE;
+    return hugetlb_page_size_;
+}
+
+/**
+ * returns the size of transparent huge pages; TESTBENCH_HUGE_PAGE_SIZE if not available
+ */
+static size_t thp_page_size(void)
+{
+    if (thp_page_size_ == 0) {
+        long size = read_file_long("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size");
+        thp_page_size_ = size > 0 && is_power_of_2((size_t)size) ? (size_t)size : TESTBENCH_HUGE_PAGE_SIZE;
+    }
+    return thp_page_size_;
+}
+
+/**
+ * mapped length: a multiple of the MAP_HUGETLB page size for buffers of at least that size
+ * (munmap of huge page mappings); otherwise of the base page size
+ */
+static size_t buffer_length(size_t size)
+{
+    size_t huge = hugetlb_page_size();
+    size_t page = size >= huge ? huge : (size_t)sysconf(_SC_PAGESIZE);
+    return (size + page - 1) / page * page;
+}
+
+/**
+ * anonymous mapping of length (multiple of the base page size) aligned to the size of
+ * transparent huge pages
+ */
+static void *map_aligned(size_t length)
+{
+    const size_t slack = thp_page_size();
+    char *raw = mmap(NULL, length + slack, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+        return MAP_FAILED;
+    }
+
+    char *aligned = (char *)(((uintptr_t)raw + slack - 1) & ~(uintptr_t)(slack - 1));
+    size_t head = (size_t)(aligned - raw);
+    if (head > 0) {
+        munmap(raw, head);
+    }
+    if (slack - head > 0) {
+        munmap(aligned + length, slack - head);
+    }
+    return aligned;
+}
+#endif // __linux__
+
+void *testbench_alloc_buffer(size_t size, unsigned *ret_properties)
+{
+    unsigned properties = 0;
+    if (size == 0) {
+        size = 1;
+    }
+
+#ifdef __linux__
+    const size_t length = buffer_length(size);
+    void *buffer = MAP_FAILED;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    if (length >= hugetlb_page_size()) {
+        buffer = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (buffer != MAP_FAILED) {
+            properties |= TESTBENCH_BUFFER_HUGETLB;
+            page = hugetlb_page_size();
+        }
+    }
+    if (buffer == MAP_FAILED && length >= thp_page_size()) {
+        // no reserved huge pages: transparent huge pages need an aligned mapping
+        buffer = map_aligned(length);
+        if (buffer != MAP_FAILED && madvise(buffer, length, MADV_HUGEPAGE) == 0) {
+            properties |= TESTBENCH_BUFFER_THP_HINT;
+        }
+    }
+    if (buffer == MAP_FAILED) {
+        buffer = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+    if (buffer == MAP_FAILED) {
+        return NULL;
+    }
+
+    // prefault: the zero page would be mapped for reads only
+    for (size_t i = 0; i < length; i += page) {
+        ((volatile char *)buffer)[i] = 0;
+    }
+    properties |= TESTBENCH_BUFFER_PREFAULTED;
+
+    // best effort; limited by RLIMIT_MEMLOCK
+    if (mlock(buffer, length) == 0) {
+        properties |= TESTBENCH_BUFFER_LOCKED;
+    }
+#else
+    void *buffer = calloc(1, size);
+    if (!buffer) {
+        return NULL;
+    }
+    // calloc may return pages that are not mapped yet
+    memset(buffer, 0, size);
+    properties |= TESTBENCH_BUFFER_PREFAULTED;
+#endif
+
+    if (ret_properties) {
+        *ret_properties = properties;
+    }
+    return buffer;
+}
+
+void testbench_free_buffer(void *buffer, size_t size)
+{
+    if (!buffer) {
+        return;
+    }
+
+#ifdef __linux__
+    if (size == 0) {
+        size = 1;
+    }
+    munmap(buffer, buffer_length(size));
+#else
+    (void)size;
+    free(buffer);
+#endif
+}
+
+/**
+ * analysis buffers are allocated at their first use with capacity cap_
+ * returns NULL if out of memory
+ */
+static uint64_t *analysis_buffer(uint64_t **buffer)
+{
+    if (!*buffer) {
+        *buffer = malloc(cap_ * sizeof(**buffer));
+    }
+    return *buffer;
+}
+
+static bool fprint_buffer_properties(FILE *stream, unsigned properties)
+{
+    int ret = fprintf(stream, "%s, %s%s%s", properties & TESTBENCH_BUFFER_PREFAULTED ? "prefaulted" : "not prefaulted",
+                      properties & TESTBENCH_BUFFER_LOCKED ? "locked" : "not locked (RLIMIT_MEMLOCK?)",
+                      properties & TESTBENCH_BUFFER_HUGETLB ? ", huge pages" : "",
+                      properties & TESTBENCH_BUFFER_THP_HINT ? ", transparent huge pages hinted" : "");
+    return ret >= 0;
+}
+
+//--- event accounting -----------------------------------------------------------------------------
+
+#ifdef __linux__
+/**
+ * sums the interrupt counts of all sources for the given cpu (column of /proc/interrupts)
+ */
+static uint64_t read_cpu_interrupts(int cpu, bool *ret_ok)
+{
+    *ret_ok = false;
+    if (cpu < 0) {
+        return 0;
+    }
+
+    FILE *f = fopen("/proc/interrupts", "r");
+    if (!f) {
+        return 0;
+    }
+
+    // header: CPU0 CPU1 ... (offline CPUs are missing)
+    long column = -1;
+    if (getline(&interrupts_line_, &interrupts_line_size_, f) > 0) {
+        long i = 0;
+        for (char *token = strtok(interrupts_line_, " \t\n"); token; token = strtok(NULL, " \t\n"), i++) {
+            if (strncmp(token, "CPU", 3) == 0 && atoi(token + 3) == cpu) {
+                column = i;
+                break;
+            }
+        }
+    }
+
+    uint64_t sum = 0;
+    while (column >= 0 && getline(&interrupts_line_, &interrupts_line_size_, f) > 0) {
+        char *p = strchr(interrupts_line_, ':');
+        if (!p) {
+            continue;
+        }
+        p++;
+        for (long i = 0; i <= column; i++) {
+            char *end = NULL;
+            unsigned long long v = strtoull(p, &end, 10);
+            if (end == p) {
+                break; // e.g. ERR, MIS: single column
+            }
+            if (i == column) {
+                sum += v;
+            }
+            p = end;
+        }
+    }
+
+    fclose(f);
+    *ret_ok = column >= 0;
+    return sum;
+}
+#endif // __linux__
+
+static void take_event_snapshot(struct event_snapshot *snapshot, bool interrupts)
+{
+    struct rusage usage;
+#if defined(__linux__) && defined(RUSAGE_THREAD)
+    int ret = getrusage(RUSAGE_THREAD, &usage);
+#else
+    int ret = getrusage(RUSAGE_SELF, &usage);
+#endif
+    if (ret != 0) {
+        memset(&usage, 0, sizeof(usage));
+    }
+    snapshot->voluntary_switches = (uint64_t)usage.ru_nvcsw;
+    snapshot->involuntary_switches = (uint64_t)usage.ru_nivcsw;
+    snapshot->minor_faults = (uint64_t)usage.ru_minflt;
+    snapshot->major_faults = (uint64_t)usage.ru_majflt;
+
+#ifdef __linux__
+    snapshot->cpu = sched_getcpu();
+    snapshot->interrupts = 0;
+    snapshot->interrupts_available = false;
+    if (interrupts) {
+        snapshot->interrupts = read_cpu_interrupts(snapshot->cpu, &snapshot->interrupts_available);
+    }
+#else
+    (void)interrupts;
+    snapshot->cpu = -1;
+    snapshot->interrupts = 0;
+    snapshot->interrupts_available = false;
+#endif
+}
+
+static void start_event_batch(void)
+{
+    bool sample = event_mode_ == TESTBENCH_EVENTS_SAMPLE;
+    if (!sample && count_ == 0) {
+        take_event_snapshot(&event_series_before_, true);
+        event_series_started_ = true;
+        event_series_closed_ = false;
+        event_series_interrupts_ = 0;
+    }
+    event_batch_first_ = count_;
+    take_event_snapshot(&event_before_, sample);
+}
+
+/**
+ * records the events since the start of the current batch; starts the next batch
+ */
+static void close_event_batch(void)
+{
+    if (!event_records_ || count_ <= event_batch_first_) {
+        return;
+    }
+
+    bool sample = event_mode_ == TESTBENCH_EVENTS_SAMPLE;
+    struct event_snapshot after;
+    take_event_snapshot(&after, sample);
+
+    struct event_record *r = &event_records_[event_records_n_++];
+    r->first = event_batch_first_;
+    r->count = count_ - event_batch_first_;
+    r->voluntary_switches = after.voluntary_switches - event_before_.voluntary_switches;
+    r->involuntary_switches = after.involuntary_switches - event_before_.involuntary_switches;
+    r->minor_faults = after.minor_faults - event_before_.minor_faults;
+    r->major_faults = after.major_faults - event_before_.major_faults;
+    if (after.cpu != event_before_.cpu) {
+        // counts of different CPUs cannot be compared
+        r->interrupts = 0;
+        r->migrations = 1;
+    }
+    else {
+        r->interrupts = after.interrupts - event_before_.interrupts;
+        r->migrations = 0;
+    }
+    if (sample) {
+        event_interrupts_available_ = after.interrupts_available;
+    }
+
+    event_batch_first_ = count_;
+    event_before_ = after;
+}
+
+/**
+ * closes the current batch; BATCH: reads the interrupts of the series (since its start)
+ * called at the end of the measurements, i.e. by the analysis functions; only the first call
+ * after the last measurement reads them
+ */
+static void close_event_series(void)
+{
+    close_event_batch();
+    if (event_mode_ != TESTBENCH_EVENTS_BATCH || !event_series_started_ || event_series_closed_) {
+        return;
+    }
+    event_series_closed_ = true;
+
+    struct event_snapshot after;
+    take_event_snapshot(&after, true);
+    // counts of different CPUs cannot be compared; the migration is counted by the batch
+    event_interrupts_available_ = after.interrupts_available && event_series_before_.interrupts_available
+                                  && after.cpu == event_series_before_.cpu;
+    event_series_interrupts_ = event_interrupts_available_ ? after.interrupts - event_series_before_.interrupts : 0;
+}
+
+static uint64_t record_events(const struct event_record *r)
+{
+    return r->voluntary_switches + r->involuntary_switches + r->minor_faults + r->major_faults +
+           r->interrupts + r->migrations;
+}
+
+static double event_fence(const struct testbench_statistics *stat)
+{
+    return (stat->q3 + TESTBENCH_EVENT_FENCE_IQR * (stat->q3 - stat->q1)) * (double)stat->denominator;
+}
+
+/**
+ * marks the values attributed to the recorded events in event_disturbed_
+ * values must be in order of measurement (data_); fence in raw cycles
+ * see TESTBENCH_EVENTS_* in the header file for the method
+ * returns the number of attributed values
+ */
+static int cmp_uint64_t_descending(const void *a, const void *b)
+{
+    uint64_t a2 = *(const uint64_t *)a;
+    uint64_t b2 = *(const uint64_t *)b;
+    return a2 > b2 ? -1 : (a2 < b2 ? 1 : 0);
+}
+
+/**
+ * marks the largest n_events values above the fence that are not yet attributed
+ * returns the number of marked values
+ */
+static size_t attribute_largest(const uint64_t *values, size_t n_values, double fence, uint64_t n_events)
+{
+    uint64_t *candidates = malloc(n_values * sizeof(*candidates));
+    if (!candidates) {
+        return 0;
+    }
+    size_t n = 0;
+    for (size_t j = 0; j < n_values; j++) {
+        if (!event_disturbed_[j] && (double)values[j] > fence) {
+            candidates[n++] = values[j];
+        }
+    }
+
+    // threshold: the n_events-th largest candidate; ties are marked in order
+    size_t quota = n_events < n ? (size_t)n_events : n;
+    size_t marked = 0;
+    if (quota > 0) {
+        qsort(candidates, n, sizeof(*candidates), cmp_uint64_t_descending);
+        uint64_t threshold = candidates[quota - 1];
+        for (size_t j = 0; j < n_values && marked < quota; j++) {
+            if (!event_disturbed_[j] && values[j] > threshold && (double)values[j] > fence) {
+                event_disturbed_[j] = true;
+                marked++;
+            }
+        }
+        for (size_t j = 0; j < n_values && marked < quota; j++) {
+            if (!event_disturbed_[j] && values[j] == threshold) {
+                event_disturbed_[j] = true;
+                marked++;
+            }
+        }
+    }
+    free(candidates);
+    return marked;
+}
+
+static size_t attribute_events(const uint64_t *values, size_t n_values, double fence)
+{
+    if (!event_disturbed_) {
+        return 0;
+    }
+
+    memset(event_disturbed_, 0, n_values * sizeof(*event_disturbed_));
+    size_t disturbed = 0;
+    for (size_t i = 0; i < event_records_n_; i++) {
+        const struct event_record *r = &event_records_[i];
+        uint64_t events = record_events(r);
+        if (events == 0) {
+            continue;
+        }
+        assert(r->first + r->count <= n_values);
+
+        if (event_mode_ == TESTBENCH_EVENTS_SAMPLE) {
+            for (size_t j = r->first; j < r->first + r->count; j++) {
+                event_disturbed_[j] = true;
+                disturbed++;
+            }
+            continue;
+        }
+
+        // largest values first; batches are small
+        for (uint64_t e = 0; e < events && e < r->count; e++) {
+            size_t max_index = n_values;
+            for (size_t j = r->first; j < r->first + r->count; j++) {
+                if (event_disturbed_[j] || (double)values[j] <= fence) {
+                    continue;
+                }
+                if (max_index == n_values || values[j] > values[max_index]) {
+                    max_index = j;
+                }
+            }
+            if (max_index == n_values) {
+                break;
+            }
+            event_disturbed_[max_index] = true;
+            disturbed++;
+        }
+    }
+
+    // BATCH: interrupts of the whole series, largest values first
+    if (event_mode_ == TESTBENCH_EVENTS_BATCH && event_series_interrupts_ > 0) {
+        disturbed += attribute_largest(values, n_values, fence, event_series_interrupts_);
+    }
+    return disturbed;
+}
+
+static bool alloc_event_records(size_t capacity)
+{
+    // records are written between the measurements
+    event_records_ = testbench_alloc_buffer(capacity * sizeof(*event_records_), NULL);
+    event_disturbed_ = calloc(capacity, sizeof(*event_disturbed_));
+    if (!event_records_ || !event_disturbed_) {
+        testbench_free_buffer(event_records_, capacity * sizeof(*event_records_));
+        free(event_disturbed_);
+        event_records_ = NULL;
+        event_disturbed_ = NULL;
+        return false;
+    }
+    event_records_cap_ = capacity;
+    event_records_n_ = 0;
+    event_batch_first_ = 0;
+    return true;
+}
+
+static void free_event_records(void)
+{
+    testbench_free_buffer(event_records_, event_records_cap_ * sizeof(*event_records_));
+    event_records_ = NULL;
+    event_records_cap_ = 0;
+    free(event_disturbed_);
+    event_disturbed_ = NULL;
+    free(interrupts_line_);
+    interrupts_line_ = NULL;
+    interrupts_line_size_ = 0;
+    event_records_n_ = 0;
+    event_batch_first_ = 0;
+}
+
+static const char *event_mode_name(enum testbench_event_accounting_mode mode)
+{
+    switch (mode) {
+        case TESTBENCH_EVENTS_OFF:
+            return "off";
+        case TESTBENCH_EVENTS_BATCH:
+            return "per batch";
+        case TESTBENCH_EVENTS_SAMPLE:
+            return "per value";
+        default:
+            assert(false);
+            return "";
+    }
+}
+
+bool set_event_accounting(enum testbench_event_accounting_mode mode, size_t batch_size)
+{
+    event_mode_ = mode;
+    if (mode == TESTBENCH_EVENTS_OFF) {
+        free_event_records();
+        return true;
+    }
+
+    event_batch_size_ = mode == TESTBENCH_EVENTS_SAMPLE ? 1 : (batch_size ? batch_size : TESTBENCH_STD_EVENT_BATCH);
+    if (!event_records_ && data_) {
+        if (!alloc_event_records(cap_)) {
+            event_mode_ = TESTBENCH_EVENTS_OFF;
+            return false;
+        }
+    }
+    return true;
+}
+
+struct testbench_events testbench_get_events(void)
+{
+    struct testbench_events result = {0};
+    result.mode = event_mode_;
+    result.batch_size = event_batch_size_;
+    if (event_mode_ == TESTBENCH_EVENTS_OFF || !event_records_) {
+        return result;
+    }
+
+    close_event_series();
+    for (size_t i = 0; i < event_records_n_; i++) {
+        const struct event_record *r = &event_records_[i];
+        result.voluntary_switches += r->voluntary_switches;
+        result.involuntary_switches += r->involuntary_switches;
+        result.minor_faults += r->minor_faults;
+        result.major_faults += r->major_faults;
+        result.interrupts += r->interrupts;
+        result.migrations += r->migrations;
+        if (record_events(r) > 0) {
+            result.disturbed_batches++;
+        }
+    }
+    if (event_mode_ == TESTBENCH_EVENTS_BATCH) {
+        result.interrupts = event_series_interrupts_;
+    }
+    result.batches = event_records_n_;
+    result.interrupts_available = event_interrupts_available_;
+
+    if (!analysis_buffer(&data_working_temp_)) {
+        return result;
+    }
+    memcpy(data_working_temp_, data_, count_ * sizeof(*data_));
+    struct testbench_statistics stat = calc_statistics(data_working_temp_, count_);
+    result.disturbed_values = attribute_events(data_, count_, event_fence(&stat));
+    return result;
+}
+
+bool fprint_testbench_events(FILE *stream, const char *title, const struct testbench_events *events)
+{
+    assert(stream);
+    assert(events);
+    // title is optional
+
+    int ret = 0;
+    if (title) {
+        ret = fprintf(stream, "\n%s:\n", title);
+        if (ret < 0) {
+            return false;
+        }
+    }
+
+    if (events->mode == TESTBENCH_EVENTS_OFF) {
+        return fprintf(stream, "- events:       accounting off\n") >= 0;
+    }
+
+    if (events->mode == TESTBENCH_EVENTS_BATCH) {
+        ret = fprintf(stream, "- accounting:   per batch of %zu values, %zu batches, %zu disturbed\n",
+                      events->batch_size, events->batches, events->disturbed_batches);
+    }
+    else {
+        ret = fprintf(stream, "- accounting:   per value, %zu values, %zu disturbed\n",
+                      events->batches, events->disturbed_batches);
+    }
+    if (ret < 0) {
+        return false;
+    }
+
+    ret = fprintf(stream, "- switches:     %" PRIu64 " voluntary, %" PRIu64 " involuntary\n",
+                  events->voluntary_switches, events->involuntary_switches);
+    if (ret >= 0) {
+        ret = fprintf(stream, "- page faults:  %" PRIu64 " minor, %" PRIu64 " major\n",
+                      events->minor_faults, events->major_faults);
+    }
+    if (ret >= 0) {
+        ret = events->interrupts_available ? fprintf(stream, "- interrupts:   %" PRIu64 "\n", events->interrupts)
+                                           : fprintf(stream, "- interrupts:   n/a\n");
+    }
+    if (ret >= 0) {
+        ret = fprintf(stream, "- migrations:   %" PRIu64 "\n", events->migrations);
+    }
+    if (ret >= 0) {
+        ret = fprintf(stream, "- attributed:   %zu value(s)\n", events->disturbed_values);
+    }
+    return ret >= 0;
+}
+
+//--- implementation of the public API -------------------------------------------------------------
+//    see header file for information about the functions
+
+bool create_testbench(size_t capacity)
+{
+    uint64_t start = 0;
+    uint64_t stop = 0;
+
+    if (capacity < 1) {
+        goto error_wrong_capacity;
+    }
+
+    if (data_) {
+        delete_testbench();
+    }
+
+    // the analysis buffers are allocated at first use
+    data_ = testbench_alloc_buffer(capacity * sizeof(*data_), &data_properties_);
+    if (!data_) {
+        goto error_malloc_data;
+    }
+
+    if (timestamps_enabled_) {
+        timestamps_ = testbench_alloc_buffer(capacity * sizeof(*timestamps_), NULL);
+        if (!timestamps_) {
+            goto error_malloc_timestamps;
+        }
+    }
+
+    if (event_mode_ != TESTBENCH_EVENTS_OFF) {
+        if (!alloc_event_records(capacity)) {
+            goto error_malloc_event_records;
+        }
+    }
+
+    cap_ = capacity;
+    denominator_ = 1;
+
+    // establish baseline
+    // have 2 full dry runs of size cap_ (warming up) and then one measurement
+    for (size_t i = 0; i < 3; i++) {
+        for (size_t j = 0; j < cap_; j++) {
+            RDTSC_START(start);
+            // nothing
+            RDTSC_STOP(stop);
+            data_[j] = stop - start;
+        }
+    }
+
+    count_ = cap_;
+    struct testbench_statistics baseline_stat = calc_statistics(data_, count_);
+    print_testbench_statistics("baseline", &baseline_stat, NULL);
+    print_histogram("baseline", &baseline_stat, NULL);
+    baseline_ = baseline_stat.absMin;
+    baseline_backup_ = baseline_;
+    printf("Benchmark library: %" PRIu64 " cycles will be used as baseline.\n", baseline_);
+    resolution_ = measure_resolution();
+    printf("Benchmark library: timer resolution %" PRIu64 " cycles.\n", resolution_);
+    printf("Benchmark library: value buffer %zu bytes, ", cap_ * sizeof(*data_));
+    fprint_buffer_properties(stdout, data_properties_);
+    printf(".\n");
+    if (environment_capture_) {
+        capture_environment();
+        fprint_testbench_environment(stdout, "Benchmark library: ", &environment_);
+    }
+    count_ = 0;
+    denominator_ = TESTBENCH_STD_DENOMINATOR;
+    loop_overhead_ = 0;
+    denominator_calibrated_ = false;
+    if (event_mode_ != TESTBENCH_EVENTS_OFF) {
+        start_event_batch();
+    }
+    return true;
+
+    // error handling
+//error_next:
+    free_event_records();
+error_malloc_event_records:
+    testbench_free_buffer(timestamps_, capacity * sizeof(*timestamps_));
+    timestamps_ = NULL;
+error_malloc_timestamps:
+    testbench_free_buffer(data_, capacity * sizeof(*data_));
+    data_ = NULL;
+error_malloc_data:
+error_wrong_capacity:
+    return false;
+}
+
+void set_denominator(size_t denominator)
+{
+    if (denominator < 1) {
+        return;
+    }
+
+    denominator_ = denominator;
+    loop_overhead_ = 0;
+    denominator_calibrated_ = false;
+}
+
+size_t testbench_calibrate_denominator(testbench_kernel_function_t kernel, void *context, size_t factor)
+{
+    assert(kernel);
+
+    if (factor == 0) {
+        factor = TESTBENCH_CALIBRATION_STD_FACTOR;
+    }
+
+    uint64_t reference = baseline_ > resolution_ ? baseline_ : resolution_;
+    if (reference == 0) {
+        reference = 1;
+    }
+    const uint64_t threshold = factor * reference;
+
+    // warm up (code and data of the kernel)
+    min_kernel_loop_cycles(kernel, context, 1);
+
+    size_t n = 1;
+    while (n < TESTBENCH_CALIBRATION_MAX_DENOMINATOR) {
+        if (min_kernel_loop_cycles(kernel, context, n) >= threshold) {
+            break;
+        }
+        n <<= 1;
+    }
+
+    denominator_ = n;
+    loop_overhead_ = min_kernel_loop_cycles(empty_kernel, NULL, n);
+    denominator_calibrated_ = true;
+    return n;
+}
+
+bool testbench_measure_kernel(testbench_kernel_function_t kernel, void *context, size_t n)
+{
+    assert(kernel);
+
+    if (n > cap_ - count_) {
+        return false;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        uint64_t start = 0;
+        uint64_t stop = 0;
+        testbench_prepare_cache();
+        time_kernel_loop(kernel, context, denominator_, &start, &stop);
+        add_measurement(start, stop);
+    }
+
+    return true;
+}
+
+void set_outlier_detection_mode(enum testbench_outlier_detection_mode mode)
+{
+    outlier_detection_mode_ = mode;
+}
+
+void set_cache_mode(enum testbench_cache_mode mode)
+{
+    cache_mode_ = mode;
+}
+
+size_t testbench_llc_size(void)
+{
+    size_t llc = detect_llc_size();
+    return llc > 0 ? llc : TESTBENCH_STD_LLC_SIZE;
+}
+
+void set_conditions_note(const char *note, bool keep_on_reset)
+{
+    conditions_note_keep_ = keep_on_reset;
+    if (!note) {
+        conditions_note_[0] = '\0';
+        return;
+    }
+    snprintf(conditions_note_, sizeof(conditions_note_), "%s", note);
+}
+
+bool testbench_declare_buffer(const void *buffer, size_t size)
+{
+    assert(buffer);
+
+    if (cache_buffers_n_ >= TESTBENCH_MAX_CACHE_BUFFERS) {
+        return false;
+    }
+
+    cache_buffers_[cache_buffers_n_].start = buffer;
+    cache_buffers_[cache_buffers_n_].size = size;
+    cache_buffers_n_++;
+    return true;
+}
+
+void testbench_clear_buffers(void)
+{
+    cache_buffers_n_ = 0;
+}
+
+void testbench_prepare_cache(void)
+{
+    values_cache_mode_ = cache_mode_;
+    prepare_cache();
+
+    // the preparation is not accounted
+    if (event_mode_ != TESTBENCH_EVENTS_OFF && count_ == event_batch_first_) {
+        start_event_batch();
+    }
+}
+
+static void prepare_cache(void)
+{
+    static int clflushopt_available = -1;
+
+    switch (cache_mode_) {
+        case TESTBENCH_CACHE_AS_IS:
+            return;
+
+        case TESTBENCH_CACHE_WARM: {
+            for (size_t i = 0; i < cache_buffers_n_; i++) {
+                touch_buffer(cache_buffers_[i].start, cache_buffers_[i].size);
+            }
+            return;
+        }
+
+        case TESTBENCH_CACHE_COLD: {
+            if (!eviction_buffer_) {
+                eviction_size_ = TESTBENCH_EVICTION_FACTOR * testbench_llc_size();
+                eviction_buffer_ = malloc(eviction_size_);
+                if (!eviction_buffer_) {
+                    // flushing the declared buffers is still possible
+                    eviction_size_ = 0;
+                }
+                else {
+                    memset(eviction_buffer_, 1, eviction_size_);
+                }
+            }
+            if (clflushopt_available < 0) {
+                clflushopt_available = has_clflushopt();
+            }
+
+            // 1) sweep: evicts everything else (including code/data of the test not declared)
+            touch_buffer(eviction_buffer_, eviction_size_);
+
+            // 2) flush declared buffers: needed for non-inclusive LLCs
+            for (size_t i = 0; i < cache_buffers_n_; i++) {
+                flush_buffer(cache_buffers_[i].start, cache_buffers_[i].size, clflushopt_available);
+            }
+            __asm__ volatile("mfence" ::: "memory");
+            return;
+        }
+
+        default:
+            assert(false);
+    }
+}
+
+bool set_timestamps(bool enabled)
+{
+    timestamps_enabled_ = enabled;
+    if (!enabled) {
+        testbench_free_buffer(timestamps_, cap_ * sizeof(*timestamps_));
+        timestamps_ = NULL;
+        return true;
+    }
+
+    if (!timestamps_ && data_) {
+        timestamps_ = testbench_alloc_buffer(cap_ * sizeof(*timestamps_), NULL);
+        if (!timestamps_) {
+            timestamps_enabled_ = false;
+            return false;
+        }
+    }
+    return true;
+}
+
+void set_warmup_trimming(bool enabled)
+{
+    warmup_trimming_ = enabled;
+}
+
+void reset_testbench(void)
+{
+    count_ = 0;
+    warmup_trimmed_ = 0;
+    values_cache_mode_ = cache_mode_;
+    baseline_ = baseline_backup_;
+    if (!conditions_note_keep_) {
+        conditions_note_[0] = '\0';
+    }
+    event_records_n_ = 0;
+    if (event_mode_ != TESTBENCH_EVENTS_OFF) {
+        start_event_batch();
+    }
+}
+
+void delete_testbench(void)
+{
+#ifdef __linux__
+    close_perf_counters();
+#endif
+    environment_.captured = false;
+
+    free_event_records();
+
+    if (timestamps_) {
+        testbench_free_buffer(timestamps_, cap_ * sizeof(*timestamps_));
+        timestamps_ = NULL;
+    }
+
+    if (eviction_buffer_) {
+        free(eviction_buffer_);
+        eviction_buffer_ = NULL;
+        eviction_size_ = 0;
+    }
+
+    if (data_working_temp_) {
+        free(data_working_temp_);
+        data_working_temp_ = NULL;
+    }
+
+    if (data_without_outliers_) {
+        free(data_without_outliers_);
+        data_without_outliers_ = NULL;
+    }
+
+    if (data_) {
+        testbench_free_buffer(data_, cap_ * sizeof(*data_));
+        data_ = NULL;
+        data_properties_ = 0;
+        cap_ = 0;
+        count_ = 0;
+        baseline_ = 0;
+        denominator_ = TESTBENCH_STD_DENOMINATOR;
+        loop_overhead_ = 0;
+        denominator_calibrated_ = false;
+    }
+}
+
+void add_measurement(uint64_t start, uint64_t stop)
 {
     // no array index check here
-    uint64_t delta = stop - start - baseline_;
+    uint64_t delta = stop - start - baseline_ - loop_overhead_;
+    if (timestamps_) {
+        timestamps_[count_] = start;
+    }
     data_[count_++] = ((int64_t)delta) < 0 ? 0 : delta;
+    if (event_mode_ != TESTBENCH_EVENTS_OFF) {
+        // the series continues
+        event_series_closed_ = false;
+        if (count_ - event_batch_first_ >= event_batch_size_) {
+            close_event_batch();
+        }
+    }
+}
+
+bool testbench_load_measurements(const uint64_t *start, const uint64_t *stop, size_t n)
+{
+    assert(start);
+    assert(stop);
+
+    if (n > cap_) {
+        return false;
+    }
+
+    enum testbench_event_accounting_mode event_mode = event_mode_;
+    event_mode_ = TESTBENCH_EVENTS_OFF;
+    count_ = 0;
+    warmup_trimmed_ = 0;
+    values_cache_mode_ = cache_mode_;
+    for (size_t i = 0; i < n; i++) {
+        add_measurement(start[i], stop[i]);
+    }
+    event_mode_ = event_mode;
+
+    // no events known for these values
+    event_records_n_ = 0;
+    event_batch_first_ = count_;
+    event_series_started_ = false;
+    event_series_closed_ = false;
+    event_series_interrupts_ = 0;
+    return true;
+}
+
+
+//--- testbench_get_statistics() with associated private function ----------------------------------
+
+/**
+ * calculates the statistics for an array values[] of size n_values
+ * this internal function is used by testbench_get_statistics() and print_histogram()
+ */
+static struct testbench_statistics calc_statistics(uint64_t *values, size_t n_values)
+{
+    // note: min/max deliberately not stored while adding measurements to avoid any
+    // unnecessary cache interruption of the program to be measured
+    struct testbench_statistics result = {0};
+    result.denominator = denominator_;
+    result.baseline = baseline_;
+    result.cache_mode = values_cache_mode_;
+    result.loop_overhead = loop_overhead_;
+    result.denominator_calibrated = denominator_calibrated_;
+    if (n_values == 0) {
+        return result;
+    }
+
+    result.count = n_values;
+
+    // mean, min, max
+    uint64_t sum = 0;
+    uint64_t min = UINT64_MAX;
+    uint64_t max = 0;
+    for (size_t i = 0; i < n_values; i++) {
+        const uint64_t value = values[i];
+        sum += value;
+
+        if (value < min) {
+            min = value;
+        }
+
+        if (value > max) {
+            max = value;
+        }
+    }
+
+    const double mean = (double)sum / ((double)denominator_ * (double)n_values);
+    result.mean = mean;
+    result.absMin = min;
+    result.min = (double)min / (double)denominator_;
+    result.absMax = max;
+    result.max = (double)max / (double)denominator_;
+
+    // robust
+    if (n_values > 1) {
+        qsort(values, n_values, sizeof(*values), cmp_uint64_t);
+        result.median = get_percentile(values, n_values, 0.5, denominator_);
+
+        if (n_values > 3) {
+            // just the bare minimum to work
+            // of course these quartiles will have large 95% confidence intervals by themselves
+            // thus: choose larger n_values for meaningful results, of course
+            result.q1 = get_percentile(values, n_values, 0.25, denominator_);
+            result.q3 = get_percentile(values, n_values, 0.75, denominator_);
+        }
+        else {
+            result.q1 = result.min;
+            result.q3 = result.max;
+        }
+    }
+    else {
+        result.median = result.min;
+        result.q1 = result.min;
+        result.q3 = result.max;
+    }
+
+    // parametric (assuming normal distribution)
+    if (n_values > 1) {
+        // this is just the barely minimum to avoid div/0
+        // of course, one should use a meaningful count / n_values
+        double s2 = 0.0;
+        for (size_t i = 0; i < n_values; i++) {
+            const double delta = (double)values[i] / (double)denominator_ - mean;
+            s2 += delta * delta;
+        }
+
+        s2 = s2 / (double)(n_values - 1);
+        s2 = sqrt(s2);
+        result.sd = s2;
+        double sem = s2 / sqrt((double)n_values);
+
+        double ci95_delta = get_t_value(n_values) * sem;
+        result.ci95_a = mean - ci95_delta;
+        result.ci95_b = mean + ci95_delta;
+    }
+
+    // shape (values are sorted by now)
+    if (n_values >= TESTBENCH_MODE_MIN_N) {
+        struct testbench_modes modes;
+        double d = (double)denominator_;
+        result.modes = find_modes(values, n_values, result.sd * d, (result.q3 - result.q1) * d, &modes);
+    }
+
+    return result;
+}
+
+struct testbench_statistics testbench_get_statistics(void)
+{
+    // note: min/max deliberately not stored while adding measurements to avoid any
+    // unnecessary cache interruption of the program to be measured
+    if (event_mode_ != TESTBENCH_EVENTS_OFF) {
+        close_event_series(); // partial batch at the end
+    }
+
+    // the warmup is trimmed once per measurement series: repeated calls return the same
+    // statistics and do not trim the already trimmed values again
+    struct testbench_steady_state state = testbench_get_steady_state();
+    if (warmup_trimming_ && warmup_trimmed_ == 0 && state.warmup > 0) {
+        trim_values(state.warmup);
+        // no changepoint (0) if the values after the warmup were too few for the test
+        state.changepoint = state.changepoint > state.warmup ? state.changepoint - state.warmup : 0;
+    }
+
+    // data_ is kept in order of measurement; calc_statistics() sorts the values
+    if (!analysis_buffer(&data_working_temp_)) {
+        return calc_statistics(NULL, 0);
+    }
+    memcpy(data_working_temp_, data_, count_ * sizeof(*data_));
+    struct testbench_statistics result = calc_statistics(data_working_temp_, count_);
+    result.warmup = warmup_trimmed_;
+    result.drift = state.drift;
+    result.changepoint = state.changepoint;
+    if (event_mode_ != TESTBENCH_EVENTS_OFF) {
+        result.disturbed = attribute_events(data_, count_, event_fence(&result));
+    }
+    return result;
+}
+
+
+//--- steady state analysis ------------------------------------------------------------------------
+
+struct ranked_value {
+    uint64_t value;
+    size_t index;
+};
+
+static int cmp_ranked_value(const void *a, const void *b)
+{
+    const struct ranked_value *a2 = a;
+    const struct ranked_value *b2 = b;
+    if (a2->value < b2->value) {
+        return -1;
+    }
+    if (a2->value > b2->value) {
+        return 1;
+    }
+    return 0;
+}
+
+static double median_of(const uint64_t *values, size_t n_values, uint64_t *buffer)
+{
+    memcpy(buffer, values, n_values * sizeof(*values));
+    qsort(buffer, n_values, sizeof(*buffer), cmp_uint64_t);
+    if (n_values == 1) {
+        return (double)buffer[0] / (double)denominator_;
+    }
+    return get_percentile(buffer, n_values, 0.5, denominator_);
+}
+
+/**
+ * MSER-5 on batch medians; returns the number of values in the warmup prefix
+ * (0 if the prefix is not slower than the remaining values)
+ */
+static size_t detect_warmup(const uint64_t *values, size_t n_values)
+{
+    size_t m = n_values / TESTBENCH_WARMUP_BATCH;
+    if (n_values < TESTBENCH_STEADY_STATE_MIN_N || m < 2) {
+        return 0;
+    }
+
+    double *batch = malloc(m * sizeof(*batch));
+    if (!batch) {
+        return 0;
+    }
+
+    uint64_t tmp[TESTBENCH_WARMUP_BATCH];
+    for (size_t j = 0; j < m; j++) {
+        batch[j] = median_of(values + j * TESTBENCH_WARMUP_BATCH, TESTBENCH_WARMUP_BATCH, tmp);
+    }
+
+    // suffix sums allow O(m) evaluation of all truncation points
+    double sum = 0.0;
+    double sum2 = 0.0;
+    double best = DBL_MAX;
+    size_t best_d = 0;
+    for (size_t d = m; d-- > 0; ) {
+        sum += batch[d];
+        sum2 += batch[d] * batch[d];
+        if (d > m / 2) {
+            continue;
+        }
+        double k = (double)(m - d);
+        double ss = sum2 - sum * sum / k; // sum of squared deviations from the mean
+        double mser = ss / (k * k);
+        if (mser <= best) {
+            // <= prefers the earlier truncation point in case of ties
+            best = mser;
+            best_d = d;
+        }
+    }
+
+    // a warmup prefix is slower than the steady state; otherwise, it is not
+    // warmup but e.g. drift that is left to detect_drift()
+    bool slower = false;
+    if (best_d > 0) {
+        uint64_t *buffer = malloc(n_values * sizeof(*buffer));
+        if (buffer) {
+            size_t prefix = best_d * TESTBENCH_WARMUP_BATCH;
+            slower = median_of(values, prefix, buffer) > median_of(values + prefix, n_values - prefix, buffer);
+            free(buffer);
+        }
+    }
+
+    free(batch);
+    return slower ? best_d * TESTBENCH_WARMUP_BATCH : 0;
+}
+
+/**
+ * Pettitt's test on values[first..n_values); fills drift related fields of state
+ */
+static void detect_drift(const uint64_t *values, size_t first, size_t n_values, struct testbench_steady_state *state)
+{
+    state->drift = false;
+    state->changepoint = 0;
+    state->changepoint_time = 0;
+    state->p_value = 1.0;
+    state->median_before = 0.0;
+    state->median_after = 0.0;
+
+    size_t n = n_values - first;
+    if (n < TESTBENCH_STEADY_STATE_MIN_N) {
+        return;
+    }
+
+    struct ranked_value *ranked = malloc(n * sizeof(*ranked));
+    double *ranks = malloc(n * sizeof(*ranks));
+    uint64_t *buffer = malloc(n * sizeof(*buffer));
+    if (!ranked || !ranks || !buffer) {
+        free(buffer);
+        free(ranks);
+        free(ranked);
+        return;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        ranked[i].value = values[first + i];
+        ranked[i].index = i;
+    }
+    qsort(ranked, n, sizeof(*ranked), cmp_ranked_value);
+
+    // ranks 1..n; average ranks for ties
+    for (size_t i = 0; i < n; ) {
+        size_t j = i;
+        while (j + 1 < n && ranked[j + 1].value == ranked[i].value) {
+            j++;
+        }
+        double rank = 0.5 * (double)(i + j) + 1.0;
+        for (size_t k = i; k <= j; k++) {
+            ranks[ranked[k].index] = rank;
+        }
+        i = j + 1;
+    }
+
+    // U_k = 2 * sum_{i<=k} r_i - k * (n + 1)
+    double dn = (double)n;
+    double rank_sum = 0.0;
+    double max_u = 0.0;
+    size_t split = 0;
+    for (size_t k = 1; k < n; k++) {
+        rank_sum += ranks[k - 1];
+        double u = fabs(2.0 * rank_sum - (double)k * (dn + 1.0));
+        if (u > max_u) {
+            max_u = u;
+            split = k;
+        }
+    }
+
+    double p = 2.0 * exp(-6.0 * max_u * max_u / (dn * dn * dn + dn * dn));
+    state->p_value = p > 1.0 ? 1.0 : p;
+    state->changepoint = first + split;
+    if (timestamps_) {
+        state->changepoint_time = timestamps_[first + split] - timestamps_[0];
+    }
+    state->median_before = median_of(values + first, split, buffer);
+    state->median_after = median_of(values + first + split, n - split, buffer);
+
+    double reference = fmax(state->median_before, state->median_after);
+    double change = reference > 0.0 ? fabs(state->median_after - state->median_before) / reference : 0.0;
+    state->drift = state->p_value < TESTBENCH_DRIFT_P_VALUE && change > TESTBENCH_DRIFT_MIN_CHANGE;
+
+    free(buffer);
+    free(ranks);
+    free(ranked);
+}
+
+struct testbench_steady_state testbench_get_steady_state(void)
+{
+    struct testbench_steady_state state;
+    state.warmup = detect_warmup(data_, count_);
+    state.warmup_trimmed = warmup_trimmed_;
+    detect_drift(data_, state.warmup, count_, &state);
+    return state;
+}
+
+/**
+ * removes the first n values (and timestamps)
+ */
+static void trim_values(size_t n)
+{
+    assert(n <= count_);
+    memmove(data_, data_ + n, (count_ - n) * sizeof(*data_));
+    if (timestamps_) {
+        memmove(timestamps_, timestamps_ + n, (count_ - n) * sizeof(*timestamps_));
+    }
+    count_ -= n;
+    warmup_trimmed_ += n;
+
+    // batches of event accounting: a partially trimmed batch keeps its events
+    size_t kept = 0;
+    for (size_t i = 0; i < event_records_n_; i++) {
+        struct event_record r = event_records_[i];
+        if (r.first + r.count <= n) {
+            continue;
+        }
+        if (r.first < n) {
+            r.count -= n - r.first;
+            r.first = 0;
+        }
+        else {
+            r.first -= n;
+        }
+        event_records_[kept++] = r;
+    }
+    event_records_n_ = kept;
+    event_batch_first_ = event_batch_first_ > n ? event_batch_first_ - n : 0;
+}
+
+bool fprint_testbench_steady_state(FILE *stream, const char *title,
+                                   const struct testbench_steady_state *state,
+                                   const struct testbench_time_unit *unit)
+{
+    assert(stream);
+    assert(state);
+    // title and unit are optional
+
+    int ret = 0;
+    if (title) {
+        ret = fprintf(stream, "\n%s:\n", title);
+        if (ret < 0) {
+            return false;
+        }
+    }
+
+    if (!unit) {
+        unit = &cycles_;
+    }
+    const double cpu = (double)unit->cycles_per_unit;
+
+    ret = fprintf(stream, "- warmup:       %zu value(s) detected, %zu value(s) trimmed\n",
+                  state->warmup, state->warmup_trimmed);
+    if (ret < 0) {
+        return false;
+    }
+
+    if (state->drift) {
+        ret = fprintf(stream, "- drift:        DETECTED at value %zu, median %.1f -> %.1f %s, p=%.2g\n",
+                      state->changepoint, state->median_before / cpu, state->median_after / cpu,
+                      unit->name, state->p_value);
+        if (ret < 0) {
+            return false;
+        }
+        if (state->changepoint_time > 0) {
+            ret = fprintf(stream, "                changepoint %" PRIu64 " cycles after the first measurement\n",
+                          state->changepoint_time);
+        }
+    }
+    else {
+        ret = fprintf(stream, "- drift:        none detected (p=%.2g)\n", state->p_value);
+    }
+    if (ret < 0) {
+        return false;
+    }
+
+    return true;
+}
+
+
+//--- mode detection -------------------------------------------------------------------------------
+
+#define KDE_WINDOW 4.0 // the Gaussian kernel is evaluated within +/- KDE_WINDOW bandwidths
+#define KDE_STEPS 4    // grid points per bandwidth (at most; fewer if the grid is capped)
+#define NO_PEAK SIZE_MAX
+
+/**
+ * number of grid points (multiples of step) within +/- reach of the distinct sorted values;
+ * the grid is sparse: points far from all values are not part of it
+ */
+static size_t kde_grid_size(const double *distinct, size_t n_distinct, double reach, double step)
+{
+    size_t n = 0;
+    int64_t last = INT64_MIN;
+    for (size_t i = 0; i < n_distinct; i++) {
+        int64_t lo = (int64_t)floor((distinct[i] - reach) / step);
+        int64_t hi = (int64_t)ceil((distinct[i] + reach) / step);
+        if (lo <= last) {
+            lo = last + 1;
+        }
+        if (hi >= lo) {
+            n += (size_t)(hi - lo + 1);
+            last = hi;
+        }
+    }
+    return n;
+}
+
+/**
+ * builds the grid of kde_grid_size() (grid[] in units of step, ascending) and distributes the
+ * counts of the values linearly to their 2 neighbouring grid points (weight[])
+ * reach >= step is needed: both neighbours are then part of the grid
+ */
+static void kde_grid_fill(const double *distinct, const size_t *counts, size_t n_distinct, double reach,
+                          double step, int64_t *grid, double *weight)
+{
+    size_t n = 0;
+    int64_t last = INT64_MIN;
+    for (size_t i = 0; i < n_distinct; i++) {
+        int64_t lo = (int64_t)floor((distinct[i] - reach) / step);
+        int64_t hi = (int64_t)ceil((distinct[i] + reach) / step);
+        for (int64_t m = lo > last ? lo : last + 1; m <= hi; m++) {
+            grid[n] = m;
+            weight[n] = 0.0;
+            n++;
+        }
+        last = hi > last ? hi : last;
+
+        // grid points lo ... last are consecutive in the arrays; last is at n - 1
+        double u = distinct[i] / step;
+        int64_t m0 = (int64_t)floor(u);
+        double frac = u - (double)m0;
+        size_t i0 = n - 1 - (size_t)(last - m0);
+        weight[i0] += (double)counts[i] * (1.0 - frac);
+        weight[i0 + 1] += (double)counts[i] * frac;
+    }
+}
+
+/**
+ * pair of neighbouring peaks (left and its next); entries are invalid once the pair changed
+ */
+struct peak_pair {
+    double ratio;  // valley density / density of the smaller peak
+    size_t left;
+    size_t stamp;  // of left at the time of the entry
+};
+
+// the shallowest valley first; on ties, the leftmost pair
+static bool peak_pair_before(const struct peak_pair *a, const struct peak_pair *b)
+{
+    return a->ratio > b->ratio || (a->ratio == b->ratio && a->left < b->left);
+}
+
+static void peak_heap_push(struct peak_pair *heap, size_t *n, struct peak_pair pair)
+{
+    size_t i = (*n)++;
+    while (i > 0 && peak_pair_before(&pair, &heap[(i - 1) / 2])) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i] = pair;
+}
+
+static struct peak_pair peak_heap_pop(struct peak_pair *heap, size_t *n)
+{
+    struct peak_pair top = heap[0];
+    struct peak_pair last = heap[--(*n)];
+    size_t i = 0;
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= *n) {
+            break;
+        }
+        if (child + 1 < *n && peak_pair_before(&heap[child + 1], &heap[child])) {
+            child++;
+        }
+        if (!peak_pair_before(&heap[child], &last)) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    if (*n > 0) {
+        heap[i] = last;
+    }
+    return top;
 }
 
-
-//--- testbench_get_statistics() with associated private function ----------------------------------
-
 /**
- * calculates the statistics for an array values[] of size n_values
- * this internal function is used by testbench_get_statistics() and print_histogram()
+ * see header file for the method
+ * sd and iqr are used for the bandwidth (raw values, i.e. not divided by the denominator)
+ * returns the number of reported modes; ret_modes is filled with locations etc. divided by the denominator
+ * O(n log n): the grid is capped at TESTBENCH_MODE_MAX_POINTS; the peaks are merged with a heap
+ * of the neighbouring pairs, and only the neighbours of a merged pair are updated
  */
-static struct testbench_statistics calc_statistics(uint64_t *values, size_t n_values)
+static size_t find_modes(const uint64_t *sorted_values, size_t n_values, double sd, double iqr,
+                         struct testbench_modes *ret_modes)
 {
-    // note: min/max deliberately not stored while adding measurements to avoid any
-    // unnecessary cache interruption of the program to be measured
-    struct testbench_statistics result = {0, 0, 0, 0, 0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
-    result.denominator = denominator_;
-    result.baseline = baseline_;
-    if (n_values == 0) {
-        return result;
+    ret_modes->n_modes = 0;
+    if (n_values < TESTBENCH_MODE_MIN_N) {
+        return 0;
     }
 
-    result.count = n_values;
+    const double denominator = (double)denominator_;
 
-    // mean, min, max
-    uint64_t sum = 0;
-    uint64_t min = UINT64_MAX;
-    uint64_t max = 0;
+    // bandwidth (Silverman's rule of thumb); all values (almost) identical -> one mode
+    double spread = iqr / 1.34;
+    if (spread <= 0.0 || (sd > 0.0 && sd < spread)) {
+        spread = sd;
+    }
+    double h = 0.9 * spread * pow((double)n_values, -0.2);
+    if (h < 0.5) {
+        // raw values are integers
+        h = 0.5;
+    }
+
+    // distinct values and counts
+    double *distinct = malloc(n_values * sizeof(*distinct));
+    size_t *counts = malloc(n_values * sizeof(*counts));
+    if (!distinct || !counts) {
+        free(counts);
+        free(distinct);
+        return 0;
+    }
+
+    size_t n_distinct = 0;
     for (size_t i = 0; i < n_values; i++) {
-        const uint64_t value = values[i];
-        sum += value;
+        double v = (double)sorted_values[i];
+        if (n_distinct > 0 && distinct[n_distinct - 1] == v) {
+            counts[n_distinct - 1]++;
+        }
+        else {
+            distinct[n_distinct] = v;
+            counts[n_distinct] = 1;
+            n_distinct++;
+        }
+    }
 
-        if (value < min) {
-            min = value;
+    // the bandwidth must not be below the granularity of the values (median gap between
+    // distinct values); otherwise, e.g. values measured in steps of 2 cycles look multimodal
+    if (n_distinct > 2) {
+        double *gaps = malloc((n_distinct - 1) * sizeof(*gaps));
+        if (!gaps) {
+            free(counts);
+            free(distinct);
+            return 0;
+        }
+        for (size_t i = 1; i < n_distinct; i++) {
+            gaps[i - 1] = distinct[i] - distinct[i - 1];
         }
+        qsort(gaps, n_distinct - 1, sizeof(*gaps), cmp_double);
+        double granularity = gaps[(n_distinct - 1) / 2];
+        free(gaps);
+        if (h < granularity) {
+            h = granularity;
+        }
+    }
 
-        if (value > max) {
-            max = value;
+    // grid of KDE_STEPS points per bandwidth near the values; coarser if it would exceed
+    // TESTBENCH_MODE_MAX_POINTS (the bandwidth is then at least one step)
+    double step = h / KDE_STEPS;
+    size_t n_points = kde_grid_size(distinct, n_distinct, KDE_WINDOW * h, step);
+    while (n_points > TESTBENCH_MODE_MAX_POINTS) {
+        step *= 2.0;
+        n_points = kde_grid_size(distinct, n_distinct, KDE_WINDOW * fmax(h, step), step);
+    }
+    h = fmax(h, step);
+    double reach = KDE_WINDOW * h;
+
+    int64_t *grid = malloc(n_points * sizeof(*grid));
+    double *weight = malloc(n_points * sizeof(*weight));
+    double *density = malloc(n_points * sizeof(*density));
+    size_t *peaks = malloc(n_points * sizeof(*peaks));
+    if (!grid || !weight || !density || !peaks) {
+        free(peaks);
+        free(density);
+        free(weight);
+        free(grid);
+        free(counts);
+        free(distinct);
+        return 0;
+    }
+    kde_grid_fill(distinct, counts, n_distinct, reach, step, grid, weight);
+    free(counts);
+    free(distinct);
+
+    // kernel density estimate (unnormalized) at the grid points; the kernel as a table
+    int64_t k_max = (int64_t)(reach / step);
+    double kernel[(size_t)(KDE_WINDOW * KDE_STEPS) + 1];
+    for (int64_t d = 0; d <= k_max; d++) {
+        double u = (double)d * step / h;
+        kernel[d] = exp(-0.5 * u * u);
+    }
+    for (size_t i = 0; i < n_points; i++) {
+        double sum = weight[i];
+        for (size_t j = i; j > 0 && grid[i] - grid[j - 1] <= k_max; j--) {
+            sum += weight[j - 1] * kernel[grid[i] - grid[j - 1]];
+        }
+        for (size_t j = i + 1; j < n_points && grid[j] - grid[i] <= k_max; j++) {
+            sum += weight[j] * kernel[grid[j] - grid[i]];
+        }
+        density[i] = sum;
+    }
+    free(weight);
+
+    // local maxima; plateaus are counted once (strict on the left side)
+    size_t n_peaks = 0;
+    for (size_t i = 0; i < n_points; i++) {
+        bool left = i == 0 || density[i] > density[i - 1];
+        bool right = i == n_points - 1 || density[i] >= density[i + 1];
+        if (left && right) {
+            peaks[n_peaks++] = i;
         }
     }
 
-    const double mean = (double)sum / ((double)denominator_ * (double)n_values);
-    result.mean = mean;
-    result.absMin = min;
-    result.min = (double)min / (double)denominator_;
-    result.absMax = max;
-    result.max = (double)max / (double)denominator_;
+    // merge neighbouring peaks with shallow valleys, the shallowest valley first;
+    // list of the peaks with the valley (density minimum) to the next one
+    size_t *prev = malloc(n_peaks * sizeof(*prev));
+    size_t *next = malloc(n_peaks * sizeof(*next));
+    size_t *stamp = malloc(n_peaks * sizeof(*stamp));
+    double *valley = malloc(n_peaks * sizeof(*valley));
+    struct peak_pair *heap = malloc(2 * n_peaks * sizeof(*heap));
+    if (!prev || !next || !stamp || !valley || !heap) {
+        free(heap);
+        free(valley);
+        free(stamp);
+        free(next);
+        free(prev);
+        free(peaks);
+        free(density);
+        free(grid);
+        return 0;
+    }
+    size_t n_heap = 0;
+    for (size_t k = 0; k < n_peaks; k++) {
+        // stamp: counts the changes of the pair (k, next[k]); SIZE_MAX for removed peaks
+        prev[k] = k > 0 ? k - 1 : NO_PEAK;
+        next[k] = k + 1 < n_peaks ? k + 1 : NO_PEAK;
+        stamp[k] = 0;
+        if (k + 1 < n_peaks) {
+            valley[k] = density[peaks[k]];
+            for (size_t i = peaks[k]; i <= peaks[k + 1]; i++) {
+                valley[k] = fmin(valley[k], density[i]);
+            }
+            struct peak_pair pair = {valley[k] / fmin(density[peaks[k]], density[peaks[k + 1]]), k, 0};
+            peak_heap_push(heap, &n_heap, pair);
+        }
+    }
 
-    // robust
-    if (n_values > 1) {
-        qsort(values, n_values, sizeof(*values), cmp_uint64_t);
-        result.median = get_percentile(values, n_values, 0.5, denominator_);
+    while (n_heap > 0) {
+        struct peak_pair pair = peak_heap_pop(heap, &n_heap);
+        size_t k = pair.left;
+        if (stamp[k] != pair.stamp || next[k] == NO_PEAK) {
+            continue;
+        }
+        if (pair.ratio <= TESTBENCH_MODE_MAX_VALLEY_RATIO) {
+            break;
+        }
 
-        if (n_values > 3) {
-            // just the bare minimum to work
-            // of course these quartiles will have large 95% confidence intervals by themselves
-            // thus: choose larger n_values for meaningful results, of course
-            result.q1 = get_percentile(values, n_values, 0.25, denominator_);
-            result.q3 = get_percentile(values, n_values, 0.75, denominator_);
+        // remove the smaller peak of the pair; the valley of the new pair is the lower one
+        size_t n = next[k];
+        size_t keep = k;
+        if (density[peaks[k]] < density[peaks[n]]) {
+            keep = prev[k];
+            if (keep != NO_PEAK) {
+                valley[keep] = fmin(valley[keep], valley[k]);
+                next[keep] = n;
+            }
+            prev[n] = keep;
+            stamp[k] = SIZE_MAX;
         }
         else {
-            result.q1 = result.min;
-            result.q3 = result.max;
+            valley[k] = fmin(valley[k], valley[n]);
+            next[k] = next[n];
+            if (next[n] != NO_PEAK) {
+                prev[next[n]] = k;
+            }
+            stamp[n] = SIZE_MAX;
+        }
+        if (keep != NO_PEAK && next[keep] != NO_PEAK) {
+            stamp[keep]++;
+            struct peak_pair merged = {valley[keep] / fmin(density[peaks[keep]], density[peaks[next[keep]]]),
+                                       keep, stamp[keep]};
+            peak_heap_push(heap, &n_heap, merged);
         }
     }
-    else {
-        result.median = result.min;
-        result.q1 = result.min;
-        result.q3 = result.max;
+
+    // remaining peaks in order
+    size_t n_kept = 0;
+    for (size_t k = 0; k < n_peaks; k++) {
+        if (stamp[k] != SIZE_MAX) {
+            peaks[n_kept++] = peaks[k];
+        }
     }
+    n_peaks = n_kept;
+    free(heap);
+    free(valley);
+    free(stamp);
+    free(next);
+    free(prev);
+
+    // assign values to modes: split at the valley (density minimum) between neighbouring peaks
+    size_t first = 0;
+    for (size_t k = 0; k < n_peaks; k++) {
+        size_t end = n_values;
+        if (k + 1 < n_peaks) {
+            size_t v = peaks[k];
+            for (size_t i = peaks[k]; i <= peaks[k + 1]; i++) {
+                if (density[i] < density[v]) {
+                    v = i;
+                }
+            }
+            double split = (double)grid[v] * step;
+            end = first;
+            while (end < n_values && (double)sorted_values[end] <= split) {
+                end++;
+            }
+        }
 
-    // parametric (assuming normal distribution)
-    if (n_values > 1) {
-        // this is just the barely minimum to avoid div/0
-        // of course, one should use a meaningful count / n_values
-        double s2 = 0.0;
-        for (size_t i = 0; i < n_values; i++) {
-            const double delta = (double)values[i] / (double)denominator_ - mean;
-            s2 += delta * delta;
+        size_t count = end - first;
+        double weight = (double)count / (double)n_values;
+        if (count > 0 && weight >= TESTBENCH_MODE_MIN_WEIGHT && ret_modes->n_modes < TESTBENCH_MAX_MODES) {
+            const uint64_t *part = sorted_values + first;
+            struct testbench_mode *mode = &ret_modes->modes[ret_modes->n_modes++];
+            mode->count = count;
+            mode->weight = weight;
+            if (count > 1) {
+                mode->location = get_percentile((uint64_t *)part, count, 0.5, denominator_);
+            }
+            else {
+                mode->location = (double)part[0] / denominator;
+            }
+            if (count > 3) {
+                mode->spread = get_percentile((uint64_t *)part, count, 0.75, denominator_)
+                               - get_percentile((uint64_t *)part, count, 0.25, denominator_);
+            }
+            else {
+                mode->spread = (double)(part[count - 1] - part[0]) / denominator;
+            }
         }
+        first = end;
+    }
 
-        s2 = s2 / (double)(n_values - 1);
-        s2 = sqrt(s2);
-        result.sd = s2;
-        double sem = s2 / sqrt((double)n_values);
+    free(peaks);
+    free(density);
+    free(grid);
+    return ret_modes->n_modes;
+}
 
-        double ci95_delta = get_t_value(n_values) * sem;
-        result.ci95_a = mean - ci95_delta;
-        result.ci95_b = mean + ci95_delta;
+/**
+ * copies the values into data_working_temp_ for sorting; data is not modified
+ */
+static void compute_modes(const uint64_t *values, size_t n_values, const struct testbench_statistics *stat,
+                          struct testbench_modes *ret_modes)
+{
+    if (!analysis_buffer(&data_working_temp_)) {
+        ret_modes->n_modes = 0;
+        return;
+    }
+    memcpy(data_working_temp_, values, n_values * sizeof(*values));
+    qsort(data_working_temp_, n_values, sizeof(*data_working_temp_), cmp_uint64_t);
+    double d = (double)denominator_;
+    find_modes(data_working_temp_, n_values, stat->sd * d, (stat->q3 - stat->q1) * d, ret_modes);
+}
+
+struct testbench_modes testbench_get_modes(void)
+{
+    struct testbench_modes result;
+    result.n_modes = 0;
+    if (count_ < TESTBENCH_MODE_MIN_N) {
+        return result;
     }
 
+    // calc_statistics() sorts the values; thus, use a copy to keep data_ unmodified
+    if (!analysis_buffer(&data_working_temp_)) {
+        return result;
+    }
+    memcpy(data_working_temp_, data_, count_ * sizeof(*data_));
+    struct testbench_statistics stat = calc_statistics(data_working_temp_, count_);
+    compute_modes(data_, count_, &stat, &result);
     return result;
 }
 
-struct testbench_statistics testbench_get_statistics(void)
+bool fprint_testbench_modes(FILE *stream, const char *title,
+                            const struct testbench_modes *modes,
+                            const struct testbench_time_unit *unit)
 {
-    // note: min/max deliberately not stored while adding measurements to avoid any
-    // unnecessary cache interruption of the program to be measured
-    return calc_statistics(data_, count_);
+    assert(stream);
+    assert(modes);
+    // title and unit are optional
+
+    int ret = 0;
+    if (title) {
+        ret = fprintf(stream, "\n%s:\n", title);
+        if (ret < 0) {
+            return false;
+        }
+    }
+
+    if (!unit) {
+        unit = &cycles_;
+    }
+    const double cpu = (double)unit->cycles_per_unit;
+
+    if (modes->n_modes == 0) {
+        ret = fprintf(stream, "- modes:        not detected; use n >= %d\n", TESTBENCH_MODE_MIN_N);
+        return ret >= 0;
+    }
+
+    if (modes->n_modes > 1) {
+        ret = fprintf(stream, "- modes:        %zu modes: MULTIMODAL; comparing medians or means can be misleading\n",
+                      modes->n_modes);
+    }
+    else {
+        ret = fprintf(stream, "- modes:        1 mode (unimodal)\n");
+    }
+    if (ret < 0) {
+        return false;
+    }
+
+    for (size_t i = 0; i < modes->n_modes; i++) {
+        const struct testbench_mode *m = &modes->modes[i];
+        ret = fprintf(stream, "  mode %zu: %.1f %s, IQR %.1f, weight %.1f %% (n=%zu)\n",
+                      i + 1, m->location / cpu, unit->name, m->spread / cpu, 100.0 * m->weight, m->count);
+        if (ret < 0) {
+            return false;
+        }
+    }
+
+    return true;
 }
 
 
@@ -413,6 +2850,39 @@ bool fprint_testbench_values(FILE *stream, const char *title, const struct testb
         return false;
     }
 
+    ret = fprintf(stream, "# cache: %s\n", cache_mode_name(values_cache_mode_));
+    if (ret < 0) {
+        return false;
+    }
+
+    if (conditions_note_[0]) {
+        ret = fprintf(stream, "# conditions: %s\n", conditions_note_);
+        if (ret < 0) {
+            return false;
+        }
+    }
+
+    if (environment_.captured) {
+        struct testbench_environment env = testbench_get_environment();
+        if (!fprint_testbench_environment(stream, "# ", &env)) {
+            return false;
+        }
+    }
+
+    if (warmup_trimmed_ > 0) {
+        ret = fprintf(stream, "# warmup: %zu value(s) trimmed\n", warmup_trimmed_);
+        if (ret < 0) {
+            return false;
+        }
+    }
+
+    if (timestamps_) {
+        ret = fprintf(stream, "# columns: value, start time (cycles since the first measurement)\n");
+        if (ret < 0) {
+            return false;
+        }
+    }
+
     if (unit) {
         ret = fprintf(stream, "# unit: %s with %" PRIu64 " cycles / unit\n", unit->name, unit->cycles_per_unit);
         if (ret < 0) {
@@ -422,7 +2892,17 @@ bool fprint_testbench_values(FILE *stream, const char *title, const struct testb
         const double cpu = unit->cycles_per_unit;
         for (size_t i = 0; i < count_; i++) {
             const double value = (double)data_[i] / cpu;
-            ret = fprintf(stream, "%f\n", value);
+            ret = fprintf(stream, "%f", value);
+            if (ret < 0) {
+                return false;
+            }
+            if (timestamps_) {
+                ret = fprintf(stream, "\t%" PRIu64, timestamps_[i] - timestamps_[0]);
+                if (ret < 0) {
+                    return false;
+                }
+            }
+            ret = fprintf(stream, "\n");
             if (ret < 0) {
                 return false;
             }
@@ -435,7 +2915,17 @@ bool fprint_testbench_values(FILE *stream, const char *title, const struct testb
         }
 
         for (size_t i = 0; i < count_; i++) {
-            ret = fprintf(stream, "%" PRIu64 "\n", data_[i]);
+            ret = fprintf(stream, "%" PRIu64, data_[i]);
+            if (ret < 0) {
+                return false;
+            }
+            if (timestamps_) {
+                ret = fprintf(stream, "\t%" PRIu64, timestamps_[i] - timestamps_[0]);
+                if (ret < 0) {
+                    return false;
+                }
+            }
+            ret = fprintf(stream, "\n");
             if (ret < 0) {
                 return false;
             }
@@ -468,9 +2958,103 @@ static struct testbench_statistics convert_stats(const struct testbench_statisti
     s.sd = stat->sd / cpu_d;
     s.ci95_a = stat->ci95_a / cpu_d;
     s.ci95_b = stat->ci95_b / cpu_d;
+    s.modes = stat->modes;
+    s.warmup = stat->warmup;
+    s.drift = stat->drift;
+    s.changepoint = stat->changepoint;
+    s.cache_mode = stat->cache_mode;
+    s.loop_overhead = stat->loop_overhead / cpu_i;
+    s.denominator_calibrated = stat->denominator_calibrated;
     return s;
 }
 
+/**
+ * prints the conditions under which the measurements were taken, and warnings
+ * (shared by both statistics printing functions)
+ */
+static bool fprint_notes(FILE *stream, const struct testbench_statistics *stat)
+{
+    int ret = fprintf(stream, "- conditions:   cache %s", cache_mode_name(stat->cache_mode));
+    if (ret < 0) {
+        return false;
+    }
+
+    if (stat->denominator_calibrated) {
+        ret = fprintf(stream, ", denominator %zu auto-calibrated, loop overhead %" PRIu64 " cycles subtracted",
+                      stat->denominator, stat->loop_overhead);
+        if (ret < 0) {
+            return false;
+        }
+    }
+
+    if (conditions_note_[0]) {
+        ret = fprintf(stream, ", %s", conditions_note_);
+        if (ret < 0) {
+            return false;
+        }
+    }
+
+    ret = fprintf(stream, "\n");
+    if (ret < 0) {
+        return false;
+    }
+
+    if (environment_.captured) {
+        struct testbench_environment env = testbench_get_environment();
+        ret = fprintf(stream, "- environment:  %s, TSC %.2f GHz, effective ", env.cpu_model, env.tsc_ghz);
+        if (ret >= 0) {
+            ret = env.effective_ghz > 0.0 ? fprintf(stream, "%.2f GHz", env.effective_ghz) : fprintf(stream, "n/a");
+        }
+        if (ret >= 0) {
+            ret = fprintf(stream, ", governor %s, turbo %s\n", env.governor[0] ? env.governor : "n/a",
+                          env.turbo < 0 ? "n/a" : (env.turbo ? "on" : "off"));
+        }
+        if (ret < 0) {
+            return false;
+        }
+
+        if (env.noisy) {
+            ret = fprintf(stream, "- WARNING:      noisy environment: %s\n", env.noise_reasons);
+            if (ret < 0) {
+                return false;
+            }
+        }
+    }
+
+    if (event_mode_ != TESTBENCH_EVENTS_OFF) {
+        ret = fprintf(stream, "- events:       %zu value(s) attributed to context switches, page faults, interrupts "
+                      "or migrations (accounting %s)\n", stat->disturbed, event_mode_name(event_mode_));
+        if (ret < 0) {
+            return false;
+        }
+    }
+
+    if (stat->warmup > 0) {
+        ret = fprintf(stream, "- steady state: %zu warmup value(s) trimmed\n", stat->warmup);
+        if (ret < 0) {
+            return false;
+        }
+    }
+
+    if (stat->drift) {
+        ret = fprintf(stream, "- WARNING:      drift during the run (changepoint at value %zu); see testbench_get_steady_state()\n",
+                      stat->changepoint);
+        if (ret < 0) {
+            return false;
+        }
+    }
+
+    if (stat->modes > 1) {
+        ret = fprintf(stream, "- WARNING:      multimodal distribution (%zu modes); compare the modes, not medians or means\n",
+                      stat->modes);
+        if (ret < 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 static bool fprint_testbench_statistics_including_outliers(FILE *stream, const char *title,
                                                            const struct testbench_statistics *stat,
                                                            const struct testbench_time_unit *unit,
@@ -517,7 +3101,7 @@ static bool fprint_testbench_statistics_including_outliers(FILE *stream, const c
         }
     }
 
-    return true;
+    return fprint_notes(stream, stat);
 }
 
 bool fprint_testbench_statistics(FILE *stream, const char *title,
@@ -569,7 +3153,7 @@ bool fprint_testbench_statistics(FILE *stream, const char *title,
         }
     }
 
-    return true;
+    return fprint_notes(stream, stat);
 }
 
 
@@ -668,6 +3252,14 @@ static struct testbench_statistics fprint_histogram_and_remove_outliers(FILE *st
         }
     }
 
+    if (stat->modes > 1) {
+        struct testbench_modes modes;
+        compute_modes(values, n_values, stat, &modes);
+        if (!fprint_testbench_modes(stream, NULL, &modes, unit)) {
+            goto fprintf_error_return;
+        }
+    }
+
     if (outlier_detection_mode_ == TESTBENCH_OUTLIER_DETECTION_OFF) {
         return *stat;
     }
@@ -677,6 +3269,9 @@ static struct testbench_statistics fprint_histogram_and_remove_outliers(FILE *st
     }
 
     // start outlier detection
+    if (!analysis_buffer(&data_without_outliers_) || !analysis_buffer(&data_working_temp_)) {
+        return *stat;
+    }
     size_t count_without_outliers = 0;
 
     if (outlier_detection_mode_ == TESTBENCH_OUTLIER_DETECTION_SD) {
@@ -753,6 +3348,19 @@ static struct testbench_statistics fprint_histogram_and_remove_outliers(FILE *st
             }
         }
     }
+    else if (outlier_detection_mode_ == TESTBENCH_OUTLIER_DETECTION_EVENTS) {
+        // evidence is only available for the stored values in order of measurement
+        if (event_mode_ == TESTBENCH_EVENTS_OFF || values != data_ || n_values != count_) {
+            return *stat;
+        }
+
+        attribute_events(values, n_values, event_fence(stat));
+        for (size_t i = 0; i < n_values; i++) {
+            if (!event_disturbed_[i]) {
+                data_without_outliers_[count_without_outliers++] = values[i];
+            }
+        }
+    }
     else {
         assert(false);
     }
@@ -779,6 +3387,14 @@ static struct testbench_statistics fprint_histogram_and_remove_outliers(FILE *st
             break;
         }
 
+        case TESTBENCH_OUTLIER_DETECTION_EVENTS: {
+            ret = fprintf(stream, "events, %s):", event_mode_name(event_mode_));
+            if (ret < 0) {
+                goto fprintf_error_return;
+            }
+            break;
+        }
+
         default:
             assert(false);
     }
@@ -826,7 +3442,18 @@ bool development_load_raw_values(const uint64_t *values, size_t n_values)
     }
 
     memcpy(data_, values, n_values * sizeof(*values));
+    if (timestamps_) {
+        memset(timestamps_, 0, n_values * sizeof(*timestamps_));
+    }
     count_ = n_values;
+    values_cache_mode_ = cache_mode_;
+    warmup_trimmed_ = 0;
+    // no events known for these values
+    event_records_n_ = 0;
+    event_batch_first_ = count_;
+    event_series_started_ = false;
+    event_series_closed_ = false;
+    event_series_interrupts_ = 0;
     return true;
 }
 
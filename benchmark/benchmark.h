@@ -11,9 +11,20 @@
  *    * parametric, assuming normal distribution: mean +/- SD, 95% confidence interval of the mean
  *      (the user has to check herself/himself whether parametric values make sense)
  *    * simple histogram
+ *    * mode detection (kernel density estimate); multimodal results are flagged
+ *    * steady state: warmup detection and trimming, drift (changepoint) detection
  *    * 2 modes of outlier detection (based on histogram or on SD); see comment below on caveat
  *    * printing: conversion to other units
  *    * export of all values
+ *  - optional timestamps of each measurement
+ *  - capture of the execution environment (CPU, frequency, governor, turbo, SMT, kernel,
+ *    compiler); warning for noisy environments
+ *  - automatic selection of the denominator (inner loop count) incl. loop overhead
+ *  - cache state control for each measurement: cold (flush/evict), warm (pre-touch), as is
+ *  - accounting of disturbing events (context switches, page faults, interrupts, migrations)
+ *    per batch of measurements or per measurement; evidence based outlier removal
+ *  - prefaulted and locked buffers (huge pages for large buffers) for the values and,
+ *    via testbench_alloc_buffer(), for the data of the code under test
  *
  *  Potential problem: Storage of all values needs some space (a few cache lines).
  *  If this is a problem for the system to be tested, see the module
@@ -73,6 +84,16 @@
  */
 #define TESTBENCH_STD_DENOMINATOR 1
 
+/**
+ * Automatic selection of the denominator (see testbench_calibrate_denominator()):
+ * the repetition count is doubled until the measured interval exceeds the given
+ * factor times the baseline and times the timer resolution.
+ * Each step takes the minimum of TESTBENCH_CALIBRATION_TRIALS measurements.
+ */
+#define TESTBENCH_CALIBRATION_STD_FACTOR 32
+#define TESTBENCH_CALIBRATION_MAX_DENOMINATOR (1 << 20)
+#define TESTBENCH_CALIBRATION_TRIALS 8
+
 /**
  * During outlier detection, only values are kept that have more values than this defined cutoff
  * value in the histogram for individual values
@@ -90,18 +111,21 @@
  * runs also many other processes, which introduce noise. You must be aware of pitfalls. Thus: Outlier detection
  * and removal is always associated in this library with printing both histograms, before and after.
  *
- * There are currently 2 modes implemented for outlier detection:
+ * There are currently 3 modes implemented for outlier detection:
  * - histogram: can remove any kind of value even within the [min, max] range based on very low occurence
  * - standard deviation: removes outliers that are far from mean; there are much better statistical methods
  *   for outlier detection (e.g. Grubbs, Tukey or generalized ESD test) than SD used here. They are not
  *   implemented here.
+ * - events: removes only the values that were attributed to context switches, page faults,
+ *   interrupts or migrations; needs event accounting (see set_event_accounting())
  * and OFF: of course, it's best to work without outlier removal
  * default is OFF
  */
 enum testbench_outlier_detection_mode {
     TESTBENCH_OUTLIER_DETECTION_OFF,
     TESTBENCH_OUTLIER_DETECTION_HISTOGRAM,
-    TESTBENCH_OUTLIER_DETECTION_SD
+    TESTBENCH_OUTLIER_DETECTION_SD,
+    TESTBENCH_OUTLIER_DETECTION_EVENTS
 };
 
 /**
@@ -120,6 +144,189 @@ enum testbench_outlier_detection_mode {
 #define TESTBENCH_OUTLIER_DETECTION_SD_MIN_N 20
 #define TESTBENCH_OUTLIER_DETECTION_SD_MIN_SD 3
 
+/**
+ * Cache state at the beginning of each measurement. The examples relied on
+ * accidental cache state so far (e.g. repeating a test "again" to exclude
+ * caching benefits). These modes make the state explicit:
+ * - AS_IS: nothing is done (default; behavior of earlier versions)
+ * - WARM:  all declared buffers are pre-touched (read) before the measurement
+ * - COLD:  the last level cache is evicted by sweeping a buffer of
+ *          TESTBENCH_EVICTION_FACTOR * LLC size, and all declared buffers are
+ *          flushed with CLFLUSHOPT (CLFLUSH if not available)
+ * The state is only established by testbench_prepare_cache(), which must be
+ * called right before RDTSC_START.
+ */
+enum testbench_cache_mode {
+    TESTBENCH_CACHE_AS_IS,
+    TESTBENCH_CACHE_WARM,
+    TESTBENCH_CACHE_COLD
+};
+
+/**
+ * maximum number of buffers that can be declared with testbench_declare_buffer()
+ */
+#define TESTBENCH_MAX_CACHE_BUFFERS 8
+
+/**
+ * the sweep buffer for COLD mode has this multiple of the detected LLC size;
+ * TESTBENCH_STD_LLC_SIZE is used if the LLC size cannot be detected by CPUID
+ */
+#define TESTBENCH_EVICTION_FACTOR 2
+#define TESTBENCH_STD_LLC_SIZE (32 * 1024 * 1024)
+
+/**
+ * Mode detection: branch prediction results or results on a noisy host are often
+ * multimodal, and mean +/- SD as well as a single median hide this.
+ * A kernel density estimate (Gaussian kernel, bandwidth by Silverman's rule of thumb
+ * using min(SD, IQR/1.34), but at least the granularity of the values, i.e. the median
+ * gap between distinct values) is evaluated on a grid of 4 points per bandwidth near the
+ * values (linear binning of the values to the grid). The grid is capped at
+ * TESTBENCH_MODE_MAX_POINTS points: coarser steps then, and the bandwidth is at least
+ * one step. Local maxima are modes; values are assigned to modes by the density minima
+ * (valleys) between them. O(n log n) in total.
+ * - neighbouring modes are merged if the valley density is above
+ *   TESTBENCH_MODE_MAX_VALLEY_RATIO * density of the smaller peak
+ * - modes holding less than TESTBENCH_MODE_MIN_WEIGHT of the values are not reported
+ * - detection needs at least TESTBENCH_MODE_MIN_N values
+ */
+#define TESTBENCH_MAX_MODES 16
+#define TESTBENCH_MODE_MIN_N 20
+#define TESTBENCH_MODE_MIN_WEIGHT 0.05
+#define TESTBENCH_MODE_MAX_VALLEY_RATIO 0.5
+#define TESTBENCH_MODE_MAX_POINTS 16384
+
+/**
+ * Steady state analysis of the values in the order of measurement:
+ * - warmup: MSER-5 (marginal standard error rule) on the medians of batches of
+ *   TESTBENCH_WARMUP_BATCH values; the truncation point is limited to the first half,
+ *   and the prefix must be slower (higher median) than the remaining values
+ * - drift: Pettitt's rank-based changepoint test on the values after warmup;
+ *   drift is flagged if p < TESTBENCH_DRIFT_P_VALUE and the medians before and after the
+ *   changepoint differ by more than TESTBENCH_DRIFT_MIN_CHANGE (relative)
+ * - both need at least TESTBENCH_STEADY_STATE_MIN_N values
+ */
+#define TESTBENCH_WARMUP_BATCH 5
+#define TESTBENCH_STEADY_STATE_MIN_N 20
+#define TESTBENCH_DRIFT_P_VALUE 0.01
+#define TESTBENCH_DRIFT_MIN_CHANGE 0.02
+
+struct testbench_steady_state {
+    size_t warmup;             // number of values detected as warmup prefix
+    size_t warmup_trimmed;     // number of values already trimmed (see set_warmup_trimming())
+    bool drift;
+    size_t changepoint;        // index of the first value after the change (current values)
+    uint64_t changepoint_time; // cycles since the first measurement; 0 without timestamps
+    double p_value;            // approximate p value of Pettitt's test
+    double median_before;      // medians before and after the changepoint
+    double median_after;
+};
+
+struct testbench_mode {
+    double location; // median of the values of this mode
+    double spread;   // IQR of the values of this mode (range if less than 4 values)
+    double weight;   // fraction of all values
+    size_t count;
+};
+
+struct testbench_modes {
+    size_t n_modes;
+    struct testbench_mode modes[TESTBENCH_MAX_MODES]; // sorted by location
+};
+/**
+ * Execution environment: captured by create_testbench() if enabled (opt-in; default
+ * TESTBENCH_STD_CAPTURE_ENVIRONMENT; see set_environment_capture()); the capture
+ * takes some 70 ms (TSC frequency: 20 ms, load of the SMT siblings: 50 ms).
+ * Captured: CPU model and selected flags (CPUID), kernel, compiler and flags,
+ * and on Linux: scaling governor, min/max/current frequency, turbo/boost state,
+ * load of the SMT siblings of the current CPU, and load average.
+ * The effective frequency while running is determined by perf_event cycles (user and
+ * kernel mode) vs task clock, or user mode cycles vs user time if counting the kernel
+ * is not permitted (Linux), and compared to the TSC frequency.
+ *
+ * The environment is printed by create_testbench(), embedded as comments in the
+ * values export, and summarized with the statistics. A warning is issued for
+ * environments known to be noisy:
+ * - governor other than performance, turbo/boost enabled, hypervisor
+ * - SMT siblings busy more than TESTBENCH_NOISY_SMT_LOAD
+ * - load average of other processes above TESTBENCH_NOISY_LOADAVG
+ * - effective frequency deviating more than TESTBENCH_NOISY_FREQUENCY_DEVIATION from TSC frequency
+ *
+ * The compiler flags can only be known if benchmark.c is compiled with
+ * -DTESTBENCH_COMPILER_FLAGS="\"$(CFLAGS)\"" (see the Makefiles of the examples).
+ */
+#define TESTBENCH_STD_CAPTURE_ENVIRONMENT false
+#define TESTBENCH_NOISY_SMT_LOAD 0.1
+#define TESTBENCH_NOISY_LOADAVG 0.5
+#define TESTBENCH_NOISY_FREQUENCY_DEVIATION 0.05
+
+struct testbench_environment {
+    bool captured;
+    char cpu_model[64];
+    char cpu_flags[128];
+    char kernel[256];
+    char compiler[128];
+    char compiler_flags[256];
+    char governor[32];        // empty if not available
+    long freq_min_khz;        // -1 if not available
+    long freq_max_khz;
+    long freq_cur_khz;
+    int turbo;                // 1 enabled, 0 disabled, -1 unknown
+    int cpu;                  // CPU at capture time; -1 unknown
+    int smt_siblings;         // number of SMT siblings of this CPU (without itself); -1 unknown
+    double smt_sibling_load;  // mean busy fraction of the siblings during capture; -1 unknown
+    double loadavg;           // 1 minute load average; -1 unknown
+    double tsc_ghz;           // TSC frequency (measured against the monotonic clock)
+    double effective_ghz;     // cycles per ns while running since capture; -1 unknown
+    bool hypervisor;
+    bool noisy;
+    char noise_reasons[256];
+};
+
+/**
+ * Event accounting: most outliers are caused by interrupts and preemption. The counters of
+ * getrusage() (voluntary and involuntary context switches, minor and major page faults;
+ * per thread on Linux) are read before and after each batch of measurements, the interrupt
+ * counts of the current CPU (/proc/interrupts; Linux) as described per mode:
+ * - BATCH:  batches of TESTBENCH_STD_EVENT_BATCH measurements (or as set); little overhead
+ *           between the measurements, but the events can only be attributed to a batch.
+ *           Within a disturbed batch, as many values as events were counted are attributed
+ *           to the events, largest first, but only values above the Tukey fence
+ *           q3 + TESTBENCH_EVENT_FENCE_IQR * IQR of all values.
+ *           Parsing /proc/interrupts is too slow for the measurement path: it is read at the
+ *           start and at the end of the series (first analysis call) only; the interrupts of
+ *           the series are attributed in the same way to the largest remaining values of all
+ *           batches. Further analysis calls use the same count until the next measurement.
+ * - SAMPLE: each measurement is its own batch (debug mode); reading the counters (including
+ *           /proc/interrupts) takes some microseconds and pollutes the caches between the
+ *           measurements. Any event marks the value as disturbed.
+ * A change of the CPU during a batch counts as migration event.
+ * A batch starts with reset_testbench() and after the previous batch; if
+ * testbench_prepare_cache() is used, the empty batch is started again at its end.
+ * Thus, the preparation of the caches is not accounted.
+ */
+enum testbench_event_accounting_mode {
+    TESTBENCH_EVENTS_OFF,
+    TESTBENCH_EVENTS_BATCH,
+    TESTBENCH_EVENTS_SAMPLE
+};
+
+#define TESTBENCH_STD_EVENT_BATCH 16
+#define TESTBENCH_EVENT_FENCE_IQR 1.5
+
+struct testbench_events {
+    enum testbench_event_accounting_mode mode;
+    size_t batch_size;
+    size_t batches;              // completed batches of the current values
+    size_t disturbed_batches;    // batches with at least one event (BATCH: without interrupts)
+    size_t disturbed_values;     // values attributed to the events
+    uint64_t voluntary_switches; // sums over all batches
+    uint64_t involuntary_switches;
+    uint64_t minor_faults;
+    uint64_t major_faults;
+    uint64_t interrupts;         // 0 if not available
+    uint64_t migrations;
+    bool interrupts_available;   // /proc/interrupts could be read
+};
 
 struct testbench_statistics {
     size_t count;
@@ -138,6 +345,46 @@ struct testbench_statistics {
     double sd;     // mean +/- sd
     double ci95_a; // 95% confidence interval [a,b] for the mean
     double ci95_b;
+    // shape
+    size_t modes; // number of detected modes (0 if n is too small); > 1: multimodal, medians can be misleading
+    // steady state; only determined by testbench_get_statistics() for values in order of measurement
+    size_t warmup;      // number of values trimmed as warmup
+    bool drift;         // changepoint detected
+    size_t changepoint; // index of the first value after the change
+    // disturbances; only determined by testbench_get_statistics() with event accounting
+    size_t disturbed;   // number of values attributed to events (see set_event_accounting())
+    // measurement conditions
+    enum testbench_cache_mode cache_mode;
+    uint64_t loop_overhead;      // subtracted in addition to the baseline; 0 unless calibrated
+    bool denominator_calibrated; // true if set by testbench_calibrate_denominator()
+};
+
+/**
+ * Buffers: page faults and TLB misses during the measurement are noise. Thus, the buffers
+ * written while measuring (values, timestamps, event records) are allocated by
+ * testbench_alloc_buffer(), which is also available for the data of the code under test:
+ * - Linux: anonymous mapping; buffers of at least the default huge page size
+ *   (Hugepagesize in /proc/meminfo) are backed by huge pages (MAP_HUGETLB) if available;
+ *   otherwise, buffers of at least the transparent huge page size (hpage_pmd_size in
+ *   /sys/kernel/mm/transparent_hugepage) are aligned to it and hinted (MADV_HUGEPAGE);
+ *   both sizes fall back to TESTBENCH_HUGE_PAGE_SIZE if they cannot be read; all pages
+ *   are prefaulted and locked (mlock) as far as RLIMIT_MEMLOCK allows
+ * - other systems: calloc, prefaulted
+ * The buffers used for the analysis only (outlier removal, sorting) are allocated with
+ * malloc at their first use after the measurements.
+ */
+#define TESTBENCH_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+/**
+ * buffer size of the conditions note (see set_conditions_note())
+ */
+#define TESTBENCH_MAX_NOTE 256
+
+enum testbench_buffer_property {
+    TESTBENCH_BUFFER_PREFAULTED = 1,
+    TESTBENCH_BUFFER_LOCKED = 2,
+    TESTBENCH_BUFFER_HUGETLB = 4,
+    TESTBENCH_BUFFER_THP_HINT = 8
 };
 
 /**
@@ -159,10 +406,35 @@ struct testbench_time_unit {
  * Initializes the test bench for a maximum of capacity measurements.
  * Determines the baseline (timing overhead of the RDTSC macros);
  * the statistics on this baseline is reported.
+ * Determines the timer resolution (smallest step between consecutive RDTSC reads).
+ * Captures the execution environment if enabled (see set_environment_capture()).
  * Sets all values to standard/default values.
+ * The values are stored in a buffer allocated by testbench_alloc_buffer().
  */
 bool create_testbench(size_t capacity);
 
+/**
+ * \param enabled  capture the execution environment in create_testbench();
+ *                 default TESTBENCH_STD_CAPTURE_ENVIRONMENT
+ *
+ * note: to be called before create_testbench(); kept after delete_testbench()
+ */
+void set_environment_capture(bool enabled);
+
+/**
+ * \return  the captured environment; the effective frequency is updated to the current
+ *          state (time since the capture); captured == false if nothing was captured
+ */
+struct testbench_environment testbench_get_environment(void);
+
+/**
+ * \param stream  FILE object
+ * \param prefix  optional; prefix of each line, e.g. "# " for comments
+ * \param env     captured environment
+ * \return        true if successful without I/O errors; false otherwise
+ */
+bool fprint_testbench_environment(FILE *stream, const char *prefix, const struct testbench_environment *env);
+
 /**
  * \param denominator  denomainator; must be >= 1; default TESTBENCH_STD_DENOMINATOR
  *
@@ -177,9 +449,60 @@ bool create_testbench(size_t capacity);
  * - needs to be set again if a new test bench is created, but remains
  *   active after reset()
  * - can be set after data collection
+ * - clears the loop overhead determined by testbench_calibrate_denominator()
  */
 void set_denominator(size_t denominator);
 
+/**
+ * signature of a piece of code to be tested by testbench_calibrate_denominator()
+ * and testbench_measure_kernel(); context is passed through unchanged
+ */
+typedef void (*testbench_kernel_function_t)(void *context);
+
+/**
+ * \param kernel   code to be tested
+ * \param context  optional argument for kernel
+ * \param factor   required multiple of baseline and timer resolution;
+ *                 TESTBENCH_CALIBRATION_STD_FACTOR is used if 0
+ * \return         the selected denominator
+ *
+ * Alternative to set_denominator(): the repetition count is doubled (starting at 1)
+ * until the measured interval of the repetition loop exceeds factor times the baseline
+ * and factor times the timer resolution (limit TESTBENCH_CALIBRATION_MAX_DENOMINATOR).
+ * Additionally, the overhead of the repetition loop is measured with an empty kernel.
+ * The denominator is set to the selected count, and the loop overhead is subtracted
+ * by add_measurement() in addition to the baseline. Both are reported with the statistics.
+ * note: use testbench_measure_kernel() to take the measurements with the same loop.
+ */
+size_t testbench_calibrate_denominator(testbench_kernel_function_t kernel, void *context, size_t factor);
+
+/**
+ * \param kernel   code to be tested
+ * \param context  optional argument for kernel
+ * \param n        number of measurements to be added
+ * \return         true if successful; false if the capacity is too small
+ *
+ * Takes n measurements of a loop that calls kernel denominator times.
+ * testbench_prepare_cache() is called before each measurement.
+ */
+bool testbench_measure_kernel(testbench_kernel_function_t kernel, void *context, size_t n);
+
+/**
+ * \param size            size in bytes
+ * \param ret_properties  optional; set to the properties (TESTBENCH_BUFFER_* flags)
+ * \return                zero-initialized buffer; NULL if out of memory
+ *
+ * Allocates a buffer as described above (see TESTBENCH_HUGE_PAGE_SIZE); aligned at least
+ * to the page size on Linux. Can be used without a testbench.
+ */
+void *testbench_alloc_buffer(size_t size, unsigned *ret_properties);
+
+/**
+ * \param buffer  allocated by testbench_alloc_buffer(); NULL is ignored
+ * \param size    the same size as used for the allocation
+ */
+void testbench_free_buffer(void *buffer, size_t size);
+
 /**
  * \param mode  outlier detection mode; default TESTBENCH_OUTLIER_DETECTION_OFF
  *
@@ -187,12 +510,113 @@ void set_denominator(size_t denominator);
  */
 void set_outlier_detection_mode(enum testbench_outlier_detection_mode mode);
 
+/**
+ * \param mode  cache mode; default TESTBENCH_CACHE_AS_IS
+ *
+ * note: the mode is recorded with the values by reset_testbench() and by each
+ * testbench_prepare_cache(); the statistics and the export of the values report the
+ * recorded mode, i.e. it may be changed after data collection
+ */
+void set_cache_mode(enum testbench_cache_mode mode);
+
+/**
+ * \return  size of the last level cache in bytes (CPUID leaf 4); TESTBENCH_STD_LLC_SIZE
+ *          if it cannot be detected
+ */
+size_t testbench_llc_size(void);
+
+/**
+ * \param note           free text describing additional measurement conditions
+ *                       (e.g. active co-runners, see parallel_benchmark.h); NULL clears it
+ * \param keep_on_reset  true: kept by reset_testbench(); false: cleared by the next reset_testbench()
+ *
+ * The note is reported with the statistics and in the values export. At most
+ * TESTBENCH_MAX_NOTE - 1 characters are kept.
+ */
+void set_conditions_note(const char *note, bool keep_on_reset);
+
+/**
+ * \param buffer  start of a buffer used by the code under test
+ * \param size    size in bytes
+ * \return        true if successful; false if TESTBENCH_MAX_CACHE_BUFFERS are already declared
+ *
+ * Declares a buffer whose cache lines are flushed (COLD) or pre-touched (WARM)
+ * by testbench_prepare_cache(). Declared buffers are kept after reset_testbench().
+ */
+bool testbench_declare_buffer(const void *buffer, size_t size);
+
+/**
+ * removes all declared buffers
+ */
+void testbench_clear_buffers(void);
+
+/**
+ * Establishes the cache state defined by the cache mode.
+ * Call it right before RDTSC_START for each measurement; nothing is done in AS_IS mode.
+ * The sweep buffer for COLD mode is allocated at its first use.
+ */
+void testbench_prepare_cache(void);
+
+/**
+ * \param enabled  store the start timestamp of each measurement; default false
+ * \return         true if successful; false otherwise (memory)
+ *
+ * Timestamps are exported by fprint_testbench_values() and used to report the time of
+ * a changepoint. The buffer is allocated here (or in create_testbench() if enabled before).
+ */
+bool set_timestamps(bool enabled);
+
+/**
+ * \param enabled  trim the detected warmup prefix automatically; default false
+ *
+ * If enabled, testbench_get_statistics() removes the warmup values detected by the
+ * steady state analysis from the data store before calculating the statistics; once
+ * per measurement series (until reset_testbench()), thus repeated calls are idempotent.
+ * The number of trimmed values is reported with the statistics.
+ */
+void set_warmup_trimming(bool enabled);
+
+/**
+ * \param mode        event accounting mode; default TESTBENCH_EVENTS_OFF
+ * \param batch_size  measurements per batch in BATCH mode; 0: TESTBENCH_STD_EVENT_BATCH
+ * \return            true if successful; false otherwise (memory)
+ *
+ * The records are allocated here (or in create_testbench() if enabled before).
+ * Already stored values are not accounted; call reset_testbench() afterwards.
+ */
+bool set_event_accounting(enum testbench_event_accounting_mode mode, size_t batch_size);
+
+/**
+ * \return  the event counts of the current values (summed over all batches)
+ *          and the number of values attributed to them
+ */
+struct testbench_events testbench_get_events(void);
+
+/**
+ * \param stream  FILE object
+ * \param title   optional; none is used if NULL
+ * \param events  result of testbench_get_events()
+ * \return        true if successful without I/O errors; false otherwise
+ */
+bool fprint_testbench_events(FILE *stream, const char *title, const struct testbench_events *events);
+
+/**
+ * No return value (for consistency with the other print functions)
+ */
+static inline void print_testbench_events(const char *title, const struct testbench_events *events)
+{
+    fprint_testbench_events(stdout, title, events);
+}
+
 /**
  * storage space is reset to allow new measurment data
  * notes:
  * - baseline is NOT determined again; but it is restored to
  *   initial value in case a development_map_values() has been used
- * - options (denominator and outlier detection mode are kept)
+ * - options (denominator, outlier detection mode, cache mode and declared buffers,
+ *   timestamps, warmup trimming, event accounting) are kept
+ * - the conditions note is cleared unless it is to be kept (see set_conditions_note())
+ * - a new batch of event accounting is started
  */
 void reset_testbench(void);
 
@@ -208,14 +632,85 @@ void delete_testbench(void);
  * notes:
  * - no range checking here to have as little interruption as possible
  * - the overhead of these macros "zero" line / baseline is subtracted automatically within this function
+ * - additionally, the loop overhead is subtracted after testbench_calibrate_denominator()
  */
 void add_measurement(uint64_t start, uint64_t stop);
 
+/**
+ * \param start    array of raw values as determined with RDTSC_START
+ * \param stop     array of raw values as determined with RDTSC_STOP
+ * \param n        array size (must be <= capacity)
+ * \return         true in case of success; false otherwise
+ *
+ * Replaces the stored values by measurements recorded elsewhere (e.g. by other threads,
+ * see parallel_benchmark.h). They are processed as by add_measurement(); no events are
+ * accounted for them.
+ */
+bool testbench_load_measurements(const uint64_t *start, const uint64_t *stop, size_t n);
+
 /**
  * calculates the descriptive statistics values
+ * notes:
+ * - the stored values are kept in order of measurement
+ * - the steady state is analyzed (warmup is trimmed if enabled, drift is flagged)
  */
 struct testbench_statistics testbench_get_statistics(void);
 
+/**
+ * analyzes warmup and drift of the values in order of measurement;
+ * see TESTBENCH_WARMUP_* and TESTBENCH_DRIFT_* above for the methods
+ */
+struct testbench_steady_state testbench_get_steady_state(void);
+
+/**
+ * \param stream  FILE object
+ * \param title   optional; none is used if NULL
+ * \param state   result of the steady state analysis
+ * \param unit    optional; cycles are used if NULL
+ * \return        true if successful without I/O errors; false otherwise
+ */
+bool fprint_testbench_steady_state(FILE *stream, const char *title,
+                                   const struct testbench_steady_state *state,
+                                   const struct testbench_time_unit *unit);
+
+/**
+ * No return value (for consistency with the other print functions)
+ */
+static inline void print_testbench_steady_state(const char *title,
+                                                const struct testbench_steady_state *state,
+                                                const struct testbench_time_unit *unit)
+{
+    fprint_testbench_steady_state(stdout, title, state, unit);
+}
+
+/**
+ * detects the modes of the measured values; see TESTBENCH_MODE_* above for the method
+ */
+struct testbench_modes testbench_get_modes(void);
+
+/**
+ * \param stream  FILE object
+ * \param title   optional; none is used if NULL
+ * \param modes   detected modes
+ * \param unit    optional; cycles are used if NULL
+ * \return        true if successful without I/O errors; false otherwise
+ *
+ * Prints location, spread (IQR) and weight of each mode; multimodal results are flagged.
+ */
+bool fprint_testbench_modes(FILE *stream, const char *title,
+                            const struct testbench_modes *modes,
+                            const struct testbench_time_unit *unit);
+
+/**
+ * No return value (for consistency with the other print functions)
+ */
+static inline void print_testbench_modes(const char *title,
+                                         const struct testbench_modes *modes,
+                                         const struct testbench_time_unit *unit)
+{
+    fprint_testbench_modes(stdout, title, modes, unit);
+}
+
 /**
  * \param stream  FILE object
  * \param title   title written as a comment (# prefix)
@@ -224,6 +719,8 @@ struct testbench_statistics testbench_get_statistics(void);
  * \return        true if successful without I/O errors; false otherwise
  *
  * Prints the values for e.g. import into a statistics program
+ * in order of measurement; the captured environment is included as comments; with timestamps enabled, the start time
+ * (cycles since the first measurement) is printed as second column
  */
 bool fprint_testbench_values(FILE *stream, const char *title, const struct testbench_time_unit *unit);
 
@@ -272,6 +769,7 @@ static inline void print_testbench_statistics(const char *title,
  * - C like, the function can also be called without this receiving variable.
  * - Histogram: currently fixed size (width 100 == 100%, i.e. 1 % / char)
  *   currently used: * for 1 % and . for additional 0.5 %
+ * - The detected modes are printed below the histogram for multimodal results.
  */
 struct testbench_statistics fprint_histogram(FILE *stream, const char *title,
                                              const struct testbench_statistics *stat,
@@ -0,0 +1,934 @@
+/**
+ * Scaling harness for the benchmark library
+ *
+ * See header file for details.
+ *
+ * MIT License (see benchmark.h)
+ */
+
+#define _GNU_SOURCE // pthread_setaffinity_np(), sched_getaffinity(), sched_getcpu()
+
+#include "parallel_benchmark.h"
+
+#include <assert.h>
+#include <immintrin.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+//--- affinity -------------------------------------------------------------------------------------
+
+#ifdef __linux__
+// affinity mask of the calling thread before testbench_pool_create() pinned it
+static bool caller_pinned_ = false;
+static cpu_set_t caller_mask_;
+#endif
+
+/**
+ * pins the calling thread to cpu; cpu < 0: not pinned, i.e. the affinity mask of the process
+ * (a new thread inherits the mask of its creator, which may be pinned by the pool)
+ */
+static void set_thread_affinity(int cpu)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    if (cpu >= 0) {
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+    }
+    else if (caller_pinned_) {
+        set = caller_mask_;
+    }
+    else {
+        return;
+    }
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)cpu;
+#endif
+}
+
+//--- spin barrier ---------------------------------------------------------------------------------
+//    a pthread barrier would put the threads to sleep; their wakeup latency would
+//    spread the start of the threads
+
+struct spin_barrier {
+    unsigned count;
+    unsigned generation;
+    unsigned n;
+};
+
+static void spin_barrier_init(struct spin_barrier *barrier, unsigned n)
+{
+    barrier->count = 0;
+    barrier->generation = 0;
+    barrier->n = n;
+}
+
+static void spin_wait(const unsigned *flag, unsigned value)
+{
+    unsigned spins = 0;
+    while (__atomic_load_n(flag, __ATOMIC_ACQUIRE) == value) {
+        __builtin_ia32_pause();
+        if (++spins >= TESTBENCH_SPIN_YIELD_LIMIT) {
+            sched_yield();
+            spins = 0;
+        }
+    }
+}
+
+static void spin_barrier_wait(struct spin_barrier *barrier)
+{
+    unsigned generation = __atomic_load_n(&barrier->generation, __ATOMIC_ACQUIRE);
+    if (__atomic_add_fetch(&barrier->count, 1, __ATOMIC_ACQ_REL) == barrier->n) {
+        // last thread releases all others
+        __atomic_store_n(&barrier->count, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&barrier->generation, generation + 1, __ATOMIC_RELEASE);
+        return;
+    }
+    spin_wait(&barrier->generation, generation);
+}
+
+//--- worker threads -------------------------------------------------------------------------------
+
+enum gate_state {
+    GATE_CLOSED,
+    GATE_OPEN,
+    GATE_ABORT
+};
+
+struct run {
+    testbench_parallel_function_t f;
+    void *context;
+    size_t n_threads;
+    size_t rounds;
+    unsigned gate; // enum gate_state; opened after all threads have been created
+    struct spin_barrier barrier;
+};
+
+struct worker {
+    pthread_t thread;
+    struct run *run;
+    size_t index;
+    int cpu_target; // -1: not pinned
+    int cpu;
+    uint64_t *start;
+    uint64_t *stop;
+    bool ok;
+};
+
+static void *worker_main(void *arg)
+{
+    struct worker *w = arg;
+    struct run *r = w->run;
+
+    set_thread_affinity(w->cpu_target);
+
+    // first touch by the pinned thread
+    w->start = testbench_alloc_buffer(r->rounds * sizeof(*w->start), NULL);
+    w->stop = testbench_alloc_buffer(r->rounds * sizeof(*w->stop), NULL);
+    w->ok = w->start && w->stop;
+
+    spin_wait(&r->gate, GATE_CLOSED);
+    if (__atomic_load_n(&r->gate, __ATOMIC_ACQUIRE) == GATE_ABORT) {
+        return NULL;
+    }
+
+    // all threads take part in all rounds, even after an allocation error
+    for (size_t i = 0; i < TESTBENCH_PARALLEL_WARMUP_ROUNDS; i++) {
+        spin_barrier_wait(&r->barrier);
+        r->f(r->context, w->index, r->n_threads);
+    }
+
+    for (size_t i = 0; i < r->rounds; i++) {
+        uint64_t start = 0;
+        uint64_t stop = 0;
+        spin_barrier_wait(&r->barrier);
+        RDTSC_START(start);
+        r->f(r->context, w->index, r->n_threads);
+        RDTSC_STOP(stop);
+        if (w->ok) {
+            w->start[i] = start;
+            w->stop[i] = stop;
+        }
+    }
+
+#ifdef __linux__
+    w->cpu = sched_getcpu();
+#else
+    w->cpu = -1;
+#endif
+    return NULL;
+}
+
+static void free_workers(struct worker *workers, size_t n_workers, size_t rounds)
+{
+    for (size_t i = 0; i < n_workers; i++) {
+        testbench_free_buffer(workers[i].start, rounds * sizeof(*workers[i].start));
+        testbench_free_buffer(workers[i].stop, rounds * sizeof(*workers[i].stop));
+    }
+    free(workers);
+}
+
+//--- private helpers ------------------------------------------------------------------------------
+
+/**
+ * CPUs of the affinity mask of the process; returns their number
+ */
+static size_t get_cpus(int *cpus, size_t max_cpus)
+{
+    size_t n = 0;
+#ifdef __linux__
+    cpu_set_t set;
+    bool ok = true;
+    if (caller_pinned_) {
+        set = caller_mask_;
+    }
+    else {
+        ok = sched_getaffinity(0, sizeof(set), &set) == 0;
+    }
+    if (ok) {
+        for (int i = 0; i < CPU_SETSIZE && n < max_cpus; i++) {
+            if (CPU_ISSET(i, &set)) {
+                cpus[n++] = i;
+            }
+        }
+        return n;
+    }
+#endif
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    for (long i = 0; i < online && n < max_cpus; i++) {
+        cpus[n++] = (int)i;
+    }
+    return n > 0 ? n : 1;
+}
+
+/**
+ * runs and analyzes one thread count
+ */
+static bool run_point(testbench_parallel_function_t f, void *context, size_t n_threads, size_t rounds,
+                      const int *cpus, size_t n_cpus, bool pin, double work_per_call,
+                      struct testbench_scaling_point *ret_point)
+{
+    struct run r = {
+        .f = f,
+        .context = context,
+        .n_threads = n_threads,
+        .rounds = rounds,
+        .gate = GATE_CLOSED
+    };
+    spin_barrier_init(&r.barrier, (unsigned)n_threads);
+
+    struct worker *workers = calloc(n_threads, sizeof(*workers));
+    if (!workers) {
+        return false;
+    }
+
+    size_t created = 0;
+    for (; created < n_threads; created++) {
+        struct worker *w = &workers[created];
+        w->run = &r;
+        w->index = created;
+        w->cpu_target = pin ? cpus[created % n_cpus] : -1;
+        if (pthread_create(&w->thread, NULL, worker_main, w) != 0) {
+            break;
+        }
+    }
+
+    __atomic_store_n(&r.gate, created == n_threads ? GATE_OPEN : GATE_ABORT, __ATOMIC_RELEASE);
+    bool ok = created == n_threads;
+    for (size_t i = 0; i < created; i++) {
+        pthread_join(workers[i].thread, NULL);
+        ok = ok && workers[i].ok;
+    }
+    if (!ok) {
+        free_workers(workers, created, rounds);
+        return false;
+    }
+
+    // analysis: per thread, then wall time of all threads
+    ret_point->n_threads = n_threads;
+    ret_point->threads = calloc(n_threads, sizeof(*ret_point->threads));
+    uint64_t *wall_start = malloc(rounds * sizeof(*wall_start));
+    uint64_t *wall_stop = malloc(rounds * sizeof(*wall_stop));
+    if (!ret_point->threads || !wall_start || !wall_stop) {
+        goto error;
+    }
+
+    for (size_t i = 0; i < n_threads; i++) {
+        struct worker *w = &workers[i];
+        if (!testbench_load_measurements(w->start, w->stop, rounds)) {
+            goto error;
+        }
+        ret_point->threads[i].cpu = w->cpu;
+        ret_point->threads[i].latency = testbench_get_statistics();
+    }
+
+    for (size_t j = 0; j < rounds; j++) {
+        wall_start[j] = workers[0].start[j];
+        wall_stop[j] = workers[0].stop[j];
+        for (size_t i = 1; i < n_threads; i++) {
+            if (workers[i].start[j] < wall_start[j]) {
+                wall_start[j] = workers[i].start[j];
+            }
+            if (workers[i].stop[j] > wall_stop[j]) {
+                wall_stop[j] = workers[i].stop[j];
+            }
+        }
+    }
+    if (!testbench_load_measurements(wall_start, wall_stop, rounds)) {
+        goto error;
+    }
+    ret_point->wall = testbench_get_statistics();
+    ret_point->throughput = ret_point->wall.median > 0.0
+                          ? (double)n_threads * work_per_call / ret_point->wall.median
+                          : 0.0;
+
+    free(wall_stop);
+    free(wall_start);
+    free_workers(workers, n_threads, rounds);
+    return true;
+
+error:
+    free(wall_stop);
+    free(wall_start);
+    free(ret_point->threads);
+    ret_point->threads = NULL;
+    free_workers(workers, n_threads, rounds);
+    return false;
+}
+
+//--- antagonists ---------------------------------------------------------------------------------
+
+#define CACHE_LINE_SIZE 64
+
+// work between the checks of the time; a few microseconds
+#define ANTAGONIST_BURST 4096
+
+struct antagonist_thread {
+    pthread_t thread;
+    struct testbench_antagonist config;
+    char *buffer;
+    size_t buffer_size;
+    bool ok;
+};
+
+static struct antagonist_thread antagonists_[TESTBENCH_MAX_ANTAGONISTS];
+static size_t antagonists_n_ = 0;
+static unsigned antagonists_stop_ = 0;
+static unsigned antagonists_ready_ = 0;
+static char antagonists_note_[TESTBENCH_MAX_NOTE];
+
+// sink for the results of the computing antagonists
+static volatile uint64_t antagonist_sink_ = 0;
+
+static const char *antagonist_name(enum testbench_antagonist_kind kind)
+{
+    switch (kind) {
+        case TESTBENCH_ANTAGONIST_MEMORY_BANDWIDTH:
+            return "memory bandwidth";
+        case TESTBENCH_ANTAGONIST_LLC:
+            return "LLC";
+        case TESTBENCH_ANTAGONIST_BRANCH:
+            return "branch";
+        case TESTBENCH_ANTAGONIST_AVX:
+            return "AVX";
+        default:
+            assert(false);
+            return "";
+    }
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * read-modify-write of one word per cache line, sequentially (prefetcher friendly)
+ */
+static void bandwidth_burst(struct antagonist_thread *a, size_t *position)
+{
+    for (size_t i = 0; i < ANTAGONIST_BURST; i++) {
+        *(uint64_t *)(a->buffer + *position) += 1;
+        *position += CACHE_LINE_SIZE;
+        if (*position >= a->buffer_size) {
+            *position = 0;
+        }
+    }
+}
+
+/**
+ * read-modify-write of random cache lines (not prefetchable)
+ */
+static void llc_burst(struct antagonist_thread *a, uint64_t *state)
+{
+    // power of 2 number of lines
+    size_t lines = a->buffer_size / CACHE_LINE_SIZE;
+    size_t mask = 1;
+    while (2 * mask <= lines) {
+        mask *= 2;
+    }
+    mask--;
+
+    uint64_t x = *state;
+    for (size_t i = 0; i < ANTAGONIST_BURST; i++) {
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        *(uint64_t *)(a->buffer + ((x >> 29) & mask) * CACHE_LINE_SIZE) += 1;
+    }
+    *state = x;
+}
+
+/**
+ * random outcomes of direct and indirect (jump table) branches
+ */
+static void branch_burst(uint64_t *state)
+{
+    uint64_t x = *state;
+    uint64_t acc = 0;
+    for (size_t i = 0; i < ANTAGONIST_BURST; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        switch (x & 7) {
+            case 0: acc += x; break;
+            case 1: acc ^= x >> 3; break;
+            case 2: acc -= x << 1; break;
+            case 3: acc = acc * 3 + 1; break;
+            case 4: acc ^= acc >> 11; break;
+            case 5: acc += x >> 17; break;
+            case 6: acc = (acc << 5) | (acc >> 59); break;
+            default: acc -= 7; break;
+        }
+        if (x & 0x100) {
+            acc += i;
+        }
+        else {
+            acc ^= i;
+        }
+    }
+    *state = x;
+    antagonist_sink_ += acc;
+}
+
+/**
+ * independent FMA chains on the widest vectors available with the compiler flags
+ */
+static void avx_burst(void)
+{
+#if defined(__AVX512F__)
+    const __m512d a = _mm512_set1_pd(1.0000001);
+    const __m512d b = _mm512_set1_pd(0.9999999);
+    __m512d c0 = _mm512_set1_pd(1.0);
+    __m512d c1 = c0;
+    __m512d c2 = c0;
+    __m512d c3 = c0;
+    for (size_t i = 0; i < ANTAGONIST_BURST; i++) {
+        c0 = _mm512_fmadd_pd(c0, a, b);
+        c1 = _mm512_fmadd_pd(c1, a, b);
+        c2 = _mm512_fmadd_pd(c2, a, b);
+        c3 = _mm512_fmadd_pd(c3, a, b);
+    }
+    antagonist_sink_ += (uint64_t)_mm512_reduce_add_pd(_mm512_add_pd(_mm512_add_pd(c0, c1), _mm512_add_pd(c2, c3)));
+#elif defined(__AVX2__) && defined(__FMA__)
+    const __m256d a = _mm256_set1_pd(1.0000001);
+    const __m256d b = _mm256_set1_pd(0.9999999);
+    __m256d c0 = _mm256_set1_pd(1.0);
+    __m256d c1 = c0;
+    __m256d c2 = c0;
+    __m256d c3 = c0;
+    for (size_t i = 0; i < ANTAGONIST_BURST; i++) {
+        c0 = _mm256_fmadd_pd(c0, a, b);
+        c1 = _mm256_fmadd_pd(c1, a, b);
+        c2 = _mm256_fmadd_pd(c2, a, b);
+        c3 = _mm256_fmadd_pd(c3, a, b);
+    }
+    double sum[4];
+    _mm256_storeu_pd(sum, _mm256_add_pd(_mm256_add_pd(c0, c1), _mm256_add_pd(c2, c3)));
+    antagonist_sink_ += (uint64_t)(sum[0] + sum[1] + sum[2] + sum[3]);
+#else
+    double c[4] = {1.0, 1.0, 1.0, 1.0};
+    for (size_t i = 0; i < ANTAGONIST_BURST; i++) {
+        for (size_t j = 0; j < 4; j++) {
+            c[j] = c[j] * 1.0000001 + 0.9999999;
+        }
+    }
+    antagonist_sink_ += (uint64_t)(c[0] + c[1] + c[2] + c[3]);
+#endif
+}
+
+static void *antagonist_main(void *arg)
+{
+    struct antagonist_thread *a = arg;
+
+    set_thread_affinity(a->config.cpu);
+
+    // first touch by the pinned thread
+    a->ok = true;
+    if (a->buffer_size > 0) {
+        a->buffer = testbench_alloc_buffer(a->buffer_size, NULL);
+        a->ok = a->buffer != NULL;
+    }
+    __atomic_add_fetch(&antagonists_ready_, 1, __ATOMIC_ACQ_REL);
+    if (!a->ok) {
+        return NULL;
+    }
+
+    const uint64_t period = TESTBENCH_ANTAGONIST_PERIOD_NS;
+    const uint64_t busy = (uint64_t)(a->config.intensity * (double)period);
+    size_t position = 0;
+    uint64_t state = 0x9e3779b97f4a7c15ULL;
+    while (!__atomic_load_n(&antagonists_stop_, __ATOMIC_ACQUIRE)) {
+        uint64_t start = now_ns();
+        uint64_t elapsed = 0;
+        do {
+            switch (a->config.kind) {
+                case TESTBENCH_ANTAGONIST_MEMORY_BANDWIDTH:
+                    bandwidth_burst(a, &position);
+                    break;
+                case TESTBENCH_ANTAGONIST_LLC:
+                    llc_burst(a, &state);
+                    break;
+                case TESTBENCH_ANTAGONIST_BRANCH:
+                    branch_burst(&state);
+                    break;
+                case TESTBENCH_ANTAGONIST_AVX:
+                    avx_burst();
+                    break;
+                default:
+                    assert(false);
+            }
+            elapsed = now_ns() - start;
+        } while (elapsed < busy);
+
+        if (elapsed < period) {
+            uint64_t idle = period - elapsed;
+            struct timespec ts = {
+                .tv_sec = (time_t)(idle / 1000000000),
+                .tv_nsec = (long)(idle % 1000000000)
+            };
+            nanosleep(&ts, NULL);
+        }
+    }
+    return NULL;
+}
+
+static void join_antagonists(size_t n)
+{
+    __atomic_store_n(&antagonists_stop_, 1, __ATOMIC_RELEASE);
+    for (size_t i = 0; i < n; i++) {
+        pthread_join(antagonists_[i].thread, NULL);
+        testbench_free_buffer(antagonists_[i].buffer, antagonists_[i].buffer_size);
+        antagonists_[i].buffer = NULL;
+    }
+}
+
+//--- thread pool ----------------------------------------------------------------------------------
+//    each pool thread has its own mailbox (generation); only the threads needed for a run are
+//    signalled; the job is not modified before all of them are done
+
+struct pool_thread {
+    unsigned generation; // mailbox; own cache line
+    pthread_t thread;
+    size_t index;
+    int cpu;             // -1: not pinned
+} __attribute__((aligned(64)));
+
+static struct pool_thread pool_[TESTBENCH_POOL_MAX_THREADS];
+static size_t pool_n_ = 0; // including the calling thread
+static testbench_parallel_function_t pool_f_ = NULL;
+static void *pool_context_ = NULL;
+static size_t pool_run_threads_ = 0;
+static unsigned pool_generation_ = 0;
+static unsigned pool_pending_ = 0;
+static bool pool_quit_ = false;
+static pthread_mutex_t pool_lock_ = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_wake_ = PTHREAD_COND_INITIALIZER;
+
+static void *pool_main(void *arg)
+{
+    struct pool_thread *t = arg;
+    set_thread_affinity(t->cpu);
+
+    unsigned seen = 0;
+    for (;;) {
+        unsigned spins = 0;
+        while (__atomic_load_n(&t->generation, __ATOMIC_ACQUIRE) == seen && spins < TESTBENCH_POOL_SPIN_LIMIT) {
+            __builtin_ia32_pause();
+            spins++;
+        }
+        if (__atomic_load_n(&t->generation, __ATOMIC_ACQUIRE) == seen) {
+            pthread_mutex_lock(&pool_lock_);
+            while (__atomic_load_n(&t->generation, __ATOMIC_ACQUIRE) == seen) {
+                pthread_cond_wait(&pool_wake_, &pool_lock_);
+            }
+            pthread_mutex_unlock(&pool_lock_);
+        }
+        seen = __atomic_load_n(&t->generation, __ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&pool_quit_, __ATOMIC_ACQUIRE)) {
+            return NULL;
+        }
+        pool_f_(pool_context_, t->index, pool_run_threads_);
+        __atomic_sub_fetch(&pool_pending_, 1, __ATOMIC_RELEASE);
+    }
+}
+
+/**
+ * signals pool threads 1 .. n - 1
+ */
+static void signal_pool(size_t n)
+{
+    for (size_t i = 1; i < n; i++) {
+        __atomic_store_n(&pool_[i].generation, pool_generation_, __ATOMIC_RELEASE);
+    }
+    // for the sleeping ones; the mailboxes are checked under the lock
+    pthread_mutex_lock(&pool_lock_);
+    pthread_cond_broadcast(&pool_wake_);
+    pthread_mutex_unlock(&pool_lock_);
+}
+
+//--- implementation of the public API -------------------------------------------------------------
+//    see header file for information about the functions
+
+size_t testbench_available_cpus(void)
+{
+    static int cpus[TESTBENCH_PARALLEL_MAX_THREADS];
+    return get_cpus(cpus, TESTBENCH_PARALLEL_MAX_THREADS);
+}
+
+int testbench_other_cpu(void)
+{
+#ifdef __linux__
+    static int cpus[TESTBENCH_PARALLEL_MAX_THREADS];
+    size_t n_cpus = get_cpus(cpus, TESTBENCH_PARALLEL_MAX_THREADS);
+    int current = sched_getcpu();
+    for (size_t i = 0; i < n_cpus; i++) {
+        if (cpus[i] != current) {
+            return cpus[i];
+        }
+    }
+#endif
+    return -1;
+}
+
+size_t testbench_run_scaling(testbench_parallel_function_t f, void *context,
+                             const struct testbench_scaling_config *config,
+                             struct testbench_scaling_point *ret_points, size_t max_points)
+{
+    assert(f);
+    assert(config);
+    assert(ret_points);
+
+    static int cpus[TESTBENCH_PARALLEL_MAX_THREADS];
+    size_t n_cpus = get_cpus(cpus, TESTBENCH_PARALLEL_MAX_THREADS);
+
+    size_t min_threads = config->min_threads ? config->min_threads : 1;
+    size_t max_threads = config->max_threads ? config->max_threads : n_cpus;
+    if (max_threads > TESTBENCH_PARALLEL_MAX_THREADS) {
+        max_threads = TESTBENCH_PARALLEL_MAX_THREADS;
+    }
+    if (min_threads > max_threads) {
+        return 0;
+    }
+    size_t rounds = config->rounds ? config->rounds : TESTBENCH_STD_N;
+    double work_per_call = config->work_per_call > 0.0 ? config->work_per_call : 1.0;
+
+    set_denominator(1);
+
+    size_t n_points = 0;
+    size_t n_threads = min_threads;
+    while (n_points < max_points) {
+        struct testbench_scaling_point *point = &ret_points[n_points];
+        if (!run_point(f, context, n_threads, rounds, cpus, n_cpus, config->pin, work_per_call, point)) {
+            testbench_free_scaling(ret_points, n_points);
+            return 0;
+        }
+        n_points++;
+
+        if (n_threads == max_threads) {
+            break;
+        }
+        n_threads = config->step ? n_threads + config->step : 2 * n_threads;
+        if (n_threads > max_threads) {
+            n_threads = max_threads;
+        }
+    }
+
+    // relative to the throughput per thread of the first thread count
+    double base = ret_points[0].throughput / (double)ret_points[0].n_threads;
+    for (size_t i = 0; i < n_points; i++) {
+        struct testbench_scaling_point *point = &ret_points[i];
+        point->speedup = base > 0.0 ? point->throughput / base : 0.0;
+        point->efficiency = point->speedup / (double)point->n_threads;
+    }
+
+    return n_points;
+}
+
+void testbench_free_scaling(struct testbench_scaling_point *points, size_t n_points)
+{
+    assert(points || n_points == 0);
+
+    for (size_t i = 0; i < n_points; i++) {
+        free(points[i].threads);
+        points[i].threads = NULL;
+    }
+}
+
+bool fprint_testbench_scaling(FILE *stream, const char *title,
+                              const struct testbench_scaling_point *points, size_t n_points,
+                              const struct testbench_scaling_config *config,
+                              const struct testbench_time_unit *unit)
+{
+    assert(stream);
+    assert(points || n_points == 0);
+    assert(config);
+    // title and unit are optional
+
+    int ret = 0;
+    if (title) {
+        ret = fprintf(stream, "\n%s:\n", title);
+        if (ret < 0) {
+            return false;
+        }
+    }
+
+    const char *unit_name = "cycles";
+    double cpu = 1.0;
+    if (unit) {
+        unit_name = unit->name;
+        cpu = (double)unit->cycles_per_unit;
+    }
+
+    const char *work_unit = config->work_unit ? config->work_unit : "calls";
+    struct testbench_environment env = testbench_get_environment();
+    double per = 1000.0;
+    const char *per_name = "kcycle";
+    if (env.captured && env.tsc_ghz > 0.0) {
+        per = env.tsc_ghz * 1e9;
+        per_name = "s";
+    }
+
+    ret = fprintf(stream, "- threads   throughput [%s/%s]   speedup   efficiency   wall median [%s]\n",
+                  work_unit, per_name, unit_name);
+    if (ret < 0) {
+        return false;
+    }
+
+    for (size_t i = 0; i < n_points; i++) {
+        const struct testbench_scaling_point *p = &points[i];
+        ret = fprintf(stream, "  %7zu   %16.4g   %7.2f   %10.2f   %.1f\n",
+                      p->n_threads, p->throughput * per, p->speedup, p->efficiency, p->wall.median / cpu);
+        if (ret < 0) {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < n_points; i++) {
+        const struct testbench_scaling_point *p = &points[i];
+        ret = fprintf(stream, "- %zu thread(s): wall median %.1f %s, IQR [%.1f, %.1f], n=%zu\n",
+                      p->n_threads, p->wall.median / cpu, unit_name, p->wall.q1 / cpu, p->wall.q3 / cpu,
+                      p->wall.count);
+        if (ret < 0) {
+            return false;
+        }
+
+        for (size_t t = 0; t < p->n_threads; t++) {
+            const struct testbench_statistics *l = &p->threads[t].latency;
+            ret = fprintf(stream, "  thread %zu (cpu %d): median %.1f %s, IQR [%.1f, %.1f], min %.1f, max %.1f, n=%zu\n",
+                          t, p->threads[t].cpu, l->median / cpu, unit_name, l->q1 / cpu, l->q3 / cpu,
+                          l->min / cpu, l->max / cpu, l->count);
+            if (ret < 0) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool testbench_start_antagonists(const struct testbench_antagonist *antagonists, size_t n)
+{
+    assert(antagonists || n == 0);
+
+    if (antagonists_n_ > 0 || n > TESTBENCH_MAX_ANTAGONISTS) {
+        return false;
+    }
+
+    antagonists_stop_ = 0;
+    antagonists_ready_ = 0;
+    antagonists_note_[0] = '\0';
+    size_t created = 0;
+    for (; created < n; created++) {
+        struct antagonist_thread *a = &antagonists_[created];
+        memset(a, 0, sizeof(*a));
+        a->config = antagonists[created];
+        if (!(a->config.intensity > 0.0) || a->config.intensity > 1.0) {
+            a->config.intensity = 1.0;
+        }
+        if (a->config.kind == TESTBENCH_ANTAGONIST_MEMORY_BANDWIDTH) {
+            a->buffer_size = a->config.buffer_size ? a->config.buffer_size : TESTBENCH_ANTAGONIST_BANDWIDTH_SIZE;
+        }
+        else if (a->config.kind == TESTBENCH_ANTAGONIST_LLC) {
+            a->buffer_size = a->config.buffer_size ? a->config.buffer_size : testbench_llc_size();
+        }
+        if (a->buffer_size > 0 && a->buffer_size < CACHE_LINE_SIZE) {
+            a->buffer_size = CACHE_LINE_SIZE;
+        }
+        if (pthread_create(&a->thread, NULL, antagonist_main, a) != 0) {
+            break;
+        }
+    }
+
+    // wait until all are running
+    while (__atomic_load_n(&antagonists_ready_, __ATOMIC_ACQUIRE) < created) {
+        sched_yield();
+    }
+
+    bool ok = created == n;
+    for (size_t i = 0; i < created; i++) {
+        ok = ok && antagonists_[i].ok;
+    }
+    if (!ok) {
+        join_antagonists(created);
+        return false;
+    }
+    antagonists_n_ = n;
+
+    // conditions note, e.g. "antagonists: memory bandwidth (cpu 1, 100 %), branch (unpinned, 50 %)"
+    size_t length = (size_t)snprintf(antagonists_note_, sizeof(antagonists_note_), "antagonists:");
+    for (size_t i = 0; i < n && length < sizeof(antagonists_note_); i++) {
+        const struct testbench_antagonist *c = &antagonists_[i].config;
+        char cpu[32] = "unpinned";
+        if (c->cpu >= 0) {
+            snprintf(cpu, sizeof(cpu), "cpu %d", c->cpu);
+        }
+        length += (size_t)snprintf(antagonists_note_ + length, sizeof(antagonists_note_) - length,
+                                   "%s %s (%s, %.0f %%)", i > 0 ? "," : "", antagonist_name(c->kind),
+                                   cpu, 100.0 * c->intensity);
+    }
+    if (n > 0) {
+        set_conditions_note(antagonists_note_, true);
+    }
+    return true;
+}
+
+void testbench_stop_antagonists(void)
+{
+    if (antagonists_n_ == 0) {
+        return;
+    }
+
+    join_antagonists(antagonists_n_);
+    antagonists_n_ = 0;
+
+    // reported for the values measured so far; cleared by the next reset
+    set_conditions_note(antagonists_note_, false);
+}
+
+bool testbench_pool_create(size_t n_threads, bool pin)
+{
+    if (pool_n_ > 0) {
+        return false;
+    }
+
+    int cpus[TESTBENCH_POOL_MAX_THREADS];
+    size_t n_cpus = get_cpus(cpus, TESTBENCH_POOL_MAX_THREADS);
+    if (n_threads == 0) {
+        n_threads = n_cpus;
+    }
+    if (n_threads > TESTBENCH_POOL_MAX_THREADS) {
+        n_threads = TESTBENCH_POOL_MAX_THREADS;
+    }
+
+    pool_generation_ = 0;
+    pool_quit_ = false;
+    pool_n_ = 1;
+    for (size_t i = 1; i < n_threads; i++) {
+        pool_[i].index = i;
+        pool_[i].cpu = pin && i < n_cpus ? cpus[i] : -1;
+        pool_[i].generation = 0;
+        if (pthread_create(&pool_[i].thread, NULL, pool_main, &pool_[i]) != 0) {
+            testbench_pool_delete();
+            return false;
+        }
+        pool_n_++;
+    }
+
+#ifdef __linux__
+    // the calling thread is thread 0; pinned after the pool threads have been created
+    // (they would inherit its mask)
+    if (pin && sched_getaffinity(0, sizeof(caller_mask_), &caller_mask_) == 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpus[0], &set);
+        caller_pinned_ = pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+    }
+#endif
+    return true;
+}
+
+void testbench_pool_delete(void)
+{
+    if (pool_n_ == 0) {
+        return;
+    }
+    __atomic_store_n(&pool_quit_, true, __ATOMIC_RELEASE);
+    pool_generation_++;
+    signal_pool(pool_n_);
+    for (size_t i = 1; i < pool_n_; i++) {
+        pthread_join(pool_[i].thread, NULL);
+    }
+    pool_n_ = 0;
+
+#ifdef __linux__
+    if (caller_pinned_) {
+        pthread_setaffinity_np(pthread_self(), sizeof(caller_mask_), &caller_mask_);
+        caller_pinned_ = false;
+    }
+#endif
+}
+
+size_t testbench_pool_threads(void)
+{
+    return pool_n_;
+}
+
+void testbench_pool_run(testbench_parallel_function_t f, void *context, size_t n_threads)
+{
+    assert(f);
+
+    size_t pool = pool_n_ > 0 ? pool_n_ : 1; // without a pool: the calling thread only
+    if (n_threads == 0 || n_threads > pool) {
+        n_threads = pool;
+    }
+    if (n_threads == 1) {
+        f(context, 0, 1);
+        return;
+    }
+
+    pool_f_ = f;
+    pool_context_ = context;
+    pool_run_threads_ = n_threads;
+    __atomic_store_n(&pool_pending_, (unsigned)(n_threads - 1), __ATOMIC_RELAXED);
+    pool_generation_++;
+    signal_pool(n_threads);
+
+    f(context, 0, n_threads);
+
+    // the pool threads may need this CPU (more threads than CPUs)
+    unsigned spins = 0;
+    while (__atomic_load_n(&pool_pending_, __ATOMIC_ACQUIRE) > 0) {
+        __builtin_ia32_pause();
+        if (++spins >= TESTBENCH_SPIN_YIELD_LIMIT) {
+            sched_yield();
+            spins = 0;
+        }
+    }
+}
@@ -0,0 +1,240 @@
+/**
+ * Scaling harness for the benchmark library: runs a function on 1..N threads
+ *  Optional module; needs benchmark.c/h and pthreads (compile and link with -pthread).
+ *
+ *  For each number of threads:
+ *  - the threads are pinned to the CPUs of the affinity mask of the process (Linux)
+ *  - each round starts all threads at once off a spin barrier; each thread calls
+ *    the function once and records its own start/stop (RDTSC) in its own buffer
+ *  - wall time of a round: from the first start to the last stop of all threads
+ *    (note: assumes a TSC that is synchronized across the cores, i.e. invariant TSC)
+ *  - after the run, the samples of each thread and the wall times are analyzed one
+ *    after the other by the (single) testbench; thus, create_testbench() must have been
+ *    called with a capacity of at least the number of rounds
+ *
+ *  Reported: aggregate throughput (work of all threads per wall time), speedup and
+ *  parallel efficiency relative to the throughput per thread of the first thread count,
+ *  wall time and per-thread latency distributions.
+ *
+ *  Each thread does the same work per call (weak scaling). For strong scaling, the
+ *  function can split the work using thread_index and n_threads.
+ *
+ *  Antagonists: co-runner threads that disturb the measurement in a defined way
+ *  (noisy neighbours), see testbench_start_antagonists().
+ *
+ *  Thread pool: persistent threads for parallel code under test (e.g. a parallel copy or
+ *  a tiled matrix multiplication), see testbench_pool_create().
+ *
+ *  MIT License (see benchmark.h)
+ */
+
+#ifndef BENCHMARK_PARALLEL_BENCHMARK_H_
+#define BENCHMARK_PARALLEL_BENCHMARK_H_
+
+#include "benchmark.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// IMPORTANT: do not forget to re-compile parallel_benchmark.c if you have changed these
+
+#define TESTBENCH_PARALLEL_MAX_THREADS 256
+
+/**
+ * untimed rounds before the measured rounds of each thread count
+ */
+#define TESTBENCH_PARALLEL_WARMUP_ROUNDS 1
+
+/**
+ * waiting threads spin with PAUSE; after this number of iterations they yield the CPU
+ * (only relevant if there are more threads than CPUs)
+ */
+#define TESTBENCH_SPIN_YIELD_LIMIT (1 << 16)
+
+/**
+ * \param context       as passed to testbench_run_scaling() or testbench_pool_run()
+ * \param thread_index  0 .. n_threads - 1
+ * \param n_threads     number of threads of this round
+ */
+typedef void (*testbench_parallel_function_t)(void *context, size_t thread_index, size_t n_threads);
+
+struct testbench_scaling_config {
+    size_t min_threads;    // 0: 1
+    size_t max_threads;    // 0: number of CPUs in the affinity mask; at most TESTBENCH_PARALLEL_MAX_THREADS
+    size_t step;           // thread count increment; 0: doubling (max_threads is always included)
+    size_t rounds;         // measured rounds per thread count; 0: TESTBENCH_STD_N
+    bool pin;              // pin thread i to the i-th CPU of the affinity mask
+    double work_per_call;  // work units of one call per thread (e.g. bytes, flop); 0: 1 call
+    const char *work_unit; // NULL: "calls"
+};
+
+struct testbench_thread_result {
+    int cpu; // CPU at the end of the run; -1 unknown
+    struct testbench_statistics latency;
+};
+
+struct testbench_scaling_point {
+    size_t n_threads;
+    struct testbench_statistics wall; // cycles per round
+    double throughput;                // work units per cycle (median wall time)
+    double speedup;
+    double efficiency;                // speedup / n_threads
+    struct testbench_thread_result *threads; // n_threads entries
+};
+
+/**
+ * \return  number of CPUs in the affinity mask of the process (Linux); online CPUs otherwise
+ */
+size_t testbench_available_cpus(void);
+
+/**
+ * \return  a CPU of the affinity mask of the process other than the one the calling thread
+ *          runs on (e.g. for an antagonist); -1 if there is none or on other systems
+ */
+int testbench_other_cpu(void);
+
+/**
+ * \param f           function to be measured
+ * \param context     optional; passed to f
+ * \param config      configuration; see above for defaults
+ * \param ret_points  array for the results (one per thread count)
+ * \param max_points  capacity of ret_points
+ * \return            number of results; 0 in case of errors (memory, threads, capacity of the testbench)
+ *
+ * notes:
+ * - sets the denominator to 1
+ * - the stored values of the testbench are replaced (the wall times of the last thread count are kept)
+ * - the results must be released with testbench_free_scaling()
+ */
+size_t testbench_run_scaling(testbench_parallel_function_t f, void *context,
+                             const struct testbench_scaling_config *config,
+                             struct testbench_scaling_point *ret_points, size_t max_points);
+
+/**
+ * frees the per-thread results
+ */
+void testbench_free_scaling(struct testbench_scaling_point *points, size_t n_points);
+
+/**
+ * \param stream    FILE object
+ * \param title     optional; none is used if NULL
+ * \param points    results of testbench_run_scaling()
+ * \param n_points  number of results
+ * \param config    the configuration used (work unit)
+ * \param unit      optional; cycles are used if NULL (latencies and wall time)
+ * \return          true if successful without I/O errors; false otherwise
+ *
+ * Prints a table of throughput, speedup and efficiency, followed by the wall time and
+ * the latency distribution of each thread.
+ * Throughput is given per second if the TSC frequency is known (environment captured),
+ * per 1000 cycles otherwise.
+ */
+bool fprint_testbench_scaling(FILE *stream, const char *title,
+                              const struct testbench_scaling_point *points, size_t n_points,
+                              const struct testbench_scaling_config *config,
+                              const struct testbench_time_unit *unit);
+
+/**
+ * No return value (for consistency with the other print functions)
+ */
+static inline void print_testbench_scaling(const char *title,
+                                           const struct testbench_scaling_point *points, size_t n_points,
+                                           const struct testbench_scaling_config *config,
+                                           const struct testbench_time_unit *unit)
+{
+    fprint_testbench_scaling(stdout, title, points, n_points, config, unit);
+}
+
+/**
+ * Antagonists (co-runners) run in their own threads while measuring:
+ * - MEMORY_BANDWIDTH: streams read-modify-write over a buffer (default
+ *   TESTBENCH_ANTAGONIST_BANDWIDTH_SIZE) that is larger than the LLC
+ * - LLC:              random accesses within a buffer of LLC size (default
+ *                     testbench_llc_size()); evicts the data of the code under test
+ * - BRANCH:           data dependent branches on random values at many branch sites;
+ *                     pollutes the branch predictor (if on the same core, e.g. SMT sibling)
+ * - AVX:              FMA loop on the widest available vectors (AVX-512, AVX2, scalar);
+ *                     may lower the core frequency (license based downclocking)
+ * Intensity is the duty cycle within periods of TESTBENCH_ANTAGONIST_PERIOD_NS (1.0: always busy).
+ * The active antagonists are reported as conditions note of the statistics.
+ */
+enum testbench_antagonist_kind {
+    TESTBENCH_ANTAGONIST_MEMORY_BANDWIDTH,
+    TESTBENCH_ANTAGONIST_LLC,
+    TESTBENCH_ANTAGONIST_BRANCH,
+    TESTBENCH_ANTAGONIST_AVX
+};
+
+#define TESTBENCH_MAX_ANTAGONISTS 16
+#define TESTBENCH_ANTAGONIST_PERIOD_NS 1000000
+#define TESTBENCH_ANTAGONIST_BANDWIDTH_SIZE (256 * 1024 * 1024)
+
+struct testbench_antagonist {
+    enum testbench_antagonist_kind kind;
+    int cpu;            // pinned to this CPU; -1: not pinned
+    double intensity;   // 0 < intensity <= 1
+    size_t buffer_size; // MEMORY_BANDWIDTH and LLC; 0: default size
+};
+
+/**
+ * \param antagonists  array of antagonists
+ * \param n            array size; at most TESTBENCH_MAX_ANTAGONISTS
+ * \return             true if successful; false otherwise (memory, threads, already running)
+ *
+ * Starts the antagonists and returns after all of them are running (buffers allocated).
+ * Sets the conditions note (see set_conditions_note()); it is kept until
+ * testbench_stop_antagonists() and the following reset_testbench().
+ */
+bool testbench_start_antagonists(const struct testbench_antagonist *antagonists, size_t n);
+
+/**
+ * stops the running antagonists and frees their buffers
+ */
+void testbench_stop_antagonists(void);
+
+/**
+ * Thread pool: the calling thread takes part in each run as thread 0; the pool threads
+ * 1 .. n - 1 are created once and woken per run:
+ * - each pool thread has its own mailbox; only the threads needed for a run are signalled
+ * - idle pool threads spin with PAUSE for TESTBENCH_POOL_SPIN_LIMIT iterations (the next
+ *   run often follows immediately) and sleep on a condition variable afterwards
+ * - pin: thread i is pinned to the i-th CPU of the affinity mask (Linux), including the
+ *   calling thread, which gets its mask back with testbench_pool_delete(); meanwhile,
+ *   the threads of this module use the mask of the process; other new threads inherit the
+ *   pinned mask of the calling thread
+ * One pool per process, used by one thread at a time.
+ */
+#define TESTBENCH_POOL_MAX_THREADS 64
+#define TESTBENCH_POOL_SPIN_LIMIT (1 << 14)
+
+/**
+ * \param n_threads  number of threads including the calling thread; 0: number of CPUs
+ *                   in the affinity mask; at most TESTBENCH_POOL_MAX_THREADS
+ * \param pin        pin thread i to the i-th CPU of the affinity mask (see above)
+ * \return           true if successful; false otherwise (threads, already created)
+ */
+bool testbench_pool_create(size_t n_threads, bool pin);
+
+/**
+ * stops and joins the pool threads; restores the affinity mask of the calling thread
+ */
+void testbench_pool_delete(void);
+
+/**
+ * \return  number of threads of the pool including the calling thread; 0 if not created
+ */
+size_t testbench_pool_threads(void);
+
+/**
+ * \param f          called as f(context, i, n_threads) on the threads i = 0 .. n_threads - 1
+ *                   of the pool; i = 0 is the calling thread
+ * \param context    optional; passed to f
+ * \param n_threads  0: all threads of the pool; limited by the pool size
+ *
+ * Returns after all threads are done. Without a pool, the calling thread runs f(context, 0, 1).
+ */
+void testbench_pool_run(testbench_parallel_function_t f, void *context, size_t n_threads);
+
+#endif // BENCHMARK_PARALLEL_BENCHMARK_H_
@@ -0,0 +1,402 @@
+/* Copy and set kernels with runtime CPU dispatch; see copy_kernels.h
+*/
+
+#include <stdint.h>
+#include <string.h>
+
+#include "copy_kernels.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define COPY_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+//--- small sizes ----------------------------------------------------------------
+//    n < 64: two overlapping moves of the largest power of 2 <= n; no loops
+//    (a loop could be turned into a call of memcpy()/memset() by the compiler)
+
+#define DEFINE_MOVE(bytes) \
+    struct block##bytes { char b[bytes]; }; \
+    static inline void move##bytes(char *d, const char *s) { \
+        struct block##bytes t; \
+        memcpy(&t, s, bytes); \
+        memcpy(d, &t, bytes); \
+    }
+
+DEFINE_MOVE(2)
+DEFINE_MOVE(4)
+DEFINE_MOVE(8)
+DEFINE_MOVE(16)
+DEFINE_MOVE(32)
+
+static inline void copy_small(char *d, const char *s, size_t n) {
+    if (n >= 32) {
+        move32(d, s);
+        move32(d + n - 32, s + n - 32);
+    }
+    else if (n >= 16) {
+        move16(d, s);
+        move16(d + n - 16, s + n - 16);
+    }
+    else if (n >= 8) {
+        move8(d, s);
+        move8(d + n - 8, s + n - 8);
+    }
+    else if (n >= 4) {
+        move4(d, s);
+        move4(d + n - 4, s + n - 4);
+    }
+    else if (n >= 2) {
+        move2(d, s);
+        move2(d + n - 2, s + n - 2);
+    }
+    else if (n == 1) {
+        d[0] = s[0];
+    }
+}
+
+static inline void set_small(char *d, int c, size_t n) {
+    char pattern[32];
+    memset(pattern, c, sizeof(pattern)); // constant size: inlined
+    copy_small(d, pattern, n);
+}
+
+//--- generic --------------------------------------------------------------------
+
+// GCC would replace the loops by calls of memcpy()/memset()
+#if defined(__GNUC__) && !defined(__clang__)
+#define NO_LIBC_PATTERNS __attribute__((optimize("no-tree-loop-distribute-patterns")))
+#else
+#define NO_LIBC_PATTERNS
+#endif
+
+NO_LIBC_PATTERNS
+static void *copy_loop(void *restrict dest, const void *restrict src, size_t n) {
+    char *d = dest;
+    const char *s = src;
+    for (size_t i = 0; i < n; i++) {
+        d[i] = s[i];
+    }
+    return dest;
+}
+
+NO_LIBC_PATTERNS
+static void *set_loop(void *dest, int c, size_t n) {
+    char *d = dest;
+    for (size_t i = 0; i < n; i++) {
+        d[i] = (char)c;
+    }
+    return dest;
+}
+
+#ifdef COPY_KERNELS_X86
+
+//--- SSE2 -----------------------------------------------------------------------
+
+__attribute__((target("sse2")))
+static void *copy_sse2(void *restrict dest, const void *restrict src, size_t n) {
+    char *d = dest;
+    const char *s = src;
+    if (n < 16) {
+        copy_small(d, s, n);
+        return dest;
+    }
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        __m128i v0 = _mm_loadu_si128((const __m128i *)(s + i));
+        __m128i v1 = _mm_loadu_si128((const __m128i *)(s + i + 16));
+        __m128i v2 = _mm_loadu_si128((const __m128i *)(s + i + 32));
+        __m128i v3 = _mm_loadu_si128((const __m128i *)(s + i + 48));
+        _mm_storeu_si128((__m128i *)(d + i), v0);
+        _mm_storeu_si128((__m128i *)(d + i + 16), v1);
+        _mm_storeu_si128((__m128i *)(d + i + 32), v2);
+        _mm_storeu_si128((__m128i *)(d + i + 48), v3);
+    }
+    for (; i + 16 <= n; i += 16) {
+        _mm_storeu_si128((__m128i *)(d + i), _mm_loadu_si128((const __m128i *)(s + i)));
+    }
+    if (i < n) {
+        _mm_storeu_si128((__m128i *)(d + n - 16), _mm_loadu_si128((const __m128i *)(s + n - 16)));
+    }
+    return dest;
+}
+
+__attribute__((target("sse2")))
+static void *set_sse2(void *dest, int c, size_t n) {
+    char *d = dest;
+    if (n < 16) {
+        set_small(d, c, n);
+        return dest;
+    }
+    __m128i v = _mm_set1_epi8((char)c);
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        _mm_storeu_si128((__m128i *)(d + i), v);
+        _mm_storeu_si128((__m128i *)(d + i + 16), v);
+        _mm_storeu_si128((__m128i *)(d + i + 32), v);
+        _mm_storeu_si128((__m128i *)(d + i + 48), v);
+    }
+    for (; i + 16 <= n; i += 16) {
+        _mm_storeu_si128((__m128i *)(d + i), v);
+    }
+    if (i < n) {
+        _mm_storeu_si128((__m128i *)(d + n - 16), v);
+    }
+    return dest;
+}
+
+__attribute__((target("sse2")))
+static void *copy_nt_sse2(void *restrict dest, const void *restrict src, size_t n) {
+    char *d = dest;
+    const char *s = src;
+    if (n < 64) {
+        copy_small(d, s, n);
+        return dest;
+    }
+    size_t i = (16 - ((uintptr_t)d & 15)) & 15;
+    copy_small(d, s, i);
+    for (; i + 16 <= n; i += 16) {
+        _mm_stream_si128((__m128i *)(d + i), _mm_loadu_si128((const __m128i *)(s + i)));
+    }
+    _mm_sfence();
+    copy_small(d + i, s + i, n - i);
+    return dest;
+}
+
+__attribute__((target("sse2")))
+static void *set_nt_sse2(void *dest, int c, size_t n) {
+    char *d = dest;
+    if (n < 64) {
+        set_small(d, c, n);
+        return dest;
+    }
+    __m128i v = _mm_set1_epi8((char)c);
+    size_t i = (16 - ((uintptr_t)d & 15)) & 15;
+    set_small(d, c, i);
+    for (; i + 16 <= n; i += 16) {
+        _mm_stream_si128((__m128i *)(d + i), v);
+    }
+    _mm_sfence();
+    set_small(d + i, c, n - i);
+    return dest;
+}
+
+//--- AVX2 -----------------------------------------------------------------------
+
+__attribute__((target("avx2")))
+static void *copy_avx2(void *restrict dest, const void *restrict src, size_t n) {
+    char *d = dest;
+    const char *s = src;
+    if (n < 32) {
+        copy_small(d, s, n);
+        return dest;
+    }
+    size_t i = 0;
+    for (; i + 128 <= n; i += 128) {
+        __m256i v0 = _mm256_loadu_si256((const __m256i *)(s + i));
+        __m256i v1 = _mm256_loadu_si256((const __m256i *)(s + i + 32));
+        __m256i v2 = _mm256_loadu_si256((const __m256i *)(s + i + 64));
+        __m256i v3 = _mm256_loadu_si256((const __m256i *)(s + i + 96));
+        _mm256_storeu_si256((__m256i *)(d + i), v0);
+        _mm256_storeu_si256((__m256i *)(d + i + 32), v1);
+        _mm256_storeu_si256((__m256i *)(d + i + 64), v2);
+        _mm256_storeu_si256((__m256i *)(d + i + 96), v3);
+    }
+    for (; i + 32 <= n; i += 32) {
+        _mm256_storeu_si256((__m256i *)(d + i), _mm256_loadu_si256((const __m256i *)(s + i)));
+    }
+    if (i < n) {
+        _mm256_storeu_si256((__m256i *)(d + n - 32), _mm256_loadu_si256((const __m256i *)(s + n - 32)));
+    }
+    return dest;
+}
+
+__attribute__((target("avx2")))
+static void *set_avx2(void *dest, int c, size_t n) {
+    char *d = dest;
+    if (n < 32) {
+        set_small(d, c, n);
+        return dest;
+    }
+    __m256i v = _mm256_set1_epi8((char)c);
+    size_t i = 0;
+    for (; i + 128 <= n; i += 128) {
+        _mm256_storeu_si256((__m256i *)(d + i), v);
+        _mm256_storeu_si256((__m256i *)(d + i + 32), v);
+        _mm256_storeu_si256((__m256i *)(d + i + 64), v);
+        _mm256_storeu_si256((__m256i *)(d + i + 96), v);
+    }
+    for (; i + 32 <= n; i += 32) {
+        _mm256_storeu_si256((__m256i *)(d + i), v);
+    }
+    if (i < n) {
+        _mm256_storeu_si256((__m256i *)(d + n - 32), v);
+    }
+    return dest;
+}
+
+__attribute__((target("avx2")))
+static void *copy_nt_avx2(void *restrict dest, const void *restrict src, size_t n) {
+    char *d = dest;
+    const char *s = src;
+    if (n < 128) {
+        return copy_avx2(dest, src, n);
+    }
+    size_t i = (32 - ((uintptr_t)d & 31)) & 31;
+    copy_small(d, s, i);
+    for (; i + 128 <= n; i += 128) {
+        __m256i v0 = _mm256_loadu_si256((const __m256i *)(s + i));
+        __m256i v1 = _mm256_loadu_si256((const __m256i *)(s + i + 32));
+        __m256i v2 = _mm256_loadu_si256((const __m256i *)(s + i + 64));
+        __m256i v3 = _mm256_loadu_si256((const __m256i *)(s + i + 96));
+        _mm256_stream_si256((__m256i *)(d + i), v0);
+        _mm256_stream_si256((__m256i *)(d + i + 32), v1);
+        _mm256_stream_si256((__m256i *)(d + i + 64), v2);
+        _mm256_stream_si256((__m256i *)(d + i + 96), v3);
+    }
+    for (; i + 32 <= n; i += 32) {
+        _mm256_stream_si256((__m256i *)(d + i), _mm256_loadu_si256((const __m256i *)(s + i)));
+    }
+    _mm_sfence();
+    copy_small(d + i, s + i, n - i);
+    return dest;
+}
+
+__attribute__((target("avx2")))
+static void *set_nt_avx2(void *dest, int c, size_t n) {
+    char *d = dest;
+    if (n < 128) {
+        return set_avx2(dest, c, n);
+    }
+    __m256i v = _mm256_set1_epi8((char)c);
+    size_t i = (32 - ((uintptr_t)d & 31)) & 31;
+    set_small(d, c, i);
+    for (; i + 32 <= n; i += 32) {
+        _mm256_stream_si256((__m256i *)(d + i), v);
+    }
+    _mm_sfence();
+    set_small(d + i, c, n - i);
+    return dest;
+}
+
+//--- AVX-512 --------------------------------------------------------------------
+
+__attribute__((target("avx512f")))
+static void *copy_avx512(void *restrict dest, const void *restrict src, size_t n) {
+    char *d = dest;
+    const char *s = src;
+    if (n < 64) {
+        copy_small(d, s, n);
+        return dest;
+    }
+    size_t i = 0;
+    for (; i + 256 <= n; i += 256) {
+        __m512i v0 = _mm512_loadu_si512((const void *)(s + i));
+        __m512i v1 = _mm512_loadu_si512((const void *)(s + i + 64));
+        __m512i v2 = _mm512_loadu_si512((const void *)(s + i + 128));
+        __m512i v3 = _mm512_loadu_si512((const void *)(s + i + 192));
+        _mm512_storeu_si512((void *)(d + i), v0);
+        _mm512_storeu_si512((void *)(d + i + 64), v1);
+        _mm512_storeu_si512((void *)(d + i + 128), v2);
+        _mm512_storeu_si512((void *)(d + i + 192), v3);
+    }
+    for (; i + 64 <= n; i += 64) {
+        _mm512_storeu_si512((void *)(d + i), _mm512_loadu_si512((const void *)(s + i)));
+    }
+    if (i < n) {
+        _mm512_storeu_si512((void *)(d + n - 64), _mm512_loadu_si512((const void *)(s + n - 64)));
+    }
+    return dest;
+}
+
+__attribute__((target("avx512f")))
+static void *set_avx512(void *dest, int c, size_t n) {
+    char *d = dest;
+    if (n < 64) {
+        set_small(d, c, n);
+        return dest;
+    }
+    __m512i v = _mm512_set1_epi32((int)(0x01010101u * (unsigned char)c));
+    size_t i = 0;
+    for (; i + 256 <= n; i += 256) {
+        _mm512_storeu_si512((void *)(d + i), v);
+        _mm512_storeu_si512((void *)(d + i + 64), v);
+        _mm512_storeu_si512((void *)(d + i + 128), v);
+        _mm512_storeu_si512((void *)(d + i + 192), v);
+    }
+    for (; i + 64 <= n; i += 64) {
+        _mm512_storeu_si512((void *)(d + i), v);
+    }
+    if (i < n) {
+        _mm512_storeu_si512((void *)(d + n - 64), v);
+    }
+    return dest;
+}
+
+//--- rep movsb / stosb ----------------------------------------------------------
+
+static void *copy_rep(void *restrict dest, const void *restrict src, size_t n) {
+    void *d = dest;
+    __asm__ __volatile__("rep movsb" : "+D"(d), "+S"(src), "+c"(n) : : "memory");
+    return dest;
+}
+
+static void *set_rep(void *dest, int c, size_t n) {
+    void *d = dest;
+    __asm__ __volatile__("rep stosb" : "+D"(d), "+c"(n) : "a"(c) : "memory");
+    return dest;
+}
+
+#endif // COPY_KERNELS_X86
+
+//--- dispatch -------------------------------------------------------------------
+
+static struct copy_kernel kernels_[COPY_KERNELS_MAX];
+static size_t n_kernels_ = 0;
+
+static void add_kernel(const char *name, copy_kernel_copy_t copy, copy_kernel_set_t set) {
+    kernels_[n_kernels_].name = name;
+    kernels_[n_kernels_].copy = copy;
+    kernels_[n_kernels_].set = set;
+    n_kernels_++;
+}
+
+size_t copy_kernels_available(const struct copy_kernel **ret_kernels) {
+    // note: the first call is not thread safe
+    if (n_kernels_ == 0) {
+        add_kernel("libc", memcpy, memset);
+        add_kernel("loop", copy_loop, set_loop);
+#ifdef COPY_KERNELS_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("sse2")) {
+            add_kernel("sse2", copy_sse2, set_sse2);
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            add_kernel("avx2", copy_avx2, set_avx2);
+        }
+        if (__builtin_cpu_supports("avx512f")) {
+            add_kernel("avx512", copy_avx512, set_avx512);
+        }
+        add_kernel("rep", copy_rep, set_rep);
+        if (__builtin_cpu_supports("avx2")) {
+            add_kernel("nt-avx2", copy_nt_avx2, set_nt_avx2);
+        }
+        else if (__builtin_cpu_supports("sse2")) {
+            add_kernel("nt-sse2", copy_nt_sse2, set_nt_sse2);
+        }
+#endif
+    }
+    *ret_kernels = kernels_;
+    return n_kernels_;
+}
+
+copy_kernel_copy_t copy_kernel_non_temporal(void) {
+    const struct copy_kernel *kernels = NULL;
+    size_t n = copy_kernels_available(&kernels);
+    for (size_t k = 0; k < n; k++) {
+        if (strncmp(kernels[k].name, "nt", 2) == 0) {
+            return kernels[k].copy;
+        }
+    }
+    return memcpy;
+}
@@ -0,0 +1,44 @@
+/* Copy and set kernels (memcpy / memset variants) with runtime CPU dispatch.
+
+   Kernels (x86; availability checked at runtime):
+   - libc:    memcpy() / memset()
+   - loop:    plain byte loop; code generated by the compiler (may be vectorized)
+   - sse2, avx2, avx512: unaligned vector loads/stores, 4x unrolled; the tail is
+              handled by one overlapping vector at the end
+   - rep:     rep movsb / rep stosb (fast with ERMS/FSRM)
+   - nt:      non-temporal (streaming) stores on AVX2 (SSE2 if not available);
+              the destination is aligned first; followed by sfence
+   Other architectures: libc and loop only.
+
+   The kernels have the signature of memcpy() / memset(); source and destination
+   must not overlap.
+*/
+
+#ifndef COPY_KERNELS_H_
+#define COPY_KERNELS_H_
+
+#include <stddef.h>
+
+typedef void *(*copy_kernel_copy_t)(void *restrict dest, const void *restrict src, size_t n);
+typedef void *(*copy_kernel_set_t)(void *dest, int c, size_t n);
+
+struct copy_kernel {
+    const char *name;
+    copy_kernel_copy_t copy;
+    copy_kernel_set_t set;
+};
+
+#define COPY_KERNELS_MAX 8
+
+/**
+ * \param ret_kernels  set to a static array of the kernels available on this CPU
+ * \return             number of available kernels
+ */
+size_t copy_kernels_available(const struct copy_kernel **ret_kernels);
+
+/**
+ * \return  copy function of the non-temporal kernel; memcpy() if not available
+ */
+copy_kernel_copy_t copy_kernel_non_temporal(void);
+
+#endif // COPY_KERNELS_H_
@@ -0,0 +1,323 @@
+/* Sweep of the copy and set kernels of copy_kernels.c (memcpy / memset variants)
+   over the size (1 B to the given maximum, powers of 2) and over the misalignment
+   of source and destination (0..63 bytes, at one fixed size).
+   Reports the fastest kernel per size and the crossover sizes where another
+   kernel takes over.
+
+   Usage: copy_sweep [max_size_MiB] [alignment_sweep_size_bytes]
+          defaults: STD_MAX_SIZE_MIB, STD_ALIGNMENT_SWEEP_SIZE
+
+   notes:
+   - warm: the same buffers are used for all calls; thus, sizes within the caches
+     are copied from/to the caches (as for message buffers that are reused)
+   - small sizes: several calls per measurement (denominator); the indirect call
+     is included in the measured time, as it is for every kernel
+   - median of N measurements
+   - each kernel is verified once per size and misalignment (result and guard bytes
+     before and after the destination)
+*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "benchmark.h"
+#include "copy_kernels.h"
+
+#define STD_MAX_SIZE_MIB 256
+#define STD_ALIGNMENT_SWEEP_SIZE 4096
+
+// measurements per size and kernel
+#define N 11
+
+#define MIN_BYTES_PER_MEASUREMENT (64 * 1024)
+#define MAX_CALLS_PER_MEASUREMENT 4096
+
+#define MAX_MISALIGNMENT 64
+#define CROSSOVER_TOLERANCE 0.05
+#define MAX_SIZES 64
+#define SET_VALUE 0x5a
+
+enum operation {
+    OP_COPY,
+    OP_SET
+};
+
+static const char *operation_names[] = {"copy", "set"};
+
+//--- buffers ------------------------------------------------------------------
+//    MAX_MISALIGNMENT bytes before and after the largest size: misalignment and guards
+
+static char *src_ = NULL;
+static char *dest_ = NULL;
+static size_t buffer_size_ = 0;
+
+static bool alloc_buffers(size_t max_size) {
+    buffer_size_ = max_size + 2 * MAX_MISALIGNMENT;
+    src_ = testbench_alloc_buffer(buffer_size_, NULL);
+    dest_ = testbench_alloc_buffer(buffer_size_, NULL);
+    if (!src_ || !dest_) {
+        return false;
+    }
+    for (size_t i = 0; i < buffer_size_; i++) {
+        src_[i] = (char)(i * 131 + 7);
+    }
+    return true;
+}
+
+static void free_buffers(void) {
+    testbench_free_buffer(dest_, buffer_size_);
+    testbench_free_buffer(src_, buffer_size_);
+}
+
+//--- measurements -------------------------------------------------------------
+
+static inline void run(const struct copy_kernel *kernel, enum operation op, char *d, const char *s, size_t n) {
+    if (op == OP_COPY) {
+        kernel->copy(d, s, n);
+    }
+    else {
+        kernel->set(d, SET_VALUE, n);
+    }
+}
+
+static bool verify(const struct copy_kernel *kernel, enum operation op, char *d, const char *s, size_t n) {
+    memset(d - 1, 0, n + 2);
+    run(kernel, op, d, s, n);
+    if (d[-1] != 0 || d[n] != 0) {
+        return false;
+    }
+    if (op == OP_COPY) {
+        return memcmp(d, s, n) == 0;
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (d[i] != (char)SET_VALUE) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * returns the median cycles per call
+ */
+static double measure(const struct copy_kernel *kernel, enum operation op,
+                      size_t dest_offset, size_t src_offset, size_t n) {
+    char *d = dest_ + MAX_MISALIGNMENT + dest_offset;
+    const char *s = src_ + MAX_MISALIGNMENT + src_offset;
+    uint64_t t_start = 0;
+    uint64_t t_stop = 0;
+
+    if (!verify(kernel, op, d, s, n)) {
+        fprintf(stderr, "Error: kernel %s, %s of %zu bytes (offsets dest %zu, src %zu) is WRONG.\n",
+                kernel->name, operation_names[op], n, dest_offset, src_offset);
+        exit(1);
+    }
+
+    size_t calls = MIN_BYTES_PER_MEASUREMENT / n;
+    if (calls < 1) {
+        calls = 1;
+    }
+    if (calls > MAX_CALLS_PER_MEASUREMENT) {
+        calls = MAX_CALLS_PER_MEASUREMENT;
+    }
+
+    reset_testbench();
+    set_denominator(calls);
+    run(kernel, op, d, s, n); // warm up
+    for (int i = 0; i < N; i++) {
+        RDTSC_START(t_start);
+        for (size_t c = 0; c < calls; c++) {
+            run(kernel, op, d, s, n);
+        }
+        RDTSC_STOP(t_stop);
+        add_measurement(t_start, t_stop);
+    }
+
+    struct testbench_statistics stat = testbench_get_statistics();
+    return stat.median;
+}
+
+//--- output -------------------------------------------------------------------
+
+static void print_size(size_t size) {
+    if (size >= 1024 * 1024 * 1024 && size % (1024 * 1024 * 1024) == 0) {
+        printf("%5zu GiB", size / (1024 * 1024 * 1024));
+    }
+    else if (size >= 1024 * 1024 && size % (1024 * 1024) == 0) {
+        printf("%5zu MiB", size / (1024 * 1024));
+    }
+    else if (size >= 1024 && size % 1024 == 0) {
+        printf("%5zu KiB", size / 1024);
+    }
+    else {
+        printf("%5zu B  ", size);
+    }
+}
+
+static void print_header(const char *first_column, const struct copy_kernel *kernels, size_t n_kernels) {
+    printf("%9s", first_column);
+    for (size_t k = 0; k < n_kernels; k++) {
+        printf("  %10s", kernels[k].name);
+    }
+}
+
+static size_t fastest(const double *cycles, size_t n_kernels) {
+    size_t best = 0;
+    for (size_t k = 1; k < n_kernels; k++) {
+        if (cycles[k] < cycles[best]) {
+            best = k;
+        }
+    }
+    return best;
+}
+
+//--- sweeps -------------------------------------------------------------------
+
+static void size_sweep(enum operation op, const struct copy_kernel *kernels, size_t n_kernels,
+                       size_t max_size, double scale, const char *bw_unit) {
+    double cycles[MAX_SIZES][COPY_KERNELS_MAX];
+    size_t sizes[MAX_SIZES];
+    size_t n_sizes = 0;
+    for (size_t size = 1; size <= max_size && n_sizes < MAX_SIZES; size *= 2) {
+        sizes[n_sizes] = size;
+        for (size_t k = 0; k < n_kernels; k++) {
+            cycles[n_sizes][k] = measure(&kernels[k], op, 0, 0, size);
+        }
+        n_sizes++;
+    }
+
+    printf("\n%s: median cycles per call (source and destination 64 byte aligned)\n", operation_names[op]);
+    print_header("size", kernels, n_kernels);
+    printf("     fastest  %s\n", bw_unit);
+    for (size_t i = 0; i < n_sizes; i++) {
+        print_size(sizes[i]);
+        for (size_t k = 0; k < n_kernels; k++) {
+            printf("  %10.1f", cycles[i][k]);
+        }
+        size_t best = fastest(cycles[i], n_kernels);
+        printf("  %10s  %.2f\n", kernels[best].name, (double)sizes[i] / cycles[i][best] * scale);
+    }
+
+    // a kernel keeps the lead while it is within the tolerance of the fastest one
+    printf("\n%s: fastest kernel by size (crossovers; tolerance %.0f %%)\n", operation_names[op],
+           100.0 * CROSSOVER_TOLERANCE);
+    size_t first = 0;
+    size_t lead = n_sizes > 0 ? fastest(cycles[0], n_kernels) : 0;
+    for (size_t i = 1; i <= n_sizes; i++) {
+        if (i < n_sizes) {
+            size_t best = fastest(cycles[i], n_kernels);
+            if (cycles[i][lead] <= (1.0 + CROSSOVER_TOLERANCE) * cycles[i][best]) {
+                continue;
+            }
+        }
+        printf("- ");
+        print_size(sizes[first]);
+        printf(" .. ");
+        print_size(sizes[i - 1]);
+        printf(": %s\n", kernels[lead].name);
+        if (i < n_sizes) {
+            lead = fastest(cycles[i], n_kernels);
+        }
+        first = i;
+    }
+}
+
+/**
+ * misaligned_src: source misaligned by 0..63 bytes and destination aligned; vice versa otherwise
+ */
+static void alignment_sweep(enum operation op, bool misaligned_src, const struct copy_kernel *kernels,
+                            size_t n_kernels, size_t size) {
+    double cycles[MAX_MISALIGNMENT][COPY_KERNELS_MAX];
+    for (size_t offset = 0; offset < MAX_MISALIGNMENT; offset++) {
+        for (size_t k = 0; k < n_kernels; k++) {
+            cycles[offset][k] = misaligned_src ? measure(&kernels[k], op, 0, offset, size)
+                                               : measure(&kernels[k], op, offset, 0, size);
+        }
+    }
+
+    printf("\n%s: median cycles per call, %zu bytes, %s misaligned by offset\n", operation_names[op], size,
+           misaligned_src ? "source" : "destination");
+    print_header("offset", kernels, n_kernels);
+    printf("\n");
+    for (size_t offset = 0; offset < MAX_MISALIGNMENT; offset++) {
+        printf("%9zu", offset);
+        for (size_t k = 0; k < n_kernels; k++) {
+            printf("  %10.1f", cycles[offset][k]);
+        }
+        printf("\n");
+    }
+
+    // penalty: slowest misalignment relative to the aligned case
+    printf("%9s", "max/0");
+    for (size_t k = 0; k < n_kernels; k++) {
+        double max = cycles[0][k];
+        for (size_t offset = 1; offset < MAX_MISALIGNMENT; offset++) {
+            if (cycles[offset][k] > max) {
+                max = cycles[offset][k];
+            }
+        }
+        printf("  %10.2f", max / cycles[0][k]);
+    }
+    printf("\n");
+}
+
+//--- main ---------------------------------------------------------------------
+
+int main(int argc, char **argv) {
+    size_t max_mib = STD_MAX_SIZE_MIB;
+    size_t alignment_size = STD_ALIGNMENT_SWEEP_SIZE;
+    if (argc > 3) {
+        fprintf(stderr, "USAGE: copy_sweep [max_size_MiB] [alignment_sweep_size_bytes]\n");
+        return 1;
+    }
+    if (argc >= 2) {
+        max_mib = (size_t)atol(argv[1]);
+    }
+    if (argc == 3) {
+        alignment_size = (size_t)atol(argv[2]);
+    }
+    size_t max_size = max_mib * 1024 * 1024;
+    if (alignment_size == 0) {
+        alignment_size = 1;
+    }
+
+    set_environment_capture(true); // TSC frequency for the bandwidth
+    if (!create_testbench(N)) {
+        fprintf(stderr, "Error: could not open testbench (memory?).\n");
+        exit(1);
+    }
+    if (!alloc_buffers(max_size > alignment_size ? max_size : alignment_size)) {
+        fprintf(stderr, "Error: could not allocate the buffers.\n");
+        exit(1);
+    }
+
+    // scale: bytes per cycle -> GB/s
+    struct testbench_environment env = testbench_get_environment();
+    double scale = 1.0;
+    const char *bw_unit = "B/cycle";
+    if (env.captured && env.tsc_ghz > 0.0) {
+        scale = env.tsc_ghz;
+        bw_unit = "GB/s";
+    }
+
+    const struct copy_kernel *kernels = NULL;
+    size_t n_kernels = copy_kernels_available(&kernels);
+    printf("\nKernels available on this CPU:");
+    for (size_t k = 0; k < n_kernels; k++) {
+        printf(" %s", kernels[k].name);
+    }
+    printf("\n");
+
+    size_sweep(OP_COPY, kernels, n_kernels, max_size, scale, bw_unit);
+    size_sweep(OP_SET, kernels, n_kernels, max_size, scale, bw_unit);
+
+    alignment_sweep(OP_COPY, true, kernels, n_kernels, alignment_size);
+    alignment_sweep(OP_COPY, false, kernels, n_kernels, alignment_size);
+    alignment_sweep(OP_SET, false, kernels, n_kernels, alignment_size);
+
+    free_buffers();
+    delete_testbench();
+    return 0;
+}
@@ -0,0 +1,80 @@
+/* Parallel copy of large buffers on a persistent thread pool; see parallel_copy.h
+*/
+
+#include <stdint.h>
+#include <string.h>
+
+#include "copy_kernels.h"
+#include "parallel_copy.h"
+
+//--- chunks ---------------------------------------------------------------------
+
+struct copy_job {
+    char *dest;
+    const char *src;
+    size_t n;
+    size_t n_threads;
+    copy_kernel_copy_t copy;
+};
+
+/**
+ * chunk boundaries on page boundaries of the destination
+ */
+static size_t chunk_begin(const struct copy_job *job, size_t index) {
+    if (index == 0) {
+        return 0;
+    }
+    if (index >= job->n_threads) {
+        return job->n;
+    }
+    uintptr_t base = (uintptr_t)job->dest;
+    uintptr_t b = base + job->n / job->n_threads * index;
+    b = (b + PARALLEL_COPY_PAGE_SIZE - 1) & ~(uintptr_t)(PARALLEL_COPY_PAGE_SIZE - 1);
+    size_t offset = b - base;
+    return offset < job->n ? offset : job->n;
+}
+
+static void copy_chunk(void *context, size_t index, size_t n_threads) {
+    (void)n_threads;
+    const struct copy_job *job = context;
+    size_t begin = chunk_begin(job, index);
+    size_t end = chunk_begin(job, index + 1);
+    if (begin < end) {
+        job->copy(job->dest + begin, job->src + begin, end - begin);
+    }
+}
+
+//--- API ------------------------------------------------------------------------
+
+bool create_copy_pool(size_t n_threads, bool pin) {
+    copy_kernel_non_temporal(); // kernel selection before the threads start
+    return testbench_pool_create(n_threads, pin);
+}
+
+void delete_copy_pool(void) {
+    testbench_pool_delete();
+}
+
+size_t copy_pool_threads(void) {
+    return testbench_pool_threads();
+}
+
+void *parallel_memcpy(void *restrict dest, const void *restrict src, size_t n, size_t n_threads, bool non_temporal) {
+    copy_kernel_copy_t copy = non_temporal ? copy_kernel_non_temporal() : memcpy;
+
+    size_t pool = testbench_pool_threads();
+    size_t max_threads = n / PARALLEL_COPY_MIN_CHUNK;
+    if (n_threads == 0 || n_threads > pool) {
+        n_threads = pool;
+    }
+    if (n_threads > max_threads) {
+        n_threads = max_threads;
+    }
+    if (n_threads <= 1) {
+        return copy(dest, src, n);
+    }
+
+    struct copy_job job = {dest, src, n, n_threads, copy};
+    testbench_pool_run(copy_chunk, &job, n_threads);
+    return dest;
+}
@@ -0,0 +1,58 @@
+/* Parallel copy of large buffers on the thread pool of the benchmark library
+   (testbench_pool_create() in parallel_benchmark.h).
+
+   The destination is split into page-aligned chunks, one contiguous chunk per
+   thread; the calling thread copies the first chunk. Chunks are at least
+   PARALLEL_COPY_MIN_CHUNK bytes; smaller copies use fewer threads.
+   Optionally with non-temporal stores (see copy_kernels.h), which avoid the
+   read for ownership of the destination and do not evict the caches.
+
+   Needs pthreads (compile and link with -pthread). Not thread safe: one pool
+   per process, used by one thread at a time.
+*/
+
+#ifndef PARALLEL_COPY_H_
+#define PARALLEL_COPY_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "parallel_benchmark.h"
+
+#define PARALLEL_COPY_MAX_THREADS TESTBENCH_POOL_MAX_THREADS
+#define PARALLEL_COPY_PAGE_SIZE 4096
+#define PARALLEL_COPY_MIN_CHUNK (256 * 1024)
+
+/**
+ * \param n_threads  number of threads including the calling thread; 0: number of CPUs
+ *                   in the affinity mask; at most PARALLEL_COPY_MAX_THREADS
+ * \param pin        pin thread i to the i-th CPU of the affinity mask (Linux), including
+ *                   the calling thread (until delete_copy_pool())
+ * \return           true if successful; false otherwise (threads, already created)
+ */
+bool create_copy_pool(size_t n_threads, bool pin);
+
+/**
+ * stops and joins the pool threads; restores the affinity mask of the calling thread
+ */
+void delete_copy_pool(void);
+
+/**
+ * \return  number of threads of the pool including the calling thread; 0 if not created
+ */
+size_t copy_pool_threads(void);
+
+/**
+ * \param dest          destination; must not overlap with the source
+ * \param src           source
+ * \param n             bytes
+ * \param n_threads     threads to use (including the calling thread); 0: all of the pool;
+ *                      limited by the pool size and by n / PARALLEL_COPY_MIN_CHUNK
+ * \param non_temporal  use non-temporal stores
+ * \return              dest (as memcpy()); the copy is complete
+ *
+ * Without a pool, the calling thread copies alone.
+ */
+void *parallel_memcpy(void *restrict dest, const void *restrict src, size_t n, size_t n_threads, bool non_temporal);
+
+#endif // PARALLEL_COPY_H_
@@ -22,6 +22,7 @@
 #include <string.h>
 
 #include "benchmark.h"
+#include "parallel_benchmark.h"
 
 //--- data set 1 - random values, normal distribution --------------------------
 //    generator settings: mean = 1'000'000, sd = 100'000, n = 101
@@ -180,14 +181,22 @@ void copy_with_memcpy(uint64_t *values, int n_values) {
     memcpy(dest_memcpy, values, n_values * sizeof(*values));
 }
 
-void test_function(testfunction f, char *title, uint64_t *values, int n_values, uint64_t *dest) {
+void test_function(testfunction f, char *title, uint64_t *values, int n_values, uint64_t *dest,
+                   enum testbench_cache_mode cache_mode) {
     uint64_t stop = 0;
     uint64_t start = 0;
     reset_testbench();
     set_outlier_detection_mode(TESTBENCH_OUTLIER_DETECTION_OFF);
     // mode is only reset here because we are showing multiple variants below
+
+    // cache state is established after reset_memory(), which touches dest
+    set_cache_mode(cache_mode);
+    testbench_clear_buffers();
+    testbench_declare_buffer(values, n_values * sizeof(*values));
+    testbench_declare_buffer(dest, n_values * sizeof(*dest));
     for(int i = 0; i < N; i++) {
         reset_memory(dest, n_values);
+        testbench_prepare_cache();
 
         RDTSC_START(start);
         f(values, n_values);
@@ -210,12 +219,91 @@ void test_function(testfunction f, char *title, uint64_t *values, int n_values,
     print_testbench_statistics(title, &stat, NULL);
     set_outlier_detection_mode(TESTBENCH_OUTLIER_DETECTION_SD);
     print_histogram(title, &stat, NULL);
+
+    // evidence based: only values attributed to context switches, page faults, interrupts
+    struct testbench_events events = testbench_get_events();
+    print_testbench_events(title, &events);
+    print_testbench_statistics(title, &stat, NULL);
+    set_outlier_detection_mode(TESTBENCH_OUTLIER_DETECTION_EVENTS);
+    print_histogram(title, &stat, NULL);
+}
+
+//--- scaling ------------------------------------------------------------------
+//    each thread copies the same source into its own destination (weak scaling);
+//    1 MiB per thread to see the memory bandwidth limit rather than the L1 cache
+
+#define SCALING_BYTES (1024 * 1024)
+#define SCALING_ROUNDS 32
+
+struct scaling_context {
+    char *src;
+    char *dest[TESTBENCH_PARALLEL_MAX_THREADS];
+};
+
+void copy_scaling(void *context, size_t thread_index, size_t n_threads) {
+    (void)n_threads;
+    struct scaling_context *c = context;
+    memcpy(c->dest[thread_index], c->src, SCALING_BYTES);
+}
+
+void test_scaling(void) {
+    size_t cpus = testbench_available_cpus();
+    if (cpus > TESTBENCH_PARALLEL_MAX_THREADS) {
+        cpus = TESTBENCH_PARALLEL_MAX_THREADS;
+    }
+
+    struct scaling_context c;
+    c.src = testbench_alloc_buffer(SCALING_BYTES, NULL);
+    if (!c.src) {
+        fprintf(stderr, "Error: could not allocate the scaling buffers.\n");
+        exit(1);
+    }
+    memset(c.src, 1, SCALING_BYTES);
+    for (size_t i = 0; i < cpus; i++) {
+        c.dest[i] = testbench_alloc_buffer(SCALING_BYTES, NULL);
+        if (!c.dest[i]) {
+            fprintf(stderr, "Error: could not allocate the scaling buffers.\n");
+            exit(1);
+        }
+    }
+
+    struct testbench_scaling_config config = {
+        .max_threads = cpus,
+        .rounds = SCALING_ROUNDS,
+        .pin = true,
+        .work_per_call = SCALING_BYTES,
+        .work_unit = "bytes"
+    };
+    struct testbench_scaling_point points[TESTBENCH_PARALLEL_MAX_THREADS];
+    size_t n_points = testbench_run_scaling(copy_scaling, &c, &config, points, TESTBENCH_PARALLEL_MAX_THREADS);
+    if (n_points == 0) {
+        fprintf(stderr, "Error: scaling run failed.\n");
+        exit(1);
+    }
+    print_testbench_scaling("11) memcpy 1 MiB per thread, scaling", points, n_points, &config, NULL);
+    testbench_free_scaling(points, n_points);
+
+    for (size_t i = 0; i < cpus; i++) {
+        testbench_free_buffer(c.dest[i], SCALING_BYTES);
+    }
+    testbench_free_buffer(c.src, SCALING_BYTES);
+}
+
+void test_antagonist(const struct testbench_antagonist *antagonist, char *title) {
+    if (!testbench_start_antagonists(antagonist, 1)) {
+        fprintf(stderr, "Error: could not start the antagonist.\n");
+        exit(1);
+    }
+    // reported with the statistics (conditions)
+    test_function(copy_with_memcpy, title, data2, DATA2_N, dest_memcpy, TESTBENCH_CACHE_AS_IS);
+    testbench_stop_antagonists();
 }
 
 //--- main ---------------------------------------------------------------------
 
 int main() {
     // init
+    set_event_accounting(TESTBENCH_EVENTS_BATCH, 0);
     if( !create_testbench(N) ) {
         fprintf(stderr, "Error: could not open testbench (memory?).\n");
         exit(1);
@@ -223,22 +311,44 @@ int main() {
     init_memory(data2, DATA2_N);
 
     // 1) loop
-    test_function(copy_with_loop, "1) loop", data1, DATA1_N, dest_loop);
+    test_function(copy_with_loop, "1) loop", data1, DATA1_N, dest_loop, TESTBENCH_CACHE_AS_IS);
 
     // 2) memcpy
-    test_function(copy_with_memcpy, "2) memcpy", data1, DATA1_N, dest_memcpy);
+    test_function(copy_with_memcpy, "2) memcpy", data1, DATA1_N, dest_memcpy, TESTBENCH_CACHE_AS_IS);
 
     // 3) loop, again (see/exclude potential caching benefit for memcpy)
-    test_function(copy_with_loop, "3) loop, again", data1, DATA1_N, dest_loop);
+    test_function(copy_with_loop, "3) loop, again", data1, DATA1_N, dest_loop, TESTBENCH_CACHE_AS_IS);
 
     // 4) loop, more data
-    test_function(copy_with_loop, "4) loop, more data", data2, DATA2_N, dest_loop);
+    test_function(copy_with_loop, "4) loop, more data", data2, DATA2_N, dest_loop, TESTBENCH_CACHE_AS_IS);
 
     // 5) loop, more data
-    test_function(copy_with_memcpy, "5) memcpy, more data", data2, DATA2_N, dest_memcpy);
+    test_function(copy_with_memcpy, "5) memcpy, more data", data2, DATA2_N, dest_memcpy, TESTBENCH_CACHE_AS_IS);
 
     // 6) loop, more data, again (see/exclude potential caching benefit for memcpy)
-    test_function(copy_with_loop, "6) loop, more data, again", data2, DATA2_N, dest_loop);
+    test_function(copy_with_loop, "6) loop, more data, again", data2, DATA2_N, dest_loop, TESTBENCH_CACHE_AS_IS);
+
+    // 7) - 10) explicit cache state instead of relying on the order of the tests
+    test_function(copy_with_loop, "7) loop, more data, warm", data2, DATA2_N, dest_loop, TESTBENCH_CACHE_WARM);
+    test_function(copy_with_memcpy, "8) memcpy, more data, warm", data2, DATA2_N, dest_memcpy, TESTBENCH_CACHE_WARM);
+    test_function(copy_with_loop, "9) loop, more data, cold", data2, DATA2_N, dest_loop, TESTBENCH_CACHE_COLD);
+    test_function(copy_with_memcpy, "10) memcpy, more data, cold", data2, DATA2_N, dest_memcpy, TESTBENCH_CACHE_COLD);
+
+    // 11) memcpy on 1..all CPUs
+    set_cache_mode(TESTBENCH_CACHE_AS_IS);
+    test_scaling();
+
+    // 12) - 13) noisy neighbours: on another CPU of the affinity mask if available (shared
+    //     LLC and memory), otherwise time-sliced on the same CPU; the LLC antagonist works
+    //     on a buffer of the detected LLC size (default buffer_size)
+    struct testbench_antagonist antagonist = {
+        .kind = TESTBENCH_ANTAGONIST_MEMORY_BANDWIDTH,
+        .cpu = testbench_other_cpu(),
+        .intensity = 0.5
+    };
+    test_antagonist(&antagonist, "12) memcpy, more data, memory bandwidth antagonist");
+    antagonist.kind = TESTBENCH_ANTAGONIST_LLC;
+    test_antagonist(&antagonist, "13) memcpy, more data, LLC antagonist");
 
     // cleanup
     delete_testbench();
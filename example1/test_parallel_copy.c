@@ -0,0 +1,273 @@
+/* Large-buffer copy: libc memcpy() vs parallel_memcpy() (parallel_copy.c) on
+   1 .. max threads, with regular and non-temporal stores. Buffer sizes from
+   1 MiB to the given maximum (powers of 2).
+   Reports from which size on parallelism pays off and how many threads are
+   needed to saturate the memory bandwidth.
+
+   Usage: test_parallel_copy [max_size_MiB] [max_threads]
+          defaults: STD_MAX_SIZE_MIB, but source and destination within half of the
+          free memory; number of CPUs in the affinity mask
+
+   notes:
+   - source and destination together need twice the maximum size; if this cannot
+     be allocated, the maximum is halved until it can
+   - the copy pool pins its threads including the calling (measuring) thread
+   - bandwidth: copied bytes per second (GB/s) if the TSC frequency is known,
+     bytes per cycle otherwise; the read of the source is not counted
+   - median of N measurements after one untimed copy (pages are prefaulted)
+*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "benchmark.h"
+#include "parallel_benchmark.h"
+#include "parallel_copy.h"
+
+#define STD_MAX_SIZE_MIB 4096
+#define MIN_SIZE (1024 * 1024)
+
+// measurements per size and variant
+#define N 7
+
+#define MAX_SIZES 32
+#define MAX_COUNTS 16
+
+// parallel copy pays off if it is faster than memcpy() by this margin;
+// saturation: the fewest threads within this margin of the highest bandwidth
+#define MARGIN 0.05
+
+//--- measurements -------------------------------------------------------------
+
+struct variant {
+    size_t n_threads; // 0: libc memcpy()
+    bool non_temporal;
+};
+
+/**
+ * returns the median cycles per copy
+ */
+static double measure(const struct variant *v, char *dest, const char *src, size_t size) {
+    uint64_t t_start = 0;
+    uint64_t t_stop = 0;
+
+    reset_testbench();
+    for (int i = -1; i < N; i++) {
+        RDTSC_START(t_start);
+        if (v->n_threads == 0) {
+            memcpy(dest, src, size);
+        }
+        else {
+            parallel_memcpy(dest, src, size, v->n_threads, v->non_temporal);
+        }
+        RDTSC_STOP(t_stop);
+        if (i >= 0) {
+            add_measurement(t_start, t_stop);
+        }
+    }
+    if (memcmp(dest, src, size) != 0) {
+        fprintf(stderr, "Error: copy of %zu bytes with %zu threads is WRONG.\n", size, v->n_threads);
+        exit(1);
+    }
+    memset(dest, 0, size);
+
+    struct testbench_statistics stat = testbench_get_statistics();
+    return stat.median;
+}
+
+/**
+ * STD_MAX_SIZE_MIB halved until source and destination fit into half of the free memory
+ * (the buffers are prefaulted and locked)
+ */
+static size_t default_max_mib(void) {
+    size_t max_mib = STD_MAX_SIZE_MIB;
+#ifdef _SC_AVPHYS_PAGES
+    long pages = sysconf(_SC_AVPHYS_PAGES);
+    long page_size = sysconf(_SC_PAGESIZE);
+    if (pages > 0 && page_size > 0) {
+        size_t free_mib = (size_t)pages * (size_t)page_size / (1024 * 1024);
+        while (max_mib > MIN_SIZE / (1024 * 1024) && 4 * max_mib > free_mib) {
+            max_mib /= 2;
+        }
+    }
+#endif
+    return max_mib;
+}
+
+static void print_size(size_t size) {
+    if (size >= 1024 * 1024 * 1024) {
+        printf("%5zu GiB", size / (1024 * 1024 * 1024));
+    }
+    else {
+        printf("%5zu MiB", size / (1024 * 1024));
+    }
+}
+
+//--- main ---------------------------------------------------------------------
+
+int main(int argc, char **argv) {
+    size_t max_mib = default_max_mib();
+    size_t max_threads = testbench_available_cpus();
+    if (argc > 3) {
+        fprintf(stderr, "USAGE: test_parallel_copy [max_size_MiB] [max_threads]\n");
+        return 1;
+    }
+    if (argc >= 2) {
+        max_mib = (size_t)atol(argv[1]);
+    }
+    if (argc == 3) {
+        max_threads = (size_t)atol(argv[2]);
+    }
+    if (max_threads < 1) {
+        max_threads = 1;
+    }
+    if (max_threads > PARALLEL_COPY_MAX_THREADS) {
+        max_threads = PARALLEL_COPY_MAX_THREADS;
+    }
+
+    set_environment_capture(true); // TSC frequency for the bandwidth
+    if (!create_testbench(N)) {
+        fprintf(stderr, "Error: could not open testbench (memory?).\n");
+        exit(1);
+    }
+    if (!create_copy_pool(max_threads, true)) {
+        fprintf(stderr, "Error: could not create the copy pool.\n");
+        exit(1);
+    }
+
+    size_t max_size = max_mib * 1024 * 1024;
+    if (max_size < MIN_SIZE) {
+        max_size = MIN_SIZE;
+    }
+    char *src = NULL;
+    char *dest = NULL;
+    for (; max_size >= MIN_SIZE; max_size /= 2) {
+        src = testbench_alloc_buffer(max_size, NULL);
+        dest = testbench_alloc_buffer(max_size, NULL);
+        if (src && dest) {
+            break;
+        }
+        testbench_free_buffer(src, max_size);
+        testbench_free_buffer(dest, max_size);
+        src = NULL;
+        dest = NULL;
+    }
+    if (!src) {
+        fprintf(stderr, "Error: could not allocate the buffers.\n");
+        exit(1);
+    }
+    if (max_size < max_mib * 1024 * 1024 || (argc < 2 && max_mib < STD_MAX_SIZE_MIB)) {
+        printf("\nNote: maximum size limited to %zu MiB (memory).\n", max_size / (1024 * 1024));
+    }
+    for (size_t i = 0; i < max_size; i++) {
+        src[i] = (char)(i * 131 + 7);
+    }
+
+    // scale: bytes per cycle -> GB/s
+    struct testbench_environment env = testbench_get_environment();
+    double scale = 1.0;
+    const char *bw_unit = "B/cycle";
+    if (env.captured && env.tsc_ghz > 0.0) {
+        scale = env.tsc_ghz;
+        bw_unit = "GB/s";
+    }
+
+    // variants: memcpy, then 1, 2, 4, .., max_threads with regular and non-temporal stores
+    struct variant variants[1 + 2 * MAX_COUNTS];
+    size_t n_variants = 0;
+    variants[n_variants++] = (struct variant){0, false};
+    for (size_t t = 1; n_variants + 2 <= 1 + 2 * MAX_COUNTS; t *= 2) {
+        if (t > max_threads) {
+            t = max_threads;
+        }
+        variants[n_variants++] = (struct variant){t, false};
+        variants[n_variants++] = (struct variant){t, true};
+        if (t == max_threads) {
+            break;
+        }
+    }
+
+    double bandwidth[MAX_SIZES][1 + 2 * MAX_COUNTS];
+    size_t sizes[MAX_SIZES];
+    size_t n_sizes = 0;
+    for (size_t size = MIN_SIZE; size <= max_size && n_sizes < MAX_SIZES; size *= 2) {
+        sizes[n_sizes] = size;
+        for (size_t v = 0; v < n_variants; v++) {
+            bandwidth[n_sizes][v] = (double)size / measure(&variants[v], dest, src, size) * scale;
+        }
+        n_sizes++;
+    }
+
+    printf("\nCopy bandwidth [%s]; t: threads of parallel_memcpy(), nt: non-temporal stores\n", bw_unit);
+    printf("     size    memcpy");
+    for (size_t v = 1; v < n_variants; v++) {
+        char name[32];
+        snprintf(name, sizeof(name), "t=%zu%s", variants[v].n_threads, variants[v].non_temporal ? " nt" : "");
+        printf("  %8s", name);
+    }
+    printf("\n");
+    for (size_t i = 0; i < n_sizes; i++) {
+        print_size(sizes[i]);
+        for (size_t v = 0; v < n_variants; v++) {
+            printf("  %8.2f", bandwidth[i][v]);
+        }
+        printf("\n");
+    }
+
+    // pays off: from this size on, the best parallel variant (t > 1) always beats memcpy()
+    printf("\nSummary:\n");
+    size_t from = n_sizes;
+    for (size_t i = n_sizes; i > 0; i--) {
+        double best = 0.0;
+        for (size_t v = 1; v < n_variants; v++) {
+            if (variants[v].n_threads > 1 && bandwidth[i - 1][v] > best) {
+                best = bandwidth[i - 1][v];
+            }
+        }
+        if (best <= (1.0 + MARGIN) * bandwidth[i - 1][0]) {
+            break;
+        }
+        from = i - 1;
+    }
+    if (max_threads < 2) {
+        printf("- parallel copy: not measured (1 thread; see max_threads)\n");
+    }
+    else if (from < n_sizes) {
+        printf("- parallel copy pays off from ");
+        print_size(sizes[from]);
+        printf(" on (faster than memcpy by more than %.0f %%)\n", 100.0 * MARGIN);
+    }
+    else {
+        printf("- parallel copy does not pay off up to ");
+        print_size(sizes[n_sizes - 1]);
+        printf("\n");
+    }
+
+    // saturation at the largest size: fewest threads within the margin of the best bandwidth
+    size_t last = n_sizes - 1;
+    double best = 0.0;
+    for (size_t v = 1; v < n_variants; v++) {
+        if (bandwidth[last][v] > best) {
+            best = bandwidth[last][v];
+        }
+    }
+    for (size_t v = 1; v < n_variants; v++) {
+        if (bandwidth[last][v] >= (1.0 - MARGIN) * best) {
+            printf("- saturation at ");
+            print_size(sizes[last]);
+            printf(": %zu thread(s)%s reach %.2f %s (best %.2f; memcpy %.2f)\n", variants[v].n_threads,
+                   variants[v].non_temporal ? " with non-temporal stores" : "",
+                   bandwidth[last][v], bw_unit, best, bandwidth[last][0]);
+            break;
+        }
+    }
+
+    testbench_free_buffer(dest, max_size);
+    testbench_free_buffer(src, max_size);
+    delete_copy_pool();
+    delete_testbench();
+    return 0;
+}
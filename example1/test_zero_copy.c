@@ -0,0 +1,419 @@
+/* Zero-copy alternatives to memcpy() for large buffers (Linux):
+   - memcpy:          into a prefaulted destination buffer (the usual case)
+   - mremap:          moves the pages of the source to another address
+                      (ownership transfer; the source range is gone afterwards)
+   - cow:             MAP_PRIVATE mapping of a memfd (tmpfs) holding the data;
+                      pages are copied on the first write only
+   - splice:          vmsplice() of the source into a pipe, splice() into a memfd,
+                      mmap() of the memfd
+   - copy_file_range: from a memfd holding the data into another memfd, mmap()
+   Each technique is measured for the operation itself and for the first touch of
+   the result afterwards (one load or one store per page; separate runs), as the
+   mapping based techniques defer their cost to the page faults of the first touch.
+   Buffer sizes from 4 KiB to the given maximum (powers of 2).
+   Reports the break-even size from which each technique beats memcpy().
+
+   Usage: test_zero_copy [max_size_MiB]   (default STD_MAX_SIZE_MIB)
+
+   notes:
+   - regular 4 KiB pages (buffers are mapped here, not by testbench_alloc_buffer())
+   - the cleanup after each repetition (munmap, truncate, moving the pages back)
+     is not timed
+   - each technique is verified once per size before measuring
+*/
+
+#define _GNU_SOURCE // mremap(), memfd_create(), vmsplice(), splice(), copy_file_range()
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include "benchmark.h"
+
+#define STD_MAX_SIZE_MIB 256
+#define MIN_SIZE 4096
+#define PAGE_SIZE 4096
+
+// measurements per size, technique and touch
+#define N 7
+
+#define MAX_SIZES 32
+#define PIPE_SIZE (1024 * 1024)
+
+#ifdef __linux__
+
+enum technique {
+    T_MEMCPY,
+    T_MREMAP,
+    T_COW,
+    T_SPLICE,
+    T_COPY_FILE_RANGE,
+    T_N
+};
+
+static const char *technique_names[T_N] = {"memcpy", "mremap", "cow", "splice", "copy_file_range"};
+
+enum touch {
+    TOUCH_READ,
+    TOUCH_WRITE
+};
+
+struct buffers {
+    size_t size;
+    char *src;      // anonymous, filled (memcpy, mremap, splice)
+    char *dest;     // anonymous, prefaulted (memcpy)
+    char *reserved; // PROT_NONE range as target of mremap()
+    int src_fd;     // memfd, filled (cow, copy_file_range)
+    int dest_fd;    // memfd (splice, copy_file_range)
+    int pipe_fds[2];
+};
+
+struct result {
+    double op;          // median cycles
+    double touch[2];    // enum touch
+};
+
+static volatile char sink;
+
+static inline char pattern(size_t i) {
+    return (char)(i * 131 + 7);
+}
+
+static bool check_pattern(const char *p, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        if (p[i] != pattern(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void *map_anonymous(size_t size, int prot) {
+    void *p = mmap(NULL, size, prot, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return p == MAP_FAILED ? NULL : p;
+}
+
+//--- buffers ------------------------------------------------------------------
+
+static void free_buffers(struct buffers *b) {
+    if (b->src) {
+        munmap(b->src, b->size);
+    }
+    if (b->dest) {
+        munmap(b->dest, b->size);
+    }
+    if (b->reserved) {
+        munmap(b->reserved, b->size);
+    }
+    if (b->src_fd >= 0) {
+        close(b->src_fd);
+    }
+    if (b->dest_fd >= 0) {
+        close(b->dest_fd);
+    }
+    if (b->pipe_fds[0] >= 0) {
+        close(b->pipe_fds[0]);
+        close(b->pipe_fds[1]);
+    }
+}
+
+static bool alloc_buffers(struct buffers *b, size_t size) {
+    memset(b, 0, sizeof(*b));
+    b->size = size;
+    b->src_fd = -1;
+    b->dest_fd = -1;
+    b->pipe_fds[0] = -1;
+    b->pipe_fds[1] = -1;
+
+    b->src = map_anonymous(size, PROT_READ | PROT_WRITE);
+    b->dest = map_anonymous(size, PROT_READ | PROT_WRITE);
+    b->reserved = map_anonymous(size, PROT_NONE);
+    b->src_fd = memfd_create("zero_copy_src", 0);
+    b->dest_fd = memfd_create("zero_copy_dest", 0);
+    if (!b->src || !b->dest || !b->reserved || b->src_fd < 0 || b->dest_fd < 0 || pipe(b->pipe_fds) != 0) {
+        goto error;
+    }
+    fcntl(b->pipe_fds[1], F_SETPIPE_SZ, PIPE_SIZE); // best effort; the loops below use any size
+
+    for (size_t i = 0; i < size; i++) {
+        b->src[i] = pattern(i);
+    }
+    memset(b->dest, 0, size);
+    if (ftruncate(b->src_fd, (off_t)size) != 0) {
+        goto error;
+    }
+    for (size_t done = 0; done < size;) {
+        ssize_t n = pwrite(b->src_fd, b->src + done, size - done, (off_t)done);
+        if (n <= 0) {
+            goto error;
+        }
+        done += (size_t)n;
+    }
+    return true;
+
+error:
+    free_buffers(b);
+    return false;
+}
+
+//--- techniques ---------------------------------------------------------------
+
+static char *map_dest_fd(struct buffers *b) {
+    void *p = mmap(NULL, b->size, PROT_READ | PROT_WRITE, MAP_SHARED, b->dest_fd, 0);
+    return p == MAP_FAILED ? NULL : p;
+}
+
+/**
+ * returns the data in its new place; NULL in case of errors
+ */
+static char *run_technique(enum technique t, struct buffers *b) {
+    size_t size = b->size;
+    switch (t) {
+        case T_MEMCPY:
+            memcpy(b->dest, b->src, size);
+            return b->dest;
+        case T_MREMAP: {
+            void *p = mremap(b->src, size, size, MREMAP_MAYMOVE | MREMAP_FIXED, b->reserved);
+            return p == MAP_FAILED ? NULL : p;
+        }
+        case T_COW: {
+            void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, b->src_fd, 0);
+            return p == MAP_FAILED ? NULL : p;
+        }
+        case T_SPLICE: {
+            loff_t out = 0;
+            while ((size_t)out < size) {
+                struct iovec iov = {b->src + out, size - (size_t)out};
+                ssize_t n = vmsplice(b->pipe_fds[1], &iov, 1, 0);
+                if (n <= 0) {
+                    return NULL;
+                }
+                for (ssize_t moved = 0; moved < n;) {
+                    ssize_t m = splice(b->pipe_fds[0], NULL, b->dest_fd, &out, (size_t)(n - moved), SPLICE_F_MOVE);
+                    if (m <= 0) {
+                        return NULL;
+                    }
+                    moved += m;
+                }
+            }
+            return map_dest_fd(b);
+        }
+        case T_COPY_FILE_RANGE: {
+            loff_t in = 0;
+            loff_t out = 0;
+            while ((size_t)out < size) {
+                ssize_t n = copy_file_range(b->src_fd, &in, b->dest_fd, &out, size - (size_t)out, 0);
+                if (n <= 0) {
+                    return NULL;
+                }
+            }
+            return map_dest_fd(b);
+        }
+        default:
+            return NULL;
+    }
+}
+
+/**
+ * untimed: restores the state before run_technique()
+ */
+static bool undo_technique(enum technique t, struct buffers *b, char *p) {
+    size_t size = b->size;
+    switch (t) {
+        case T_MREMAP:
+            // move the pages back and reserve the target range again
+            if (mremap(p, size, size, MREMAP_MAYMOVE | MREMAP_FIXED, b->src) == MAP_FAILED) {
+                return false;
+            }
+            return mmap(b->reserved, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) != MAP_FAILED;
+        case T_COW:
+            return munmap(p, size) == 0;
+        case T_SPLICE:
+        case T_COPY_FILE_RANGE:
+            return munmap(p, size) == 0 && ftruncate(b->dest_fd, 0) == 0;
+        default:
+            return true;
+    }
+}
+
+static void touch_pages(char *p, size_t size, enum touch touch) {
+    if (touch == TOUCH_READ) {
+        char sum = 0;
+        for (size_t i = 0; i < size; i += PAGE_SIZE) {
+            sum += p[i];
+        }
+        sink = sum;
+    }
+    else {
+        // same value: the store alone triggers the copy on write
+        for (size_t i = 0; i < size; i += PAGE_SIZE) {
+            p[i] = pattern(i);
+        }
+    }
+}
+
+//--- measurements -------------------------------------------------------------
+
+static double median_of(const uint64_t *start, const uint64_t *stop) {
+    if (!testbench_load_measurements(start, stop, N)) {
+        return 0.0;
+    }
+    struct testbench_statistics stat = testbench_get_statistics();
+    return stat.median;
+}
+
+static bool measure(enum technique t, struct buffers *b, struct result *r) {
+    uint64_t op_start[N];
+    uint64_t op_stop[N];
+    uint64_t touch_start[N];
+    uint64_t touch_stop[N];
+
+    // verification
+    char *p = run_technique(t, b);
+    if (!p) {
+        return false;
+    }
+    if (!check_pattern(p, b->size)) {
+        fprintf(stderr, "Error: %s of %zu bytes is WRONG.\n", technique_names[t], b->size);
+        exit(1);
+    }
+    if (!undo_technique(t, b, p)) {
+        return false;
+    }
+
+    for (int touch = TOUCH_READ; touch <= TOUCH_WRITE; touch++) {
+        for (int i = 0; i < N; i++) {
+            RDTSC_START(op_start[i]);
+            p = run_technique(t, b);
+            RDTSC_STOP(op_stop[i]);
+            if (!p) {
+                return false;
+            }
+            RDTSC_START(touch_start[i]);
+            touch_pages(p, b->size, (enum touch)touch);
+            RDTSC_STOP(touch_stop[i]);
+            if (!undo_technique(t, b, p)) {
+                return false;
+            }
+        }
+        if (touch == TOUCH_READ) {
+            r->op = median_of(op_start, op_stop);
+        }
+        r->touch[touch] = median_of(touch_start, touch_stop);
+    }
+    return true;
+}
+
+static void print_size(size_t size) {
+    if (size >= 1024 * 1024) {
+        printf("%5zu MiB", size / (1024 * 1024));
+    }
+    else {
+        printf("%5zu KiB", size / 1024);
+    }
+}
+
+static double total(const struct result *r, int column) {
+    // column 0: operation only; 1: + read touch; 2: + write touch
+    return column == 0 ? r->op : r->op + r->touch[column - 1];
+}
+
+//--- main ---------------------------------------------------------------------
+
+int main(int argc, char **argv) {
+    size_t max_mib = STD_MAX_SIZE_MIB;
+    if (argc == 2) {
+        max_mib = (size_t)atol(argv[1]);
+    }
+    else if (argc > 2) {
+        fprintf(stderr, "USAGE: test_zero_copy [max_size_MiB]\n");
+        return 1;
+    }
+    size_t max_size = max_mib * 1024 * 1024;
+
+    if (!create_testbench(N)) {
+        fprintf(stderr, "Error: could not open testbench (memory?).\n");
+        exit(1);
+    }
+
+    struct result results[MAX_SIZES][T_N];
+    size_t sizes[MAX_SIZES];
+    size_t n_sizes = 0;
+    for (size_t size = MIN_SIZE; size <= max_size && n_sizes < MAX_SIZES; size *= 2) {
+        struct buffers b;
+        if (!alloc_buffers(&b, size)) {
+            fprintf(stderr, "Error: could not allocate the buffers of %zu bytes.\n", size);
+            exit(1);
+        }
+        sizes[n_sizes] = size;
+        for (int t = 0; t < T_N; t++) {
+            if (!measure((enum technique)t, &b, &results[n_sizes][t])) {
+                fprintf(stderr, "Error: %s of %zu bytes failed.\n", technique_names[t], size);
+                exit(1);
+            }
+        }
+        free_buffers(&b);
+        n_sizes++;
+    }
+
+    static const char *column_names[3] = {"operation", "operation + read touch (1 load per page)",
+                                          "operation + write touch (1 store per page)"};
+    for (int column = 0; column < 3; column++) {
+        printf("\nZero-copy alternatives, median cycles: %s\n", column_names[column]);
+        printf("     size");
+        for (int t = 0; t < T_N; t++) {
+            printf("  %15s", technique_names[t]);
+        }
+        printf("\n");
+        for (size_t i = 0; i < n_sizes; i++) {
+            print_size(sizes[i]);
+            for (int t = 0; t < T_N; t++) {
+                printf("  %15.0f", total(&results[i][t], column));
+            }
+            printf("\n");
+        }
+    }
+
+    // break-even: from this size on, the technique is always faster than memcpy() (incl. touch)
+    printf("\nBreak-even vs memcpy (operation + first touch; from this size on always faster):\n");
+    for (int t = T_MEMCPY + 1; t < T_N; t++) {
+        printf("- %-15s", technique_names[t]);
+        for (int column = 1; column < 3; column++) {
+            size_t from = n_sizes;
+            for (size_t i = n_sizes; i > 0; i--) {
+                if (total(&results[i - 1][t], column) >= total(&results[i - 1][T_MEMCPY], column)) {
+                    break;
+                }
+                from = i - 1;
+            }
+            printf("  %s touch: ", column == 1 ? "read" : "write");
+            if (from < n_sizes) {
+                print_size(sizes[from]);
+            }
+            else {
+                printf("    never");
+            }
+        }
+        printf("\n");
+    }
+
+    delete_testbench();
+    return 0;
+}
+
+#else // __linux__
+
+int main(void) {
+    printf("The zero-copy techniques (mremap, memfd, splice, copy_file_range) need Linux.\n");
+    return 0;
+}
+
+#endif // __linux__
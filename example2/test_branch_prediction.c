@@ -656,6 +656,53 @@ void test_B06(int n, int n_inner) {
 	run_cond_test_volatile("B-06: Seq RND", RANDOM, n, n_inner);
 }
 
+// C series: the inner loop count is not chosen by hand (see N_inner_loop) but
+// auto-calibrated by the library; the loop overhead is measured and subtracted, too.
+// The kernel cycles through the prepared argument arrays (N_inner_loop must be a power of 2).
+
+struct cond_kernel_context {
+	cond_function f;
+	int j;
+	uint64_t result;
+};
+
+void cond_kernel(void *context) {
+	struct cond_kernel_context *c = context;
+	c->result = c->f(xs[c->j], ys[c->j]);
+	c->j = (c->j + 1) & (N_inner_loop - 1);
+}
+
+void run_cond_test_C(char *title, cond_function f, enum options which) {
+	struct cond_kernel_context context = { .f = f, .j = 0, .result = 0 };
+
+	prepare_cond_data(which, N_inner_loop);
+
+	updown = 0;
+	global_result_updown = 0;
+	volatile_result_updown = 0;
+
+	reset_testbench();
+	size_t denominator = testbench_calibrate_denominator(cond_kernel, &context, 0);
+	testbench_measure_kernel(cond_kernel, &context, N);
+	global_result_updown = context.result;
+
+	printf("\n%s: auto-calibrated denominator %zu (compare N_inner_loop %d)\n", title, denominator, N_inner_loop);
+	struct testbench_statistics stat = testbench_get_statistics();
+	print_testbench_statistics(title, &stat, NULL);
+	set_outlier_detection_mode(TESTBENCH_OUTLIER_DETECTION_HISTOGRAM);
+	print_histogram(title, &stat, NULL);
+}
+
+void test_C01() {
+	printf("\nC-01: call a conditional function with local return value (no inline), auto-calibrated inner loop.\n");
+	run_cond_test_C("C-01: nothing", nothing, ONE);
+	run_cond_test_C("C-01: no branch", no_branch, ONE);
+	run_cond_test_C("C-01: Seq  +1", choose_cond, ONE);
+	run_cond_test_C("C-01: Seq  -1", choose_cond, TWO);
+	run_cond_test_C("C-01: Seq ALT", choose_cond, ALTERNATING);
+	run_cond_test_C("C-01: Seq RND", choose_cond, RANDOM);
+}
+
 // a workaround against "too much optimization using vector operations"
 int global_n = 0;
 int global_n_inner = 0;
@@ -667,6 +714,10 @@ int main() {
 		exit(1);
 	}
 
+	// warmup_cond_test() below only guesses the needed warmup;
+	// the library trims any remaining warmup prefix that it detects
+	set_warmup_trimming(true);
+
 	srand(time(NULL));
 	global_n = N;
 	global_n_inner = N_inner_loop;
@@ -692,6 +743,9 @@ int main() {
 	test_B05(global_n, global_n_inner);
 	test_B06(global_n, global_n_inner);
 
+	// C series: auto-calibrated inner loops
+	test_C01();
+
 	// cleanup
 	delete_testbench();
 }
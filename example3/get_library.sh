@@ -2,3 +2,5 @@
 cp ../benchmark/benchmark.c .
 cp ../benchmark/benchmark.h .
 cp ../benchmark/rdtsc.h .
+cp ../benchmark/parallel_benchmark.c .
+cp ../benchmark/parallel_benchmark.h .
@@ -10,8 +10,8 @@
 	future:  
 	- test script that collects the data of each run
 
-	- currently, data is piped into a result file that actually holds
-	  the header and one row of data
+	- currently, data is piped into a result file that holds a table with
+	  one row per algorithm (tab separated; see print_table_header())
 	  -> can be used to copy into Excel and create figure there.
 	  (not done at the moment since result collection not finished)
 
@@ -22,65 +22,122 @@
 */
 
 #include <assert.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>  
+#include <unistd.h>
 
 #include "benchmark.h"	
+#include "parallel_benchmark.h"
+#include "mmul_packed.h"
+#include "mmul_parallel.h"
+#include "mmul_strassen.h"
+#include "mmul_tune.h"
+#include "mmul_arena.h"
+#include "mmul_typed.h"
+#include "mmul_fixed.h"
+#include "mmul_morton.h"
+#include "mmul_transpose.h"
+#include "mmul_verify.h"
+
+//--- matrix allocation --------------------------------------------------------
+//    prefaulted and locked buffers of the benchmark library (huge pages for large
+//    matrices); avoids page faults and TLB misses during the timed multiplication
+//    size x size elements in rows of ld elements (leading dimension; ld >= size)
+
+static int *alloc_matrix(int size, int ld) {
+	return testbench_alloc_buffer((size_t)size * ld * sizeof(int), NULL);
+}
 
-//--- given routines -----------------------------------------------------------
+static void free_matrix(int size, int ld, int *matrix) {
+	testbench_free_buffer(matrix, (size_t)size * ld * sizeof(int));
+}
 
-static int *randmatrix(int size) {
-	int *matrix = malloc(size * size * sizeof(*matrix));
-	if(!matrix) {
-		fprintf(stderr, "%s: memory allocation error.\n", __func__);
-		exit(1);
+static size_t matrix_bytes(int size, int ld) {
+	return (size_t)size * ld * sizeof(int);
+}
+
+// padding policy: row strides of a multiple of 512 bytes map the elements of a column
+// to few cache sets (L1: 64 sets of 64 bytes, i.e. 4 KiB per way); a column walk of B
+// (or of B^T while transposing) then evicts its own lines. One cache line of padding
+// per row spreads the columns over all sets.
+#define LD_CONFLICT_STRIDE 512 // bytes
+#define LD_PADDING 16          // elements (64 bytes)
+
+static int leading_dimension(int size, bool pad) {
+	if(pad && size >= LD_PADDING && ((size_t)size * sizeof(int)) % LD_CONFLICT_STRIDE == 0) {
+		return size + LD_PADDING;
 	}
+	return size;
+}
+
+//--- allocation-free interface ------------------------------------------------
+//    C = A * B into the caller's C (overwritten); A, B and C with leading dimension ld;
+//    temporaries (B^T, packing buffers, ...) from the workspace arena, which must have at
+//    least mmul_workspace_bytes(size, ld) free; released again before returning. Thus,
+//    repeated calls with the same C and workspace do not allocate memory. Returns false if
+//    the workspace is too small.
+
+typedef bool (*matrix_multiplier)(int size, int ld, const int *A, const int *B, int *C,
+		struct mmul_arena *workspace);
 
+// workspace for all algorithms of the table at this size (with the tuned parameters)
+static size_t mmul_workspace_bytes(int size, int ld);
+
+//--- given routines -----------------------------------------------------------
+
+static void fillmatrix(int size, int ld, int *matrix) {
 	for (int row = 0; row < size; row++) {
 		for (int col = 0; col < size; col++) {
-			matrix[row * size + col] = random() / (RAND_MAX / 100);
+			matrix[row * ld + col] = random() / (RAND_MAX / 100);
 		}
 	}
+}
+
+static int *randmatrix(int size, int ld) {
+	int *matrix = alloc_matrix(size, ld);
+	if(!matrix) {
+		fprintf(stderr, "%s: memory allocation error.\n", __func__);
+		exit(1);
+	}
 
+	fillmatrix(size, ld, matrix);
 	return matrix;
 }
 
-static void printmatrix(int size, int *matrix, char name) {
+static void printmatrix(int size, int ld, int *matrix, char name) {
 	printf("Matrix %c:\n", name);
 	for (int row = 0; row < size; row++) {
 		for (int col = 0; col < size; col++) {
-			printf("%10d", matrix[row * size + col]);
+			printf("%10d", matrix[row * ld + col]);
 		}
 		printf("\n");
 	}
 }
 
-static int *mmul(int size, int *A, int *B) {
-	int *result = malloc(size * size * sizeof(*result));
-	if(!result) {
-		fprintf(stderr, "%s: memory allocation error.\n", __func__);
-		exit(1);
-	}
+static bool mmul(int size, int ld, const int *A, const int *B, int *result, struct mmul_arena *workspace) {
+	(void)workspace;
 
 	for (int i = 0; i < size; i++) {
 		for (int j = 0; j < size; j++) {
 			int sum = 0;
 			for (int k = 0; k < size; k++) {
-				sum += A[i * size + k] * B[k * size + j];
+				sum += A[i * ld + k] * B[k * ld + j];
 			}
-			result[i * size + j] = sum;
+			result[i * ld + j] = sum;
 		}
 	}
 
 /*  // for debug purpose
-	printmatrix(size, A, 'A');
-	printmatrix(size, B, 'B');
-	printmatrix(size, result, 'C');
+	printmatrix(size, ld, A, 'A');
+	printmatrix(size, ld, B, 'B');
+	printmatrix(size, ld, result, 'C');
 //*/
 
-	return result;
+	return true;
 }
 
 //--- optimized algorithms -----------------------------------------------------
@@ -88,12 +145,9 @@ static int *mmul(int size, int *A, int *B) {
 // just improve index calculation (avoid multiplications)
 // no other improvements
 // about 1.5x as fast
-static int *mmul_betterIndexCalculation(int size, int *A, int *B) {
-	int *result = malloc(size * size * sizeof(*result));
-	if(!result) {
-		fprintf(stderr, "%s: memory allocation error.\n", __func__);
-		exit(1);
-	}
+static bool mmul_betterIndexCalculation(int size, int ld, const int *A, const int *B, int *result,
+		struct mmul_arena *workspace) {
+	(void)workspace;
 
 	int a_row = 0;
 	for (int i = 0; i < size; i++) {
@@ -102,70 +156,60 @@ static int *mmul_betterIndexCalculation(int size, int *A, int *B) {
 			int b_column = 0;
 			for (int k = 0; k < size; k++) {
 				sum += A[a_row + k] * B[b_column + j];
-				b_column += size;
+				b_column += ld;
 			}
 			result[a_row + j] = sum;
 		}
-		a_row += size;
+		a_row += ld;
 	}
 
-	return result;
+	return true;
 }
 
 // C = A * B' instead of B allows access to elements of B along the cache lines
 // for testing purpose, no additional optimizations
 // note: contents of A and B will not be modified
 // runs about 2x as fast as native
-static int *mmul_transposedB(int size, int *A, int *B) {
-	int *result = malloc(size * size * sizeof(*result));
-	int *B_t = malloc(size * size * sizeof(*B_t));
-	if(!result || !B_t) {
-		fprintf(stderr, "%s: memory allocation error.\n", __func__);
-		exit(1);
+static bool mmul_transposedB(int size, int ld, const int *A, const int *B, int *result, struct mmul_arena *workspace) {
+	size_t mark = mmul_arena_mark(workspace);
+	int *B_t = mmul_arena_alloc(workspace, matrix_bytes(size, ld));
+	if(!B_t) {
+		fprintf(stderr, "%s: workspace too small.\n", __func__);
+		return false;
 	}
 
-	// transposed B (no swapping to avoid modifications in B)
-	int s_row = 0; 
-	for (int i = 0; i < size; i++) {
-		for (int j = 0; j < size; j++) {
-			B_t[size * j + i] = B[s_row + j];
-		}
-		s_row += size;
-	}	
+	// transposed B (no swapping to avoid modifications in B); in-register tiles
+	mmul_transpose(size, B, ld, B_t, ld);
 
 	// multiply
 	for (int i = 0; i < size; i++) {
 		for (int j = 0; j < size; j++) {
 			int sum = 0;
 			for (int k = 0; k < size; k++) {
-				sum += A[i * size + k] * B_t[j * size + k];
+				sum += A[i * ld + k] * B_t[j * ld + k];
 			}
-			result[i * size + j] = sum;
+			result[i * ld + j] = sum;
 		}
 	}
 
-	return result;
+	mmul_arena_release(workspace, mark);
+	return true;
 }
 
 
 // C = A * B' as above AND better index calculation
 // runs...
-static int *mmul_transposedB_and_betterIndexCalculation(int size, int *A, int *B) {
-	int *result = malloc(size * size * sizeof(*result));
-	int *B_t = malloc(size * size * sizeof(*B_t));
-	if(!result || !B_t) {
-		fprintf(stderr, "%s: memory allocation error.\n", __func__);
-		exit(1);
+static bool mmul_transposedB_and_betterIndexCalculation(int size, int ld, const int *A, const int *B, int *result,
+		struct mmul_arena *workspace) {
+	size_t mark = mmul_arena_mark(workspace);
+	int *B_t = mmul_arena_alloc(workspace, matrix_bytes(size, ld));
+	if(!B_t) {
+		fprintf(stderr, "%s: workspace too small.\n", __func__);
+		return false;
 	}
 
-	// transposed B (no swapping to avoid modifications in B)
-	int s_row = 0; 
-	for (int i = 0; i < size; i++) {
-		for (int j = 0; j < size; j++) {
-			B_t[size * j + i] = B[s_row + j];
-		}
-		s_row += size;
-	}	
+	// transposed B (no swapping to avoid modifications in B); in-register tiles
+	mmul_transpose(size, B, ld, B_t, ld);
 
 	// multiply
 	int a_row = 0;
@@ -177,68 +221,33 @@ static int *mmul_transposedB_and_betterIndexCalculation(int size, int *A, int *B
 				sum += A[a_row + k] * B_t[bt_row + k];
 			}
 			result[a_row + j] = sum;
-			bt_row += size;
+			bt_row += ld;
 		}
-		a_row += size;
+		a_row += ld;
 		bt_row = 0;
 	}
 
-	return result;
+	mmul_arena_release(workspace, mark);
+	return true;
 }
 
 // the next implementations will keep transposedB and better index calculation as a basis
 // but will use additional techniques
 
-static int block_sizes[] = {
-	1024,
-	512,
-	256,
-	64,
-	16
-};
-
-static int block_sizes_n = sizeof(block_sizes) / sizeof(block_sizes[0]);
-
-static int block_sizes_counter = 0;
-
-static int *mmul_blocks(int size, int *A, int *B) {
-	// memory for B^T and result; note: result must be zeroed!
-	int *B_t = malloc(size * size * sizeof(*B_t));
-	int *result = calloc(1, size * size * sizeof(*result));
-	if(!result || !B_t) {
-		fprintf(stderr, "%s: memory allocation error.\n", __func__);
-		exit(1);
+static bool mmul_blocks_generic(int size, int ld, const int *A, const int *B, int *result,
+		struct mmul_arena *workspace, int block) {
+	// B^T from the workspace; note: result must be zeroed!
+	size_t mark = mmul_arena_mark(workspace);
+	int *B_t = mmul_arena_alloc(workspace, matrix_bytes(size, ld));
+	if(!B_t) {
+		fprintf(stderr, "%s: workspace too small.\n", __func__);
+		return false;
 	}
+	memset(result, 0, matrix_bytes(size, ld));
 
-	// get current block size
-	assert(block_sizes_counter < block_sizes_n);
-	int block = block_sizes[block_sizes_counter++];
-
-	// transposed B (no swapping to avoid modifications in B)
-	// using blocks here (see very large matrices)
-	int s_row = 0;
-	int s_row_base = 0;
-	int s_block_step = block * size;
-	for (int i = 0; i < size; i+=block) {
-		int end_i = i+block;
-		if(end_i > size) {
-			end_i = size;
-		}
-		for (int j = 0; j < size; j+=block) {
-			int end_j = j+block;
-			if(end_j > size) {
-				end_j = size;
-			}
-			s_row = s_row_base;
-			for(int i1 = i; i1 < end_i; i1++) {
-				for(int j1 = j; j1 < end_j; j1++) {
-					B_t[size * j1 + i1] = B[s_row + j1];					
-				}
-				s_row += size;
-			}
-		}
-		s_row_base += s_block_step;
-	}
+	// transposed B (no swapping to avoid modifications in B); in-register tiles
+	mmul_transpose(size, B, ld, B_t, ld);
+	int s_block_step = block * ld;
 
 	// multiply
 	// also blocks here, since large matrices may not fit into the cache.
@@ -274,9 +283,9 @@ static int *mmul_blocks(int size, int *A, int *B) {
 							sum += A[a_row + k1] * B_t[bt_row + k1];
 						} // k1
 						result[a_row + j1] += sum; // add
-						bt_row += size;
+						bt_row += ld;
 					} // j1
-					a_row += size;
+					a_row += ld;
 				} // i1
 
 			} // k
@@ -287,49 +296,61 @@ static int *mmul_blocks(int size, int *A, int *B) {
 	} // i
 
 /*  // for debug purpose
-	printmatrix(size, A, 'A');
-	printmatrix(size, B, 'B');
-	printmatrix(size, result, 'C');
+	printmatrix(size, ld, A, 'A');
+	printmatrix(size, ld, B, 'B');
+	printmatrix(size, ld, result, 'C');
 //*/
 
-	return result;
+	mmul_arena_release(workspace, mark);
+	return true;
 }
 
-static int block_sizes_acc4[] = {
-	1024,
-	512,
-	256,
-	64,
-	16
-};
+// entry point of the blocked versions: sizes with a kernel specialized at compile time
+// (mmul_fixed.h; contiguous rows only) are dispatched to it; there, the block size does not matter
+static bool mmul_blocks_into(int size, int ld, const int *A, const int *B, int *result,
+		struct mmul_arena *workspace, int block) {
+	mmul_fixed_function fixed = ld == size ? mmul_fixed_kernel(size) : NULL;
+	if(fixed) {
+		fixed(A, B, result);
+		return true;
+	}
+	return mmul_blocks_generic(size, ld, A, B, result, workspace, block);
+}
 
-static int block_sizes_acc4_n = sizeof(block_sizes_acc4) / sizeof(block_sizes_acc4[0]);
+// table entries with fixed block sizes
+#define DEFINE_BLOCKS(block) \
+	static bool mmul_blocks_##block(int size, int ld, const int *A, const int *B, int *C, \
+			struct mmul_arena *workspace) { \
+		return mmul_blocks_into(size, ld, A, B, C, workspace, block); \
+	}
 
-static int block_sizes_acc4_counter = 0;
+DEFINE_BLOCKS(1024)
+DEFINE_BLOCKS(512)
+DEFINE_BLOCKS(256)
+DEFINE_BLOCKS(64)
+DEFINE_BLOCKS(16)
 
 // currently 4 accumulators in parallel in the center of the loops
 // note: block sizes must be dividable by 4!
 // this destroys automatic vectorization by the compiler
 // is about 3x slower than fast blocks version above
 // could be pottentially helpful only on processors that do not allow vetorization at all
-static int *mmul_blocks_multiple_accumulators_naive_1st_try(int size, int *A, int *B) {
-	// memory for B^T and result; note: result must be zeroed!
-	int *B_t = malloc(size * size * sizeof(*B_t));
-	int *result = calloc(1, size * size * sizeof(*result));
-	if(!result || !B_t) {
-		fprintf(stderr, "%s: memory allocation error.\n", __func__);
-		exit(1);
+static bool mmul_blocks_multiple_accumulators_naive_1st_try(int size, int ld, const int *A, const int *B, int *result,
+		struct mmul_arena *workspace, int block) {
+	// B^T from the workspace; note: result must be zeroed!
+	size_t mark = mmul_arena_mark(workspace);
+	int *B_t = mmul_arena_alloc(workspace, matrix_bytes(size, ld));
+	if(!B_t) {
+		fprintf(stderr, "%s: workspace too small.\n", __func__);
+		return false;
 	}
-
-	// get current block size
-	assert(block_sizes_acc4_counter < block_sizes_acc4_n);
-	int block = block_sizes_acc4[block_sizes_acc4_counter++];
+	memset(result, 0, matrix_bytes(size, ld));
 
 	// transposed B (no swapping to avoid modifications in B)
 	// using blocks here (see very large matrices)
 	int s_row = 0;
 	int s_row_base = 0;
-	int s_block_step = block * size;
+	int s_block_step = block * ld;
 	for (int i = 0; i < size; i+=block) {
 		int end_i = i+block;
 		if(end_i > size) {
@@ -343,9 +364,9 @@ static int *mmul_blocks_multiple_accumulators_naive_1st_try(int size, int *A, in
 			s_row = s_row_base;
 			for(int i1 = i; i1 < end_i; i1++) {
 				for(int j1 = j; j1 < end_j; j1++) {
-					B_t[size * j1 + i1] = B[s_row + j1];					
+					B_t[ld * j1 + i1] = B[s_row + j1];					
 				}
-				s_row += size;
+				s_row += ld;
 			}
 		}
 		s_row_base += s_block_step;
@@ -406,9 +427,9 @@ static int *mmul_blocks_multiple_accumulators_naive_1st_try(int size, int *A, in
 						} // k1
 
 						result[a_row + j1] += sum + sum_a; // add
-						bt_row += size;
+						bt_row += ld;
 					} // j1
-					a_row += size;
+					a_row += ld;
 				} // i1
 
 			} // k
@@ -419,12 +440,13 @@ static int *mmul_blocks_multiple_accumulators_naive_1st_try(int size, int *A, in
 	} // i
 
 /*  // for debug purpose
-	printmatrix(size, A, 'A');
-	printmatrix(size, B, 'B');
-	printmatrix(size, result, 'C');
+	printmatrix(size, ld, A, 'A');
+	printmatrix(size, ld, B, 'B');
+	printmatrix(size, ld, result, 'C');
 //*/
 
-	return result;
+	mmul_arena_release(workspace, mark);
+	return true;
 }
 
 // second hopefully better approach that partitions the block differently
@@ -432,44 +454,44 @@ static int *mmul_blocks_multiple_accumulators_naive_1st_try(int size, int *A, in
 // currently set to partitions of at least 64 values
 // i.e. block sizes of at least 256 values
 // for testing purpose also blocks allowed of min size 16 values
-static int *mmul_blocks_multiple_accumulators(int size, int *A, int *B) {
-	// memory for B^T and result; note: result must be zeroed!
-	int *B_t = malloc(size * size * sizeof(*B_t));
-	int *result = calloc(1, size * size * sizeof(*result));
-	if(!result || !B_t) {
-		fprintf(stderr, "%s: memory allocation error.\n", __func__);
-		exit(1);
+// the accumulators are generalized to 1, 2, 4, or 8 partitions (see dot_partitions());
+// the table uses 4
+#define MAX_ACCUMULATORS 8
+
+// sum of a[i] * b[i] over parts partitions of partition_size values, one accumulator each;
+// inlined with a constant parts
+static inline int dot_partitions(const int *a, const int *b, int partition_size, int parts) {
+	int sums[MAX_ACCUMULATORS] = {0};
+	for(int offset = 0; offset < partition_size; offset++) {
+		for(int p = 0; p < parts; p++) {
+			sums[p] += a[p * partition_size + offset] * b[p * partition_size + offset];
+		}
 	}
+	int sum = 0;
+	for(int p = 0; p < parts; p++) {
+		sum += sums[p];
+	}
+	return sum;
+}
 
-	// get current block size
-	assert(block_sizes_acc4_counter < block_sizes_acc4_n);
-	int block = block_sizes_acc4[block_sizes_acc4_counter++];
+static bool mmul_blocks_accumulators_into(int size, int ld, const int *A, const int *B, int *result,
+		struct mmul_arena *workspace, int block, int accumulators) {
+	if(accumulators != 1 && accumulators != 2 && accumulators != 8) {
+		accumulators = 4;
+	}
 
-	// transposed B (no swapping to avoid modifications in B)
-	// using blocks here (see very large matrices)
-	int s_row = 0;
-	int s_row_base = 0;
-	int s_block_step = block * size;
-	for (int i = 0; i < size; i+=block) {
-		int end_i = i+block;
-		if(end_i > size) {
-			end_i = size;
-		}
-		for (int j = 0; j < size; j+=block) {
-			int end_j = j+block;
-			if(end_j > size) {
-				end_j = size;
-			}
-			s_row = s_row_base;
-			for(int i1 = i; i1 < end_i; i1++) {
-				for(int j1 = j; j1 < end_j; j1++) {
-					B_t[size * j1 + i1] = B[s_row + j1];					
-				}
-				s_row += size;
-			}
-		}
-		s_row_base += s_block_step;
+	// B^T from the workspace; note: result must be zeroed!
+	size_t mark = mmul_arena_mark(workspace);
+	int *B_t = mmul_arena_alloc(workspace, matrix_bytes(size, ld));
+	if(!B_t) {
+		fprintf(stderr, "%s: workspace too small.\n", __func__);
+		return false;
 	}
+	memset(result, 0, matrix_bytes(size, ld));
+
+	// transposed B (no swapping to avoid modifications in B); in-register tiles
+	mmul_transpose(size, B, ld, B_t, ld);
+	int s_block_step = block * ld;
 
 	// multiply
 	// also blocks here, since large matrices may not fit into the cache.
@@ -483,7 +505,7 @@ static int *mmul_blocks_multiple_accumulators(int size, int *A, int *B) {
 	// (easier to implement) -> if worthwhile, extended general version may follow
 	// currently: just pick nice block sizes that allow a good balance of wins by partitioning
 	// and caching blocks
-	int partition_size = block / 4;
+	int partition_size = block / accumulators;
 	
 	for (int i = 0; i < size; i+=block) {
 		int end_i = i+block;
@@ -512,40 +534,36 @@ static int *mmul_blocks_multiple_accumulators(int size, int *A, int *B) {
 				// loops inside of the blocks
 				a_row = a_row_base;
 
-				bool use_partitioning = full_i_block && full_j_block && full_k_block;
+				bool use_partitioning = full_i_block && full_j_block && full_k_block
+					&& partition_size * accumulators == block;
 				
 				for(int i1 = i; i1 < end_i; i1++) {
-					int a_base_a = a_row + k;
-					int a_base_b = a_base_a + partition_size;
-					int a_base_c = a_base_b + partition_size;
-					int a_base_d = a_base_c + partition_size;
+					const int *a_base = A + a_row + k;
 
 					bt_row = bt_row_base;
 
 					for(int j1 = j; j1 < end_j; j1++) {
-						int bt_base_a = bt_row + k;
-						int bt_base_b = bt_base_a + partition_size;
-						int bt_base_c = bt_base_b + partition_size;
-						int bt_base_d = bt_base_c + partition_size;
+						const int *bt_base = B_t + bt_row + k;
 						
 						// currently a very simple heuristic to decide whether partitioning shall
 						// be used. current simple decision: use it only on full sized quadratic blocks 
 						if(use_partitioning) {
-							int sum_a = 0;
-							int sum_b = 0;
-							int sum_c = 0;
-							int sum_d = 0;
-							
-							for(int offset = 0; offset < partition_size; offset++) {
-								sum_a += A[a_base_a + offset] * B_t[bt_base_a + offset];
-								sum_b += A[a_base_b + offset] * B_t[bt_base_b + offset];
-								sum_c += A[a_base_c + offset] * B_t[bt_base_c + offset];
-								sum_d += A[a_base_d + offset] * B_t[bt_base_d + offset];
+							int sum;
+							switch(accumulators) {
+							case 1:
+								sum = dot_partitions(a_base, bt_base, partition_size, 1);
+								break;
+							case 2:
+								sum = dot_partitions(a_base, bt_base, partition_size, 2);
+								break;
+							case 8:
+								sum = dot_partitions(a_base, bt_base, partition_size, 8);
+								break;
+							default:
+								sum = dot_partitions(a_base, bt_base, partition_size, 4);
+								break;
 							}
-
-							sum_a += sum_b;
-							sum_c += sum_d;
-							result[a_row + j1] += sum_a + sum_c; // add to result
+							result[a_row + j1] += sum; // add to result
 						}
 						else {
 							int sum = 0;
@@ -557,9 +575,9 @@ static int *mmul_blocks_multiple_accumulators(int size, int *A, int *B) {
 							result[a_row + j1] += sum; // add to result							
 						}
 
-						bt_row += size;
+						bt_row += ld;
 					} // j1
-					a_row += size;
+					a_row += ld;
 				} // i1
 
 			} // k
@@ -570,18 +588,58 @@ static int *mmul_blocks_multiple_accumulators(int size, int *A, int *B) {
 	} // i
 
 /*  // for debug purpose
-	printmatrix(size, A, 'A');
-	printmatrix(size, B, 'B');
-	printmatrix(size, result, 'C');
+	printmatrix(size, ld, A, 'A');
+	printmatrix(size, ld, B, 'B');
+	printmatrix(size, ld, result, 'C');
 //*/
 
-	return result;
+	mmul_arena_release(workspace, mark);
+	return true;
+}
+
+#define DEFINE_BLOCKS_ACCUMULATORS_4(block) \
+	static bool mmul_blocks_##block##_accumulators_4(int size, int ld, const int *A, const int *B, int *C, \
+			struct mmul_arena *workspace) { \
+		return mmul_blocks_accumulators_into(size, ld, A, B, C, workspace, block, 4); \
+	}
+
+DEFINE_BLOCKS_ACCUMULATORS_4(1024)
+DEFINE_BLOCKS_ACCUMULATORS_4(512)
+DEFINE_BLOCKS_ACCUMULATORS_4(256)
+DEFINE_BLOCKS_ACCUMULATORS_4(64)
+DEFINE_BLOCKS_ACCUMULATORS_4(16)
+
+//--- packed micro-kernel, multithreaded, Strassen-Winograd --------------------
+
+// packing buffers from the workspace
+static bool packed_into(int size, int ld, const int *A, const int *B, int *C, struct mmul_arena *workspace,
+		const struct mmul_packed_blocking *blocking) {
+	size_t mark = mmul_arena_mark(workspace);
+	struct mmul_packed_workspace ws;
+	mmul_packed_workspace_size(size, size, size, blocking, &ws.a_bytes, &ws.b_bytes);
+	ws.packed_A = mmul_arena_alloc(workspace, ws.a_bytes);
+	ws.packed_B = mmul_arena_alloc(workspace, ws.b_bytes);
+	memset(C, 0, matrix_bytes(size, ld)); // C += A * B
+	bool ok = ws.packed_A && ws.packed_B
+		&& mmul_packed_gemm_workspace(size, size, size, A, ld, B, ld, C, ld, blocking, &ws);
+	mmul_arena_release(workspace, mark);
+	return ok;
+}
+
+static bool mmul_packed(int size, int ld, const int *A, const int *B, int *C, struct mmul_arena *workspace) {
+	return packed_into(size, ld, A, B, C, workspace, NULL);
+}
+
+// all threads of the pool; the packing buffers of the pool threads are kept by the pool
+static bool mmul_parallel(int size, int ld, const int *A, const int *B, int *C, struct mmul_arena *workspace) {
+	(void)workspace;
+	return mmul_parallel_gemm(size, ld, A, B, C, 0, 0);
 }
 
 //--- additional things --------------------------------------------------------
 
 // simple, not optimized version
-bool compare_matrices(int size, int *C, int *ref) {
+bool compare_matrices(int size, int ld, int *C, int *ref) {
 	int row = 0;
 	for (int i = 0; i < size; i++) {
 		for (int j = 0; j < size; j++) {
@@ -590,188 +648,1660 @@ bool compare_matrices(int size, int *C, int *ref) {
 				return false;
 			}
 		}
-		row += size;
+		row += ld;
 	}
 	return true;
 }
 
-typedef int *(*matrix_multiplier)(int, int *, int *);
-
 // to avoid side effects by caching, testing the algorithms for correctness
 // and timing them has been split into 2 separate routines
 // Note: fresh matrices A and B are created each time from scratch for timing
 
+// verification of the results: exact comparison with the reference of mmul() (O(size^3)),
+// or Freivalds' algorithm (O(size^2) per round; mmul_verify.h) for large sizes
+#define VERIFY_EXACT_MAX_SIZE 512
+
+struct verification {
+	int *ref;      // exact reference; NULL: Freivalds
+	int rounds;    // Freivalds
+	uint64_t seed; // Freivalds: the same random vectors for all algorithms
+};
+
 // tests a given algorithm mm on correctness
-bool check_algorithm(int size, int *A, int *B, int *ref, matrix_multiplier mm, char *name) {
+// workspace: with mmul_freivalds_workspace_bytes() free in addition for Freivalds
+bool check_algorithm(int size, int ld, int *A, int *B, const struct verification *verify, matrix_multiplier mm,
+		char *name, struct mmul_arena *workspace) {
 	fprintf(stderr, "checking: %s... ", name);
-	int *C = mm(size, A, B);
-
+	int *C = alloc_matrix(size, ld);
 	if(!C) {
 		fprintf(stderr, "Memory error!\n");
 		return false;
 	}
 
-	if(!compare_matrices(size, C, ref)) {
-		fprintf(stderr, "FAILED. Wrong result.\n");
-		free(C);
+	if(!mm(size, ld, A, B, C, workspace)) {
+		fprintf(stderr, "FAILED. Error.\n");
+		free_matrix(size, ld, C);
+		C = NULL;
+		return false;
+	}
+
+	int error_round = -1;
+	bool ok = verify->ref ? compare_matrices(size, ld, C, verify->ref)
+		: mmul_freivalds(size, ld, A, B, C, verify->rounds, verify->seed, workspace, &error_round);
+	if(!ok) {
+		if(verify->ref) {
+			fprintf(stderr, "FAILED. Wrong result.\n");
+		}
+		else if(error_round >= 0) {
+			fprintf(stderr, "FAILED. Wrong result (Freivalds round %d).\n", error_round + 1);
+		}
+		else {
+			// not a verdict on the result
+			fprintf(stderr, "FAILED. Workspace too small for Freivalds' algorithm (memory error).\n");
+		}
+		free_matrix(size, ld, C);
 		C = NULL;
 		return false;
 	}
 
 	fprintf(stderr, "RESULT OK.\n");
-	free(C);
+	free_matrix(size, ld, C);
 	C = NULL;
 	return true;
 }
 
-// banchmarks the algorithms
-bool time_algorithm(int size, matrix_multiplier mm, char *name) {
+// resident set size in KiB; -1 if not available (Linux only)
+static long rss_kib(void) {
+	long pages = -1;
+	FILE *f = fopen("/proc/self/statm", "r");
+	if(f) {
+		if(fscanf(f, "%*d %ld", &pages) != 1) {
+			pages = -1;
+		}
+		fclose(f);
+	}
+	return pages < 0 ? -1 : pages * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// banchmarks the algorithms; reported separately:
+// - compute:         repetitions calls with C and workspace allocated before and reused;
+//                    full statistics (the values of the table)
+//                    inputs: reused, or fresh random A and B before each call (untimed)
+//                    caches: warm (A, B, C pre-touched) or cold (LLC evicted, A, B, C flushed)
+//                    before each call; see testbench_prepare_cache()
+// - with allocation: C and workspace allocated (prefaulted) and freed within the measurement;
+//                    1 call, as all versions returned a new matrix before; a single sample,
+//                    thus reported in a table of its own
+// the resident set size before and after the repeated calls shows whether they allocate
+#define TIME_REPETITIONS 5
+
+struct timing_config {
+	int repetitions;
+	bool cold;
+	bool fresh;
+	double tsc_ghz; // for Gop/s; <= 0: not available
+};
+
+struct timing_result {
+	struct testbench_statistics stat;
+	double with_allocation; // cycles
+	long rss_delta;         // KiB; LONG_MIN if not available
+};
+
+bool time_algorithm(int size, int ld, matrix_multiplier mm, char *name, const struct timing_config *config,
+		struct timing_result *result) {
 	uint64_t stop = 0;
 	uint64_t start = 0;
 
 	fprintf(stderr, "preparing matrices... ");
-	reset_testbench();
-	int *A = randmatrix(size);
+	int *A = randmatrix(size, ld);
 	if(!A) {
 		fprintf(stderr, "Memory error!\n");
 		return false;
 	}
-	int *B = randmatrix(size);
+	int *B = randmatrix(size, ld);
 	if(!B) {
 		fprintf(stderr, "Memory error!\n");
-		free(A);
+		free_matrix(size, ld, A);
 		A = NULL;
 		return false;
 	}
 
 	fprintf(stderr, "running: %s... ", name);	
+	// the arena is empty (base NULL) unless created; mmul_arena_delete() accepts both
+	struct mmul_arena workspace = {NULL, 0, 0};
+	bool allocated = true; // C and workspace
+	bool computed = true;  // all calls of mm returned true
+	reset_testbench();
 	RDTSC_START(start);
-	int *C = mm(size, A, B);
+	int *C = alloc_matrix(size, ld);
+	allocated = C && mmul_arena_create(&workspace, mmul_workspace_bytes(size, ld));
+	if(allocated) {
+		computed = mm(size, ld, A, B, C, &workspace);
+	}
+	mmul_arena_delete(&workspace);
+	free_matrix(size, ld, C);
 	RDTSC_STOP(stop);
 	add_measurement(start, stop);
+	result->with_allocation = testbench_get_statistics().mean;
+
+	C = NULL;
+	if(allocated && computed) {
+		C = alloc_matrix(size, ld);
+		allocated = C && mmul_arena_create(&workspace, mmul_workspace_bytes(size, ld));
+	}
+	testbench_clear_buffers();
+	testbench_declare_buffer(A, matrix_bytes(size, ld));
+	testbench_declare_buffer(B, matrix_bytes(size, ld));
+	if(C) {
+		testbench_declare_buffer(C, matrix_bytes(size, ld));
+	}
+	long rss_before = rss_kib();
+	reset_testbench();
+	for(int r = 0; r < config->repetitions && allocated && computed; r++) {
+		if(config->fresh) {
+			fillmatrix(size, ld, A);
+			fillmatrix(size, ld, B);
+		}
+		testbench_prepare_cache();
+		RDTSC_START(start);
+		computed = mm(size, ld, A, B, C, &workspace);
+		RDTSC_STOP(stop);
+		add_measurement(start, stop);
+	}
+	long rss_after = rss_kib();
+	testbench_clear_buffers();
+	mmul_arena_delete(&workspace);
 
-	free(B);
+	free_matrix(size, ld, C);
+	C = NULL;
+	free_matrix(size, ld, B);
 	B = NULL;
-	free(A);
+	free_matrix(size, ld, A);
 	A = NULL;
 
-	if(!C) {
+	if(!allocated) {
 		fprintf(stderr, "Memory error!\n");
 		return false;
 	}
+	if(!computed) {
+		fprintf(stderr, "Error: %s failed (returned false).\n", name);
+		return false;
+	}
 
-	free(C);
-	C = NULL;
-
-	struct testbench_statistics stat = testbench_get_statistics();
-	//print_testbench_statistics(title, stat); // no need for n only 1
-	//print_histogram(title, stat); // not possible with n only 1
+	result->stat = testbench_get_statistics();
+	result->rss_delta = rss_before >= 0 && rss_after >= 0 ? rss_after - rss_before : LONG_MIN;
 
 	uint64_t size3 = (uint64_t)size;
 	size3 = size3 * size3 * size3;
-	double cpi = stat.mean / (double)(size3);
-	fprintf(stderr, "%e cycles, %f cycles / iteration (size^3)\n", stat.mean, cpi);
-	printf("\t%e", cpi);
+	double cpi = result->stat.median / (double)(size3);
+	fprintf(stderr, "%e cycles, %f cycles / iteration (size^3)\n", result->stat.median, cpi);
+	fprint_testbench_statistics(stderr, name, &result->stat, NULL);
 
 	return true;
 }
 
+// table on stdout: one row per algorithm, tab separated; a multiply-add counts as 2 operations
+// (int: multiplication and addition); the confidence intervals are the 95% CI of the mean;
+// thus, Gop/s is given for the mean cycles with the bounds of this CI (a CI of the median
+// would need more repetitions); the upper bound is inf if the CI reaches down to 0 cycles;
+// the CI columns are n/a without a CI (n < 2)
+static void print_table_header(int size, int ld, const struct timing_config *config) {
+	printf("\n# mmul: matrix size %d, leading dimension %d, %d repetitions, %s caches, %s inputs,"
+		" packed micro-kernel %s\n", size, ld, config->repetitions, config->cold ? "cold" : "warm",
+		config->fresh ? "fresh" : "reused", mmul_packed_kernel_name());
+	printf("algorithm\tsize\tn\tmedian_cycles\tmean_cycles\tci95_low\tci95_high\tcycles_per_madd"
+		"\tgops_mean\tgops_ci95_low\tgops_ci95_high\trss_delta_kib\n");
+}
 
-static matrix_multiplier tests[] = {
-	mmul,
-	mmul_betterIndexCalculation,
-	mmul_transposedB,
-	mmul_transposedB_and_betterIndexCalculation,
-	mmul_blocks,
-	mmul_blocks,
-	mmul_blocks,
-	mmul_blocks,
-	mmul_blocks,
-	mmul_blocks_multiple_accumulators,
-	mmul_blocks_multiple_accumulators,
-	mmul_blocks_multiple_accumulators,
-	mmul_blocks_multiple_accumulators,
-	mmul_blocks_multiple_accumulators		
-};
+static void print_table_row(const char *name, int size, const struct timing_config *config,
+		const struct timing_result *result) {
+	const struct testbench_statistics *stat = &result->stat;
+	double size3 = (double)size * size * size;
+	// no CI for n < 2 (e.g. -r 1)
+	bool ci = stat->count >= 2 && stat->ci95_b > 0.0;
+	printf("%s\t%d\t%zu\t%.0f\t%.1f", name, size, stat->count, stat->median, stat->mean);
+	if(ci) {
+		printf("\t%.1f\t%.1f", stat->ci95_a, stat->ci95_b);
+	}
+	else {
+		printf("\tn/a\tn/a");
+	}
+	printf("\t%.6f", stat->median / size3);
+	if(config->tsc_ghz > 0.0) {
+		// ops per cycle times cycles per ns = Gop/s
+		double ops = 2.0 * size3;
+		if(stat->mean > 0.0) {
+			printf("\t%.3f", ops / stat->mean * config->tsc_ghz);
+		}
+		else {
+			printf("\tn/a");
+		}
+		if(ci) {
+			printf("\t%.3f", ops / stat->ci95_b * config->tsc_ghz);
+			if(stat->ci95_a > 0.0) {
+				printf("\t%.3f", ops / stat->ci95_a * config->tsc_ghz);
+			}
+			else {
+				printf("\tinf");
+			}
+		}
+		else {
+			printf("\tn/a\tn/a");
+		}
+	}
+	else {
+		printf("\tn/a\tn/a\tn/a");
+	}
+	if(result->rss_delta != LONG_MIN) {
+		printf("\t%ld\n", result->rss_delta);
+	}
+	else {
+		printf("\tn/a\n");
+	}
+}
 
-static char *names[] = {
-	"default",
-	"betterIndexCalculation",
-	"transposedB",
-	"transposedAndBetterIndex",
-	"blocks_1024",
-	"blocks_512",
-	"blocks_256",
-	"blocks_64",
-	"blocks_16",
-	"blocks_1024_accumulators_4",
-	"blocks_512_accumulators_4",
-	"blocks_256_accumulators_4",
-	"blocks_64_accumulators_4",
-	"blocks_16_accumulators_4"	
+// second table: the single call with allocation per algorithm (one sample; no statistics)
+static void print_allocation_table(int size, char **names, const struct timing_result *results, int n) {
+	printf("\n# mmul: matrix size %d, 1 call each including the allocation of C and the workspace\n", size);
+	printf("algorithm\tsize\twith_allocation_cycles\n");
+	for(int i = 0; i < n; i++) {
+		printf("%s\t%d\t%.0f\n", names[i], size, results[i].with_allocation);
+	}
+}
+
+
+// scaling over threads: each thread multiplies the same matrices (weak scaling)
+// the result and the workspace (B') of each thread are allocated before the measurement
+#define SCALING_ROUNDS 5
+
+struct scaling_context {
+	int size;
+	int *A;
+	int *B;
+	size_t n_threads; // allocated per-thread buffers
+	int **C;
+	struct mmul_arena *workspace;
 };
 
-int main(int argc, char **argv) {
-	if (argc != 2) {
-		fprintf(stderr, "USAGE: mmul <matrix_size> >result.txt\n");
-		return 1;
-	}
-	int size = atoi(argv[1]);
-	fprintf(stderr, "CASP Simple Matrix Multiplicator. Matrix size: %d\n", size);
+static void mmul_scaling(void *context, size_t thread_index, size_t n_threads) {
+	(void)n_threads;
+	struct scaling_context *c = context;
+	mmul_transposedB_and_betterIndexCalculation(c->size, c->size, c->A, c->B, c->C[thread_index], &c->workspace[thread_index]);
+}
 
-	// initialization
-	if( !create_testbench(TESTBENCH_STD_N) ) {
-		fprintf(stderr, "Error: could not open testbench (memory?).\n");
-		exit(1);
+static void free_scaling_buffers(struct scaling_context *c) {
+	for (size_t i = 0; i < c->n_threads; i++) {
+		free_matrix(c->size, c->size, c->C[i]);
+		mmul_arena_delete(&c->workspace[i]);
 	}
-	set_denominator(1);
+	free(c->workspace);
+	free(c->C);
+	free_matrix(c->size, c->size, c->B);
+	free_matrix(c->size, c->size, c->A);
+}
 
-	srand(time(NULL));
+bool time_scaling(int size) {
+	struct scaling_context c;
+	c.size = size;
+	c.A = randmatrix(size, size);
+	c.B = randmatrix(size, size);
+	c.n_threads = testbench_available_cpus();
+	if (c.n_threads > TESTBENCH_PARALLEL_MAX_THREADS) {
+		c.n_threads = TESTBENCH_PARALLEL_MAX_THREADS;
+	}
+	c.C = calloc(c.n_threads, sizeof(*c.C));
+	c.workspace = calloc(c.n_threads, sizeof(*c.workspace));
+	bool ok = c.A && c.B && c.C && c.workspace;
+	for (size_t i = 0; ok && i < c.n_threads; i++) {
+		c.C[i] = alloc_matrix(size, size);
+		ok = c.C[i] && mmul_arena_create(&c.workspace[i], matrix_bytes(size, size));
+	}
+	if (!ok) {
+		fprintf(stderr, "Memory error!\n");
+		if (!c.C || !c.workspace) {
+			c.n_threads = 0;
+		}
+		free_scaling_buffers(&c);
+		return false;
+	}
 
-	int *A = randmatrix(size);
-	//printmatrix(size, A, 'A');
+	uint64_t size3 = (uint64_t)size;
+	size3 = size3 * size3 * size3;
+	struct testbench_scaling_config config = {
+		.max_threads = c.n_threads,
+		.rounds = SCALING_ROUNDS,
+		.pin = true,
+		.work_per_call = 2.0 * (double)size3,
+		.work_unit = "op"
+	};
+	struct testbench_scaling_point points[TESTBENCH_PARALLEL_MAX_THREADS];
+	size_t n_points = testbench_run_scaling(mmul_scaling, &c, &config, points, TESTBENCH_PARALLEL_MAX_THREADS);
+	if (n_points > 0) {
+		fprint_testbench_scaling(stderr, "scaling: transposedAndBetterIndex", points, n_points, &config, NULL);
+		testbench_free_scaling(points, n_points);
+	}
 
-	int *B = randmatrix(size);
-	//printmatrix(size, B, 'B');
+	free_scaling_buffers(&c);
+	return n_points > 0;
+}
 
-	// reference result
-	fprintf(stderr, "calculating reference solution for comparison.\n");
-	int *ref = mmul(size, A, B);
+// strong scaling of the tiled multiplication with work stealing: one multiplication
+// of size x size is split over 1, 2, 4, ... threads of the pool
+#define PARALLEL_ROUNDS 3
 
-	// prepare table header
-	int n_tests = sizeof(tests) / sizeof(tests[0]);
-	printf("\n\nsize");
-	for(int i = 0; i < n_tests; i++) {
-		printf("\t%s", names[i]);
+static bool time_parallel(int size, int tile) {
+	int *A = randmatrix(size, size);
+	int *B = randmatrix(size, size);
+	int *C = alloc_matrix(size, size);
+	if (!A || !B || !C) {
+		fprintf(stderr, "Memory error!\n");
+		free_matrix(size, size, C);
+		free_matrix(size, size, B);
+		free_matrix(size, size, A);
+		return false;
 	}
-	printf("\n%d", size);
 
-	// check algorithms to be tested:
-	for(int i = 0; i < n_tests; i++) {
-		if(!check_algorithm(size, A, B, ref, tests[i], names[i])) {
-			free(B);
-			B = NULL;
-			free(A);
-			A = NULL;
-			exit(1);
+	uint64_t size3 = (uint64_t)size;
+	size3 = size3 * size3 * size3;
+	fprintf(stderr, "\nparallel tiles (work stealing): size %d, tile %d\n", size, tile > 0 ? tile : MMUL_PARALLEL_TILE);
+	fprintf(stderr, "threads   median cycles   cycles/size^3   speedup   efficiency   tiles   steals\n");
+
+	bool ok = true;
+	double base = 0.0;
+	int max_threads = mmul_parallel_threads() > 0 ? mmul_parallel_threads() : 1;
+	for (int t = 1; ; t *= 2) {
+		if (t > max_threads) {
+			t = max_threads;
+		}
+		reset_testbench();
+		for (int r = 0; r < PARALLEL_ROUNDS && ok; r++) {
+			uint64_t start = 0;
+			uint64_t stop = 0;
+			RDTSC_START(start);
+			ok = mmul_parallel_gemm(size, size, A, B, C, t, tile);
+			RDTSC_STOP(stop);
+			add_measurement(start, stop);
+		}
+		if (!ok) {
+			fprintf(stderr, "Memory error!\n");
+			break;
+		}
+		struct testbench_statistics stat = testbench_get_statistics();
+		struct mmul_parallel_stats ps = mmul_parallel_get_stats();
+		if (t == 1) {
+			base = stat.median;
+		}
+		double speedup = base / stat.median;
+		fprintf(stderr, "%7zu   %13.0f   %13.4f   %7.2f   %10.2f   %5zu   %6zu\n",
+			ps.threads, stat.median, stat.median / (double)size3, speedup, speedup / (double)ps.threads,
+			ps.tiles, ps.steals);
+		if (t == max_threads) {
+			break;
 		}
 	}
-	fprintf(stderr, "\n");
-	free(B);
-	B = NULL;
-	free(A);
-	A = NULL;
 
-	// benchmark algorithms to be tested:
-	block_sizes_counter = 0;
-	block_sizes_acc4_counter = 0;
-	for(int i = 0; i < n_tests; i++) {
-		if(!time_algorithm(size, tests[i], names[i])) {
-			break;
+	free_matrix(size, size, C);
+	free_matrix(size, size, B);
+	free_matrix(size, size, A);
+	return ok;
+}
+
+// sizes 256, 512, ... up to max_size (or max_size only if smaller)
+bool time_parallel_scaling(int max_size, int tile) {
+	if (max_size < 256) {
+		return time_parallel(max_size, tile);
+	}
+	for (int size = 256; size <= max_size; size *= 2) {
+		if (!time_parallel(size, tile)) {
+			return false;
 		}
 	}
+	return true;
+}
+
+//--- autotuning ---------------------------------------------------------------
+//    mmul tune <size> ... searches per size with successive halving (mmul_tune.h):
+//    - blocks:       block size of mmul_blocks_into()
+//    - accumulators: block size and number of accumulators of mmul_blocks_accumulators_into()
+//    - packed:       mc, kc, nc of the packed micro-kernel
+//    - parallel:     tile size of the multithreaded version (all threads of the pool)
+//    - strassen:     crossover size of Strassen-Winograd to the packed micro-kernel
+//    the winners are stored in the tuning cache; the *_tuned multipliers below use them
+
+static int tune_block_sizes[] = {16, 32, 64, 128, 256, 512, 1024};
+static int tune_accumulators[] = {1, 2, 4, 8};
+static int tune_mc[] = {64, 128, 256};
+static int tune_kc[] = {128, 256, 512};
+static int tune_nc[] = {1024, 4096};
+static int tune_tiles[] = {64, 128, 256, 512};
+static int tune_crossovers[] = {64, 128, 256, 512, 1024};
+
+#define N_OF(a) ((int)(sizeof(a) / sizeof((a)[0])))
+
+// defaults without a tuning cache entry
+static const int default_blocks[MMUL_TUNE_PARAMS] = {256, 0, 0};
+static const int default_accumulators[MMUL_TUNE_PARAMS] = {256, 4, 0};
+static const int default_packed[MMUL_TUNE_PARAMS] = {MMUL_PACKED_MC, MMUL_PACKED_KC, MMUL_PACKED_NC};
+static const int default_parallel[MMUL_TUNE_PARAMS] = {MMUL_PARALLEL_TILE, 0, 0};
+static const int default_strassen[MMUL_TUNE_PARAMS] = {MMUL_STRASSEN_CROSSOVER, 0, 0};
+
+static void tuned_params(const char *kind, int size, const int *defaults, int *params) {
+	if(!mmul_tune_lookup(kind, size, params)) {
+		memcpy(params, defaults, MMUL_TUNE_PARAMS * sizeof(int));
+	}
+}
+
+static bool mmul_blocks_tuned(int size, int ld, const int *A, const int *B, int *C, struct mmul_arena *workspace) {
+	int p[MMUL_TUNE_PARAMS];
+	tuned_params("blocks", size, default_blocks, p);
+	return mmul_blocks_into(size, ld, A, B, C, workspace, p[0]);
+}
+
+static bool mmul_accumulators_tuned(int size, int ld, const int *A, const int *B, int *C, struct mmul_arena *workspace) {
+	int p[MMUL_TUNE_PARAMS];
+	tuned_params("accumulators", size, default_accumulators, p);
+	return mmul_blocks_accumulators_into(size, ld, A, B, C, workspace, p[0], p[1]);
+}
+
+static bool mmul_packed_tuned(int size, int ld, const int *A, const int *B, int *C, struct mmul_arena *workspace) {
+	int p[MMUL_TUNE_PARAMS];
+	tuned_params("packed", size, default_packed, p);
+	struct mmul_packed_blocking blocking = {p[0], p[1], p[2]};
+	return packed_into(size, ld, A, B, C, workspace, &blocking);
+}
+
+static bool mmul_parallel_tuned(int size, int ld, const int *A, const int *B, int *C, struct mmul_arena *workspace) {
+	(void)workspace;
+	int p[MMUL_TUNE_PARAMS];
+	tuned_params("parallel", size, default_parallel, p);
+	return mmul_parallel_gemm(size, ld, A, B, C, 0, p[0]);
+}
+
+static bool mmul_strassen_tuned(int size, int ld, const int *A, const int *B, int *C, struct mmul_arena *workspace) {
+	int p[MMUL_TUNE_PARAMS];
+	tuned_params("strassen", size, default_strassen, p);
+	return mmul_strassen_gemm(size, ld, A, B, C, p[0], workspace);
+}
+
+// B^T, packing buffers of the blocking, Strassen temporaries of the crossover
+static size_t workspace_bytes_for(int size, int ld, const struct mmul_packed_blocking *blocking, int crossover) {
+	size_t bytes = mmul_arena_bytes(matrix_bytes(size, ld));
+	size_t a_bytes = 0;
+	size_t b_bytes = 0;
+	mmul_packed_workspace_size(size, size, size, blocking, &a_bytes, &b_bytes);
+	size_t packed = mmul_arena_bytes(a_bytes) + mmul_arena_bytes(b_bytes);
+	if(packed > bytes) {
+		bytes = packed;
+	}
+	size_t strassen = mmul_strassen_workspace_bytes(size, crossover);
+	if(strassen > bytes) {
+		bytes = strassen;
+	}
+	size_t morton = mmul_morton_workspace_bytes(size);
+	return morton > bytes ? morton : bytes;
+}
+
+static size_t mmul_workspace_bytes(int size, int ld) {
+	int p[MMUL_TUNE_PARAMS];
+	int x[MMUL_TUNE_PARAMS];
+	tuned_params("packed", size, default_packed, p);
+	tuned_params("strassen", size, default_strassen, x);
+	struct mmul_packed_blocking blocking = {p[0], p[1], p[2]};
+	size_t tuned = workspace_bytes_for(size, ld, &blocking, x[0]);
+	size_t defaults = workspace_bytes_for(size, ld, NULL, MMUL_STRASSEN_CROSSOVER);
+	return tuned > defaults ? tuned : defaults;
+}
+
+struct tune_context {
+	int size;
+	int ld;
+	int *A;
+	int *B;
+	int *C;
+	struct mmul_arena workspace;
+};
+
+static bool tune_run_blocks(void *context, const int *params) {
+	struct tune_context *c = context;
+	uint64_t start = 0;
+	uint64_t stop = 0;
+	RDTSC_START(start);
+	bool ok = mmul_blocks_generic(c->size, c->ld, c->A, c->B, c->C, &c->workspace, params[0]);
+	RDTSC_STOP(stop);
+	add_measurement(start, stop);
+	return ok;
+}
+
+static bool tune_run_accumulators(void *context, const int *params) {
+	struct tune_context *c = context;
+	uint64_t start = 0;
+	uint64_t stop = 0;
+	RDTSC_START(start);
+	bool ok = mmul_blocks_accumulators_into(c->size, c->ld, c->A, c->B, c->C, &c->workspace, params[0], params[1]);
+	RDTSC_STOP(stop);
+	add_measurement(start, stop);
+	return ok;
+}
+
+static bool tune_run_packed(void *context, const int *params) {
+	struct tune_context *c = context;
+	struct mmul_packed_blocking blocking = {params[0], params[1], params[2]};
+	uint64_t start = 0;
+	uint64_t stop = 0;
+	RDTSC_START(start);
+	bool ok = packed_into(c->size, c->ld, c->A, c->B, c->C, &c->workspace, &blocking);
+	RDTSC_STOP(stop);
+	add_measurement(start, stop);
+	return ok;
+}
+
+static bool tune_run_parallel(void *context, const int *params) {
+	struct tune_context *c = context;
+	uint64_t start = 0;
+	uint64_t stop = 0;
+	RDTSC_START(start);
+	bool ok = mmul_parallel_gemm(c->size, c->ld, c->A, c->B, c->C, 0, params[0]);
+	RDTSC_STOP(stop);
+	add_measurement(start, stop);
+	return ok;
+}
+
+static bool tune_run_strassen(void *context, const int *params) {
+	struct tune_context *c = context;
+	uint64_t start = 0;
+	uint64_t stop = 0;
+	RDTSC_START(start);
+	bool ok = mmul_strassen_gemm(c->size, c->ld, c->A, c->B, c->C, params[0], &c->workspace);
+	RDTSC_STOP(stop);
+	add_measurement(start, stop);
+	return ok;
+}
+
+// candidate values: all below size and the first one >= size (the larger ones behave the same)
+static bool tune_useful(const int *values, int i, int size) {
+	return values[i] < size || i == 0 || values[i - 1] < size;
+}
+
+static bool tune_kind(struct tune_context *c, const char *kind, struct mmul_tune_candidate *candidates, int n,
+		mmul_tune_run run) {
+	fprintf(stderr, "tuning %s for size %d: %d candidates\n", kind, c->size, n);
+	if(mmul_tune_halving(candidates, n, run, c, stderr) == 0) {
+		fprintf(stderr, "Error: tuning of %s failed.\n", kind);
+		return false;
+	}
+	fprintf(stderr, "  winner: %d %d %d, %.0f cycles, %f cycles / iteration (size^3)\n",
+		candidates[0].params[0], candidates[0].params[1], candidates[0].params[2], candidates[0].median,
+		candidates[0].median / ((double)c->size * c->size * c->size));
+	return mmul_tune_set(kind, c->size, candidates[0].params, candidates[0].median);
+}
+
+#define TUNE_MAX_CANDIDATES 64
+
+static bool tune_size(int size) {
+	// with the padding of the timing (see leading_dimension())
+	struct tune_context c;
+	c.size = size;
+	c.ld = leading_dimension(size, true);
+	c.A = randmatrix(size, c.ld);
+	c.B = randmatrix(size, c.ld);
+	c.C = alloc_matrix(size, c.ld);
+
+	// workspace for the largest candidates
+	struct mmul_packed_blocking largest = {tune_mc[N_OF(tune_mc) - 1], tune_kc[N_OF(tune_kc) - 1],
+		tune_nc[N_OF(tune_nc) - 1]};
+	size_t bytes = 0;
+	for(int x = 0; x < N_OF(tune_crossovers); x++) {
+		size_t b = workspace_bytes_for(size, c.ld, &largest, tune_crossovers[x]);
+		bytes = b > bytes ? b : bytes;
+	}
+	if(!c.C || !mmul_arena_create(&c.workspace, bytes)) {
+		fprintf(stderr, "Memory error!\n");
+		free_matrix(size, c.ld, c.C);
+		free_matrix(size, c.ld, c.B);
+		free_matrix(size, c.ld, c.A);
+		return false;
+	}
+
+	struct mmul_tune_candidate candidates[TUNE_MAX_CANDIDATES];
+	memset(candidates, 0, sizeof(candidates));
+	bool ok = true;
+	int n = 0;
+
+	for(int b = 0; b < N_OF(tune_block_sizes); b++) {
+		if(tune_useful(tune_block_sizes, b, size)) {
+			candidates[n++].params[0] = tune_block_sizes[b];
+		}
+	}
+	ok = ok && tune_kind(&c, "blocks", candidates, n, tune_run_blocks);
+
+	memset(candidates, 0, sizeof(candidates));
+	n = 0;
+	for(int b = 0; b < N_OF(tune_block_sizes); b++) {
+		for(int a = 0; a < N_OF(tune_accumulators) && tune_useful(tune_block_sizes, b, size); a++) {
+			candidates[n].params[0] = tune_block_sizes[b];
+			candidates[n++].params[1] = tune_accumulators[a];
+		}
+	}
+	ok = ok && tune_kind(&c, "accumulators", candidates, n, tune_run_accumulators);
+
+	memset(candidates, 0, sizeof(candidates));
+	n = 0;
+	for(int i = 0; i < N_OF(tune_mc); i++) {
+		for(int k = 0; k < N_OF(tune_kc); k++) {
+			for(int j = 0; j < N_OF(tune_nc); j++) {
+				if(tune_useful(tune_mc, i, size) && tune_useful(tune_kc, k, size) && tune_useful(tune_nc, j, size)) {
+					candidates[n].params[0] = tune_mc[i];
+					candidates[n].params[1] = tune_kc[k];
+					candidates[n++].params[2] = tune_nc[j];
+				}
+			}
+		}
+	}
+	ok = ok && tune_kind(&c, "packed", candidates, n, tune_run_packed);
+
+	memset(candidates, 0, sizeof(candidates));
+	n = 0;
+	for(int t = 0; t < N_OF(tune_tiles); t++) {
+		if(tune_useful(tune_tiles, t, size)) {
+			candidates[n++].params[0] = tune_tiles[t];
+		}
+	}
+	ok = ok && tune_kind(&c, "parallel", candidates, n, tune_run_parallel);
+
+	memset(candidates, 0, sizeof(candidates));
+	n = 0;
+	for(int x = 0; x < N_OF(tune_crossovers); x++) {
+		if(tune_useful(tune_crossovers, x, size)) {
+			candidates[n++].params[0] = tune_crossovers[x];
+		}
+	}
+	ok = ok && tune_kind(&c, "strassen", candidates, n, tune_run_strassen);
+
+	mmul_arena_delete(&c.workspace);
+	free_matrix(size, c.ld, c.C);
+	free_matrix(size, c.ld, c.B);
+	free_matrix(size, c.ld, c.A);
+	return ok;
+}
+
+// mmul tune <size> [<size> ...]; the entries of other sizes in the cache are kept
+static int tune_main(int n_sizes, char **sizes) {
+	const char *path = mmul_tune_default_path();
+	if(mmul_tune_load(path)) {
+		fprintf(stderr, "tuning cache: %s, %d entries loaded\n", path, mmul_tune_entries());
+	}
+
+	for(int i = 0; i < n_sizes; i++) {
+		int size = atoi(sizes[i]);
+		if(size <= 0) {
+			fprintf(stderr, "Error: invalid matrix size %s\n", sizes[i]);
+			return 1;
+		}
+		if(!tune_size(size)) {
+			return 1;
+		}
+	}
+
+	if(!mmul_tune_save(path)) {
+		fprintf(stderr, "Error: could not write the tuning cache %s\n", path);
+		return 1;
+	}
+	fprintf(stderr, "tuning cache: %s, %d entries written\n", path, mmul_tune_entries());
+	return 0;
+}
+
+// crossover of Strassen-Winograd to the cubic versions: sizes 256, 512, ... up to max_size
+// (or max_size only if smaller); all with the tuned parameters of the tuning cache
+#define STRASSEN_ROUNDS 3
+
+static double median_cycles(int size, int ld, int *A, int *B, int *C, struct mmul_arena *workspace,
+		matrix_multiplier mm, int rounds) {
+	reset_testbench();
+	for (int r = 0; r < rounds; r++) {
+		uint64_t start = 0;
+		uint64_t stop = 0;
+		RDTSC_START(start);
+		bool ok = mm(size, ld, A, B, C, workspace);
+		RDTSC_STOP(stop);
+		add_measurement(start, stop);
+		if (!ok) {
+			return -1.0;
+		}
+	}
+	return testbench_get_statistics().median;
+}
+
+bool time_strassen_crossover(int max_size, bool pad) {
+	fprintf(stderr, "\nStrassen-Winograd vs. cubic (cycles / size^3; tuned parameters)\n");
+	fprintf(stderr, "   size   blocks_tuned   packed_tuned   strassen_tuned   vs. blocks   vs. packed\n");
+
+	int first = max_size < 256 ? max_size : 256;
+	int overtakes_blocks = 0;
+	int overtakes_packed = 0;
+	int last = first;
+	for (int size = first; size <= max_size; size *= 2) {
+		int ld = leading_dimension(size, pad);
+		int *A = randmatrix(size, ld);
+		int *B = randmatrix(size, ld);
+		int *C = alloc_matrix(size, ld);
+		struct mmul_arena workspace;
+		if (!C || !mmul_arena_create(&workspace, mmul_workspace_bytes(size, ld))) {
+			fprintf(stderr, "Memory error!\n");
+			free_matrix(size, ld, C);
+			free_matrix(size, ld, B);
+			free_matrix(size, ld, A);
+			return false;
+		}
+		// few rounds of the large sizes
+		int rounds = size <= 1024 ? STRASSEN_ROUNDS : 1;
+		double blocks = median_cycles(size, ld, A, B, C, &workspace, mmul_blocks_tuned, rounds);
+		double packed = median_cycles(size, ld, A, B, C, &workspace, mmul_packed_tuned, rounds);
+		double strassen = median_cycles(size, ld, A, B, C, &workspace, mmul_strassen_tuned, rounds);
+		mmul_arena_delete(&workspace);
+		free_matrix(size, ld, C);
+		free_matrix(size, ld, B);
+		free_matrix(size, ld, A);
+		if (blocks < 0.0 || packed < 0.0 || strassen < 0.0) {
+			fprintf(stderr, "Memory error!\n");
+			return false;
+		}
+
+		last = size;
+		double size3 = (double)size * size * size;
+		fprintf(stderr, "%7d   %12.4f   %12.4f   %14.4f   %10.2f   %10.2f\n", size, blocks / size3, packed / size3,
+			strassen / size3, blocks / strassen, packed / strassen);
+		// smallest size from which on Strassen stays faster
+		if (strassen >= blocks) {
+			overtakes_blocks = 0;
+		}
+		else if (overtakes_blocks == 0) {
+			overtakes_blocks = size;
+		}
+		if (strassen >= packed) {
+			overtakes_packed = 0;
+		}
+		else if (overtakes_packed == 0) {
+			overtakes_packed = size;
+		}
+	}
+
+	if (overtakes_blocks > 0) {
+		fprintf(stderr, "strassen_tuned is faster than blocks_tuned from size %d to %d\n", overtakes_blocks, last);
+	}
+	if (overtakes_packed > 0) {
+		fprintf(stderr, "strassen_tuned is faster than packed_tuned from size %d to %d\n", overtakes_packed, last);
+	}
+	else {
+		fprintf(stderr, "strassen_tuned is not faster than packed_tuned up to size %d\n", last);
+	}
+	return true;
+}
+
+//--- element types ------------------------------------------------------------
+//    the classic variants and the widening SIMD kernels per element type (mmul_typed.h);
+//    each variant is checked against the reference of its type before it is timed
+
+#define TYPES_ROUNDS 3
+#define TYPES_MAX_VARIANTS 8
+
+static double median_cycles_typed(int size, const void *A, const void *B, void *C, struct mmul_arena *workspace,
+		mmul_typed_function f) {
+	reset_testbench();
+	for (int r = 0; r < TYPES_ROUNDS; r++) {
+		uint64_t start = 0;
+		uint64_t stop = 0;
+		RDTSC_START(start);
+		bool ok = f(size, A, B, C, workspace);
+		RDTSC_STOP(stop);
+		add_measurement(start, stop);
+		if (!ok) {
+			return -1.0;
+		}
+	}
+	return testbench_get_statistics().median;
+}
+
+// checks and times all variants of one type; cycles and max. errors per variant
+static bool time_type(int size, enum mmul_type type, double *cycles, double *errors) {
+	const struct mmul_type_info *info = mmul_type_info(type);
+	const struct mmul_typed_variant *variants = NULL;
+	int n = mmul_typed_variants(type, &variants);
+	size_t elements = (size_t)size * size;
+	void *A = testbench_alloc_buffer(elements * info->element_bytes, NULL);
+	void *B = testbench_alloc_buffer(elements * info->element_bytes, NULL);
+	void *C = testbench_alloc_buffer(elements * info->result_bytes, NULL);
+	double *ref = testbench_alloc_buffer(elements * sizeof(double), NULL);
+	double *bound = testbench_alloc_buffer(elements * sizeof(double), NULL);
+	struct mmul_arena workspace;
+	bool ok = A && B && C && ref && bound && mmul_arena_create(&workspace, mmul_typed_workspace_bytes(type, size));
+	if (!ok) {
+		fprintf(stderr, "Memory error!\n");
+	}
+	else {
+		mmul_typed_fill(type, size, A);
+		mmul_typed_fill(type, size, B);
+		mmul_typed_reference(type, size, A, B, ref, bound);
+		for (int v = 0; v < n && ok; v++) {
+			fprintf(stderr, "checking: %s %s... ", info->name, variants[v].name);
+			if (!variants[v].f(size, A, B, C, &workspace)) {
+				fprintf(stderr, "FAILED. Error.\n");
+				ok = false;
+			}
+			else if (!mmul_typed_compare(type, size, C, ref, bound, &errors[v])) {
+				fprintf(stderr, "FAILED. Wrong result.\n");
+				ok = false;
+			}
+			else {
+				fprintf(stderr, "RESULT OK.\n");
+				cycles[v] = median_cycles_typed(size, A, B, C, &workspace, variants[v].f);
+				ok = cycles[v] >= 0.0;
+			}
+		}
+		mmul_arena_delete(&workspace);
+	}
+	testbench_free_buffer(bound, elements * sizeof(double));
+	testbench_free_buffer(ref, elements * sizeof(double));
+	testbench_free_buffer(C, elements * info->result_bytes);
+	testbench_free_buffer(B, elements * info->element_bytes);
+	testbench_free_buffer(A, elements * info->element_bytes);
+	return ok;
+}
+
+bool time_types(int size) {
+	double cycles[MMUL_TYPES][TYPES_MAX_VARIANTS];
+	double errors[MMUL_TYPES][TYPES_MAX_VARIANTS];
+	fprintf(stderr, "\n");
+	for (int t = 0; t < MMUL_TYPES; t++) {
+		const struct mmul_typed_variant *variants = NULL;
+		if (mmul_typed_variants(t, &variants) > TYPES_MAX_VARIANTS || !time_type(size, t, cycles[t], errors[t])) {
+			return false;
+		}
+	}
+
+	// the first variant of each type is naive
+	double size3 = (double)size * size * size;
+	double int32_naive = cycles[MMUL_INT32][0];
+	fprintf(stderr, "\nElement types, size %d (cycles / size^3; speedup vs. naive of the same type and vs. int32 naive)\n",
+		size);
+	fprintf(stderr, "  type     variant        cycles/size^3   vs. naive   vs. int32   max. error\n");
+	for (int t = 0; t < MMUL_TYPES; t++) {
+		const struct mmul_type_info *info = mmul_type_info(t);
+		const struct mmul_typed_variant *variants = NULL;
+		int n = mmul_typed_variants(t, &variants);
+		for (int v = 0; v < n; v++) {
+			fprintf(stderr, "  %-8s %-14s %13.4f   %8.2fx   %8.2fx", info->name, variants[v].name, cycles[t][v] / size3,
+				cycles[t][0] / cycles[t][v], int32_naive / cycles[t][v]);
+			if (info->exact) {
+				fprintf(stderr, "   exact\n");
+			}
+			else {
+				// relative to the limit 2 * size * epsilon * sum |a b|
+				fprintf(stderr, "   %.3f of limit\n", errors[t][v]);
+			}
+		}
+	}
+	return true;
+}
+
+//--- transpose phase ----------------------------------------------------------
+//    B^T of the transposed versions: element-wise (as before) vs. in-register tiles
+//    (mmul_transpose.h); its share of the total of transposedAndBetterIndex and blocks_tuned
+//    the transposes in the shape of a matrix_multiplier for median_cycles(): C = B^T
+
+static bool transpose_scalar(int size, int ld, const int *A, const int *B, int *C, struct mmul_arena *workspace) {
+	(void)A;
+	(void)workspace;
+	mmul_transpose_scalar(size, B, ld, C, ld);
+	return true;
+}
+
+static bool transpose_simd(int size, int ld, const int *A, const int *B, int *C, struct mmul_arena *workspace) {
+	(void)A;
+	(void)workspace;
+	mmul_transpose(size, B, ld, C, ld);
+	return true;
+}
+
+// C = C^T; C holds B^T of the previous round (the values do not matter)
+static bool transpose_in_place(int size, int ld, const int *A, const int *B, int *C,
+		struct mmul_arena *workspace) {
+	(void)A;
+	(void)B;
+	(void)workspace;
+	mmul_transpose_in_place(size, C, ld);
+	return true;
+}
+
+// tile edges: sizes that are not multiples of the tiles (8, 16) and rows padded by 16 elements
+static const int transpose_check_sizes[] = {1, 7, 8, 13, 16, 17, 31, 40, 100};
+#define TRANSPOSE_CHECK_PADDING 16
+#define TRANSPOSE_CHECK_FILL (-1) // of the padding, which must be left as is
+
+// mmul_transpose() against the scalar reference, mmul_transpose_in_place() against mmul_transpose()
+bool check_transpose(void) {
+	fprintf(stderr, "checking: transposes... ");
+	int n_sizes = sizeof(transpose_check_sizes) / sizeof(transpose_check_sizes[0]);
+	for (int s = 0; s < n_sizes; s++) {
+		for (int padding = 0; padding <= TRANSPOSE_CHECK_PADDING; padding += TRANSPOSE_CHECK_PADDING) {
+			int size = transpose_check_sizes[s];
+			int ld = size + padding;
+			int *M = alloc_matrix(size, ld);
+			int *ref = alloc_matrix(size, ld);
+			int *T = alloc_matrix(size, ld);
+			if (!M || !ref || !T) {
+				fprintf(stderr, "Memory error!\n");
+				free_matrix(size, ld, T);
+				free_matrix(size, ld, ref);
+				free_matrix(size, ld, M);
+				return false;
+			}
+			for (int i = 0; i < size * ld; i++) {
+				M[i] = TRANSPOSE_CHECK_FILL;
+			}
+			fillmatrix(size, ld, M);
+			mmul_transpose_scalar(size, M, ld, ref, ld);
+			mmul_transpose(size, M, ld, T, ld);
+			bool ok = compare_matrices(size, ld, T, ref);
+			if (ok) {
+				memcpy(T, M, (size_t)size * ld * sizeof(int));
+				mmul_transpose_in_place(size, T, ld);
+				ok = compare_matrices(size, ld, T, ref);
+				for (int i = 0; i < size && ok; i++) {
+					for (int j = size; j < ld && ok; j++) {
+						ok = T[i * ld + j] == TRANSPOSE_CHECK_FILL;
+					}
+				}
+			}
+			free_matrix(size, ld, T);
+			free_matrix(size, ld, ref);
+			free_matrix(size, ld, M);
+			if (!ok) {
+				fprintf(stderr, "FAILED. Wrong result (size %d, ld %d).\n", size, ld);
+				return false;
+			}
+		}
+	}
+	fprintf(stderr, "RESULT OK.\n");
+	return true;
+}
+
+#define TRANSPOSE_ROUNDS 5
+
+bool time_transpose(int max_size, bool pad) {
+	fprintf(stderr, "\nTranspose phase (transposes: cycles / size^2; totals: cycles / size^3; kernel %s)\n",
+		mmul_transpose_kernel_name());
+	fprintf(stderr, "   size     scalar       simd   in-place    speedup   transposed_total    share"
+		"   blocks_total    share\n");
+
+	int first = max_size < 128 ? max_size : 128;
+	for (int size = first; size <= max_size; size *= 2) {
+		int ld = leading_dimension(size, pad);
+		int *A = randmatrix(size, ld);
+		int *B = randmatrix(size, ld);
+		int *C = alloc_matrix(size, ld);
+		struct mmul_arena workspace;
+		if (!C || !mmul_arena_create(&workspace, mmul_workspace_bytes(size, ld))) {
+			fprintf(stderr, "Memory error!\n");
+			free_matrix(size, ld, C);
+			free_matrix(size, ld, B);
+			free_matrix(size, ld, A);
+			return false;
+		}
+		int rounds = size <= 1024 ? TRANSPOSE_ROUNDS : 1;
+		double scalar = median_cycles(size, ld, A, B, C, &workspace, transpose_scalar, rounds);
+		double simd = median_cycles(size, ld, A, B, C, &workspace, transpose_simd, rounds);
+		double in_place = median_cycles(size, ld, A, B, C, &workspace, transpose_in_place, rounds);
+		double transposed = median_cycles(size, ld, A, B, C, &workspace,
+			mmul_transposedB_and_betterIndexCalculation, rounds);
+		double blocks = median_cycles(size, ld, A, B, C, &workspace, mmul_blocks_tuned, rounds);
+		mmul_arena_delete(&workspace);
+		free_matrix(size, ld, C);
+		free_matrix(size, ld, B);
+		free_matrix(size, ld, A);
+
+		double size2 = (double)size * size;
+		double size3 = size2 * size;
+		fprintf(stderr, "%7d %10.3f %10.3f %10.3f %9.2fx %18.4f %7.1f%% %14.4f %7.1f%%\n", size, scalar / size2,
+			simd / size2, in_place / size2, scalar / simd, transposed / size3, 100.0 * simd / transposed,
+			blocks / size3, 100.0 * simd / blocks);
+	}
+	return true;
+}
+
+//--- cache-oblivious Morton order ---------------------------------------------
+//    recursive multiplication in Morton order (mmul_morton.h) vs. the tuned blocked
+//    version with warm and cold caches; the conversions from and to row-major are timed
+//    separately and included in the total
+
+#define MORTON_ROUNDS 3
+
+enum morton_phase {
+	MORTON_BLOCKS,
+	MORTON_CONVERT_IN,  // A and B
+	MORTON_GEMM,
+	MORTON_CONVERT_OUT, // C
+	MORTON_PHASES
+};
+
+struct morton_run {
+	int size;
+	int ld;
+	int *A;
+	int *B;
+	int *C;
+	int *Az;
+	int *Bz;
+	int *Cz;
+	struct mmul_arena workspace;
+};
+
+static bool morton_phase(struct morton_run *m, enum morton_phase phase) {
+	switch (phase) {
+	case MORTON_BLOCKS:
+		return mmul_blocks_tuned(m->size, m->ld, m->A, m->B, m->C, &m->workspace);
+	case MORTON_CONVERT_IN:
+		mmul_morton_from_row_major(m->size, m->A, m->ld, m->Az);
+		mmul_morton_from_row_major(m->size, m->B, m->ld, m->Bz);
+		return true;
+	case MORTON_GEMM:
+		mmul_morton_gemm(m->size, m->Az, m->Bz, m->Cz);
+		return true;
+	default:
+		mmul_morton_to_row_major(m->size, m->Cz, m->C, m->ld);
+		return true;
+	}
+}
+
+// cache mode as set; the caches are prepared before each round
+static double median_phase(struct morton_run *m, enum morton_phase phase) {
+	reset_testbench();
+	for (int r = 0; r < MORTON_ROUNDS; r++) {
+		uint64_t start = 0;
+		uint64_t stop = 0;
+		testbench_prepare_cache();
+		RDTSC_START(start);
+		bool ok = morton_phase(m, phase);
+		RDTSC_STOP(stop);
+		add_measurement(start, stop);
+		if (!ok) {
+			return -1.0;
+		}
+	}
+	return testbench_get_statistics().median;
+}
+
+// cycles of all phases in the given cache mode; checked against the blocked version
+static bool time_morton_size(int size, int ld, bool cold, double *cycles) {
+	struct morton_run m = {size, ld, NULL, NULL, NULL, NULL, NULL, NULL, {NULL, 0, 0}};
+	size_t z_bytes = mmul_morton_bytes(size);
+	m.A = randmatrix(size, ld);
+	m.B = randmatrix(size, ld);
+	m.C = alloc_matrix(size, ld);
+	int *ref = alloc_matrix(size, ld);
+	m.Az = testbench_alloc_buffer(z_bytes, NULL);
+	m.Bz = testbench_alloc_buffer(z_bytes, NULL);
+	m.Cz = testbench_alloc_buffer(z_bytes, NULL);
+	bool ok = m.C && ref && m.Az && m.Bz && m.Cz && mmul_arena_create(&m.workspace, mmul_workspace_bytes(size, ld));
+
+	if (ok) {
+		testbench_clear_buffers();
+		testbench_declare_buffer(m.A, matrix_bytes(size, ld));
+		testbench_declare_buffer(m.B, matrix_bytes(size, ld));
+		testbench_declare_buffer(m.C, matrix_bytes(size, ld));
+		testbench_declare_buffer(m.Az, z_bytes);
+		testbench_declare_buffer(m.Bz, z_bytes);
+		testbench_declare_buffer(m.Cz, z_bytes);
+		set_cache_mode(cold ? TESTBENCH_CACHE_COLD : TESTBENCH_CACHE_WARM);
+		for (int phase = 0; phase < MORTON_PHASES && ok; phase++) {
+			cycles[phase] = median_phase(&m, phase);
+			ok = cycles[phase] >= 0.0;
+			if (phase == MORTON_BLOCKS) {
+				memcpy(ref, m.C, matrix_bytes(size, ld));
+			}
+		}
+		set_cache_mode(TESTBENCH_CACHE_AS_IS);
+		testbench_clear_buffers();
+		if (ok && !compare_matrices(size, ld, m.C, ref)) {
+			fprintf(stderr, "size %d: morton FAILED. Wrong result.\n", size);
+			ok = false;
+		}
+		mmul_arena_delete(&m.workspace);
+	}
+
+	testbench_free_buffer(m.Cz, z_bytes);
+	testbench_free_buffer(m.Bz, z_bytes);
+	testbench_free_buffer(m.Az, z_bytes);
+	free_matrix(size, ld, ref);
+	free_matrix(size, ld, m.C);
+	free_matrix(size, ld, m.B);
+	free_matrix(size, ld, m.A);
+	return ok;
+}
+
+bool time_morton(int max_size, bool pad) {
+	fprintf(stderr, "\nCache-oblivious Morton order vs. blocks_tuned (cycles / size^3; conversions included in total)\n");
+	fprintf(stderr, "   size  padded  caches   blocks_tuned   morton_gemm   conversions   morton_total   conversion"
+		"   vs. blocks\n");
+
+	// powers of two and 1.5 times (padding of the Morton layout)
+	int first = max_size < 128 ? max_size : 128;
+	for (int base = first; base <= max_size; base *= 2) {
+		int sizes[2] = {base, base + base / 2};
+		for (int s = 0; s < 2 && sizes[s] <= max_size; s++) {
+			int size = sizes[s];
+			int tile = 0;
+			int padded = mmul_morton_padded_size(size, &tile);
+			for (int cold = 0; cold < 2; cold++) {
+				double cycles[MORTON_PHASES];
+				if (!time_morton_size(size, leading_dimension(size, pad), cold, cycles)) {
+					fprintf(stderr, "Memory error or wrong result!\n");
+					return false;
+				}
+				double size3 = (double)size * size * size;
+				double conversions = cycles[MORTON_CONVERT_IN] + cycles[MORTON_CONVERT_OUT];
+				double total = cycles[MORTON_GEMM] + conversions;
+				fprintf(stderr, "%7d %7d  %-6s %14.4f %13.4f %13.4f %14.4f %11.1f%% %11.2fx\n", size, padded,
+					cold ? "cold" : "warm", cycles[MORTON_BLOCKS] / size3, cycles[MORTON_GEMM] / size3,
+					conversions / size3, total / size3, 100.0 * conversions / total, cycles[MORTON_BLOCKS] / total);
+			}
+		}
+	}
+	return true;
+}
+
+//--- leading-dimension padding -----------------------------------------------
+//    power-of-two sizes with ld = size vs. ld = size + LD_PADDING (the padding of
+//    leading_dimension(); column rule: whether it pads this size); the same matrices (the
+//    padding columns are not touched), the same workspace
+
+#define PADDING_ROUNDS 3
+
+static const matrix_multiplier padding_tests[] = {
+	transpose_simd,
+	mmul_transposedB_and_betterIndexCalculation,
+	mmul_blocks_tuned,
+	mmul_packed_tuned
+};
+
+static const char *padding_names[] = {
+	"transpose (size^2)",
+	"transposedAndBetterIndex",
+	"blocks_tuned",
+	"packed_tuned"
+};
+
+static bool time_padding_size(int size, int ld, double *cycles) {
+	int n_padding_tests = sizeof(padding_tests) / sizeof(padding_tests[0]);
+	int *A = randmatrix(size, ld);
+	int *B = randmatrix(size, ld);
+	int *C = alloc_matrix(size, ld);
+	struct mmul_arena workspace;
+	if (!C || !mmul_arena_create(&workspace, mmul_workspace_bytes(size, ld))) {
+		free_matrix(size, ld, C);
+		free_matrix(size, ld, B);
+		free_matrix(size, ld, A);
+		return false;
+	}
+	bool ok = true;
+	int rounds = size <= 1024 ? PADDING_ROUNDS : 1;
+	for (int t = 0; t < n_padding_tests && ok; t++) {
+		cycles[t] = median_cycles(size, ld, A, B, C, &workspace, padding_tests[t], rounds);
+		ok = cycles[t] >= 0.0;
+	}
+	mmul_arena_delete(&workspace);
+	free_matrix(size, ld, C);
+	free_matrix(size, ld, B);
+	free_matrix(size, ld, A);
+	return ok;
+}
+
+bool time_padding(int max_size) {
+	int n_padding_tests = sizeof(padding_tests) / sizeof(padding_tests[0]);
+	fprintf(stderr, "\nLeading-dimension padding at power-of-two sizes (cycles / size^3; transpose: cycles / size^2)\n");
+	fprintf(stderr, "   size   ld  rule  algorithm                  ld = size     padded    speedup     drop\n");
+
+	int first = max_size < 128 ? max_size : 128;
+	for (int size = first; size <= max_size; size *= 2) {
+		// padded by LD_PADDING also where the rule does not pad (e.g. at a max_size of 100)
+		int ld = size + LD_PADDING;
+		bool rule = leading_dimension(size, true) != size;
+		double plain[sizeof(padding_tests) / sizeof(padding_tests[0])];
+		double padded[sizeof(padding_tests) / sizeof(padding_tests[0])];
+		if (!time_padding_size(size, size, plain) || !time_padding_size(size, ld, padded)) {
+			fprintf(stderr, "Memory error!\n");
+			return false;
+		}
+		double size2 = (double)size * size;
+		for (int t = 0; t < n_padding_tests; t++) {
+			double n = t == 0 ? size2 : size2 * size;
+			fprintf(stderr, "%7d %4d  %-4s  %-24s %11.4f %10.4f %9.2fx %7.1f%%\n", size, ld, rule ? "yes" : "no",
+				padding_names[t], plain[t] / n, padded[t] / n, plain[t] / padded[t], 100.0 * (plain[t] - padded[t]) / plain[t]);
+		}
+	}
+	return true;
+}
+
+//--- batched small matrices ---------------------------------------------------
+//    many independent small multiplications: the kernels specialized at compile time
+//    (mmul_fixed.h) vs. the generic versions with runtime sizes; one batch of count
+//    matrices A_b, B_b, C_b back to back is timed as a whole
+
+#define BATCH_MADDS (1 << 24) // per batch; count = BATCH_MADDS / size^3
+#define BATCH_MAX_COUNT 4096
+#define BATCH_ROUNDS 3
+
+// the batches are contiguous: ld == size
+static bool mmul_fixed(int size, int ld, const int *A, const int *B, int *C, struct mmul_arena *workspace) {
+	(void)workspace;
+	mmul_fixed_function fixed = mmul_fixed_kernel(size);
+	if(!fixed || ld != size) {
+		return false;
+	}
+	fixed(A, B, C);
+	return true;
+}
+
+static bool mmul_blocks_64_generic(int size, int ld, const int *A, const int *B, int *C,
+		struct mmul_arena *workspace) {
+	return mmul_blocks_generic(size, ld, A, B, C, workspace, 64);
+}
+
+static bool run_batch(int size, int count, const int *A, const int *B, int *C, struct mmul_arena *workspace,
+		matrix_multiplier mm) {
+	size_t n2 = (size_t)size * size;
+	for (int b = 0; b < count; b++) {
+		if (!mm(size, size, A + b * n2, B + b * n2, C + b * n2, workspace)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool time_batched(void) {
+	static const matrix_multiplier batch_tests[] = {
+		mmul_fixed,
+		mmul_blocks_64_generic,
+		mmul_transposedB_and_betterIndexCalculation,
+		mmul_packed
+	};
+	int n_batch_tests = sizeof(batch_tests) / sizeof(batch_tests[0]);
+
+	fprintf(stderr, "\nBatched small matrices (cycles per matrix; speedup of the fixed-size kernel)\n");
+	fprintf(stderr, "   size   count      fixed   blocks_64   transposed     packed   vs. blocks   vs. transposed"
+		"   vs. packed\n");
+	const int *sizes = NULL;
+	int n_sizes = mmul_fixed_sizes(&sizes);
+	for (int s = 0; s < n_sizes; s++) {
+		int size = sizes[s];
+		int count = BATCH_MADDS / (size * size * size);
+		count = count < 1 ? 1 : (count > BATCH_MAX_COUNT ? BATCH_MAX_COUNT : count);
+		size_t n2 = (size_t)size * size;
+		size_t bytes = (size_t)count * n2 * sizeof(int);
+		int *A = testbench_alloc_buffer(bytes, NULL);
+		int *B = testbench_alloc_buffer(bytes, NULL);
+		int *C = testbench_alloc_buffer(bytes, NULL);
+		int *ref = alloc_matrix(size, size);
+		struct mmul_arena workspace;
+		bool ok = A && B && C && ref && mmul_arena_create(&workspace, mmul_workspace_bytes(size, size));
+		if (ok) {
+			for (int b = 0; b < count; b++) {
+				fillmatrix(size, size, A + b * n2);
+				fillmatrix(size, size, B + b * n2);
+			}
+		}
+
+		double cycles[sizeof(batch_tests) / sizeof(batch_tests[0])];
+		for (int t = 0; t < n_batch_tests && ok; t++) {
+			// check with the last matrix of the batch
+			ok = run_batch(size, count, A, B, C, &workspace, batch_tests[t])
+				&& mmul(size, size, A + (count - 1) * n2, B + (count - 1) * n2, ref, &workspace)
+				&& compare_matrices(size, size, C + (count - 1) * n2, ref);
+			reset_testbench();
+			for (int r = 0; r < BATCH_ROUNDS && ok; r++) {
+				uint64_t start = 0;
+				uint64_t stop = 0;
+				RDTSC_START(start);
+				ok = run_batch(size, count, A, B, C, &workspace, batch_tests[t]);
+				RDTSC_STOP(stop);
+				add_measurement(start, stop);
+			}
+			cycles[t] = testbench_get_statistics().median / count;
+		}
+
+		if (A && B && C && ref && workspace.base) {
+			mmul_arena_delete(&workspace);
+		}
+		free_matrix(size, size, ref);
+		testbench_free_buffer(C, bytes);
+		testbench_free_buffer(B, bytes);
+		testbench_free_buffer(A, bytes);
+		if (!ok) {
+			fprintf(stderr, "size %d: FAILED. Memory error or wrong result.\n", size);
+			return false;
+		}
+		fprintf(stderr, "%7d %7d %10.0f %11.0f %12.0f %10.0f %11.2fx %15.2fx %11.2fx\n", size, count, cycles[0],
+			cycles[1], cycles[2], cycles[3], cycles[1] / cycles[0], cycles[2] / cycles[0], cycles[3] / cycles[0]);
+	}
+	return true;
+}
+
+static matrix_multiplier tests[] = {
+	mmul,
+	mmul_betterIndexCalculation,
+	mmul_transposedB,
+	mmul_transposedB_and_betterIndexCalculation,
+	mmul_blocks_1024,
+	mmul_blocks_512,
+	mmul_blocks_256,
+	mmul_blocks_64,
+	mmul_blocks_16,
+	mmul_blocks_1024_accumulators_4,
+	mmul_blocks_512_accumulators_4,
+	mmul_blocks_256_accumulators_4,
+	mmul_blocks_64_accumulators_4,
+	mmul_blocks_16_accumulators_4,
+	mmul_packed,
+	mmul_parallel,
+	mmul_blocks_tuned,
+	mmul_accumulators_tuned,
+	mmul_packed_tuned,
+	mmul_parallel_tuned,
+	mmul_strassen_tuned,
+	mmul_morton
+};
+
+static char *names[] = {
+	"default",
+	"betterIndexCalculation",
+	"transposedB",
+	"transposedAndBetterIndex",
+	"blocks_1024",
+	"blocks_512",
+	"blocks_256",
+	"blocks_64",
+	"blocks_16",
+	"blocks_1024_accumulators_4",
+	"blocks_512_accumulators_4",
+	"blocks_256_accumulators_4",
+	"blocks_64_accumulators_4",
+	"blocks_16_accumulators_4",
+	"packed_microkernel",
+	"parallel_tiles",
+	"blocks_tuned",
+	"accumulators_tuned",
+	"packed_tuned",
+	"parallel_tuned",
+	"strassen_tuned",
+	"morton"
+};
+
+// optional reports on stderr (command line flags); each may take minutes at large sizes
+enum report {
+	REPORT_SCALING = 1,
+	REPORT_PARALLEL = 2,
+	REPORT_STRASSEN = 4,
+	REPORT_TYPES = 8,
+	REPORT_BATCHED = 16,
+	REPORT_MORTON = 32,
+	REPORT_TRANSPOSE = 64,
+	REPORT_PADDING = 128
+};
+
+int main(int argc, char **argv) {
+	bool tune = argc >= 3 && strcmp(argv[1], "tune") == 0;
+
+	// options of the benchmark run
+	struct timing_config config = {TIME_REPETITIONS, false, false, 0.0};
+	bool pad = true;
+	int exact = -1;            // -1: exact up to VERIFY_EXACT_MAX_SIZE
+	int rounds = MMUL_VERIFY_ROUNDS;
+	uint64_t seed = (uint64_t)time(NULL);
+	unsigned reports = 0;      // size sweeps on stderr; none by default
+	int threads = 0;           // of the pool; 0: all CPUs of the affinity mask
+	int arg = 1;
+	while (!tune && arg < argc && argv[arg][0] == '-') {
+		if (strcmp(argv[arg], "-r") == 0 && arg + 1 < argc && atoi(argv[arg + 1]) > 0) {
+			config.repetitions = atoi(argv[arg + 1]);
+			arg += 2;
+		}
+		else if (strcmp(argv[arg], "-cold") == 0) {
+			config.cold = true;
+			arg++;
+		}
+		else if (strcmp(argv[arg], "-fresh") == 0) {
+			config.fresh = true;
+			arg++;
+		}
+		else if (strcmp(argv[arg], "-nopad") == 0) {
+			pad = false;
+			arg++;
+		}
+		else if (strcmp(argv[arg], "-exact") == 0) {
+			exact = 1;
+			arg++;
+		}
+		else if (strcmp(argv[arg], "-freivalds") == 0 && arg + 1 < argc && atoi(argv[arg + 1]) > 0) {
+			exact = 0;
+			rounds = atoi(argv[arg + 1]);
+			arg += 2;
+		}
+		else if (strcmp(argv[arg], "-seed") == 0 && arg + 1 < argc) {
+			seed = strtoull(argv[arg + 1], NULL, 0);
+			arg += 2;
+		}
+		else if (strcmp(argv[arg], "-t") == 0 && arg + 1 < argc && atoi(argv[arg + 1]) > 0) {
+			threads = atoi(argv[arg + 1]);
+			arg += 2;
+		}
+		else if (strcmp(argv[arg], "-parallel") == 0) {
+			reports |= REPORT_PARALLEL;
+			arg++;
+		}
+		else if (strcmp(argv[arg], "-strassen") == 0) {
+			reports |= REPORT_STRASSEN;
+			arg++;
+		}
+		else if (strcmp(argv[arg], "-scaling") == 0) {
+			reports |= REPORT_SCALING;
+			arg++;
+		}
+		else if (strcmp(argv[arg], "-types") == 0) {
+			reports |= REPORT_TYPES;
+			arg++;
+		}
+		else if (strcmp(argv[arg], "-batched") == 0) {
+			reports |= REPORT_BATCHED;
+			arg++;
+		}
+		else if (strcmp(argv[arg], "-morton") == 0) {
+			reports |= REPORT_MORTON;
+			arg++;
+		}
+		else if (strcmp(argv[arg], "-transpose") == 0) {
+			reports |= REPORT_TRANSPOSE;
+			arg++;
+		}
+		else if (strcmp(argv[arg], "-padding") == 0) {
+			reports |= REPORT_PADDING;
+			arg++;
+		}
+		else {
+			break;
+		}
+	}
+	if (!tune && (argc - arg < 1 || argc - arg > 3 || atoi(argv[arg]) <= 0)) {
+		fprintf(stderr, "USAGE: mmul [-r repetitions] [-cold] [-fresh] [-nopad] [-exact | -freivalds rounds] [-seed n]\n"
+			"            [-t threads] [-scaling] [-parallel] [-strassen] [-types] [-batched]\n"
+			"            [-morton] [-transpose] [-padding]\n"
+			"            <matrix_size> [report_max_size [tile]] >result.txt\n");
+		fprintf(stderr, "       mmul tune <matrix_size> [<matrix_size> ...]\n");
+		fprintf(stderr, "       -r: repetitions per algorithm (default %d); -cold: cold caches (default warm);\n",
+			TIME_REPETITIONS);
+		fprintf(stderr, "       -fresh: new random matrices for each repetition (default reused);\n");
+		fprintf(stderr, "       -nopad: rows of size elements (default padded at multiples of %d bytes);\n",
+			LD_CONFLICT_STRIDE);
+		fprintf(stderr, "       -exact: check with the reference of the naive version; -freivalds: check with\n");
+		fprintf(stderr, "       Freivalds' algorithm (default: exact up to size %d, %d rounds above);\n",
+			VERIFY_EXACT_MAX_SIZE, MMUL_VERIFY_ROUNDS);
+		fprintf(stderr, "       -seed: of the random vectors of Freivalds' algorithm (default time);\n");
+		fprintf(stderr, "       -t: threads of the pool of the parallel versions (default: CPUs of the affinity mask);\n");
+		fprintf(stderr, "       reports on stderr (default none): -scaling: weak scaling over threads at matrix_size;\n");
+		fprintf(stderr, "       -parallel: strong scaling of parallel_tiles over the threads of the pool, sizes 256\n");
+		fprintf(stderr, "       .. report_max_size (tile: default %d); -strassen: Strassen-Winograd vs. cubic,\n",
+			MMUL_PARALLEL_TILE);
+		fprintf(stderr, "       sizes 256 .. report_max_size; -types: the variants per element type at matrix_size\n");
+		fprintf(stderr, "       (naive of each type: O(size^3) each, about an hour at 4096); -batched: batches of\n");
+		fprintf(stderr, "       small matrices, fixed-size kernels vs. the general versions, sizes 4 .. %d;\n",
+			MMUL_FIXED_MAX_SIZE);
+		fprintf(stderr, "       -morton: recursive Morton order vs. blocks, warm and cold, sizes 128 .. report_max_size;\n");
+		fprintf(stderr, "       -transpose: scalar vs. SIMD vs. in-place transpose and its share of the totals, sizes\n");
+		fprintf(stderr, "       128 .. report_max_size; -padding: ld = size vs. ld = size + %d (rule: padded by\n",
+			LD_PADDING);
+		fprintf(stderr, "       default), powers of two 128 .. report_max_size\n");
+		return 1;
+	}
+
+	// initialization; the environment for Gop/s (TSC frequency) and the tuning cache (CPU model)
+	set_environment_capture(true);
+	if( !create_testbench(TESTBENCH_STD_N) ) {
+		fprintf(stderr, "Error: could not open testbench (memory?).\n");
+		exit(1);
+	}
+	set_denominator(1);
+	// packing buffers for all tiles of the tuning and the given one: allocated before timing
+	int tile = !tune && argc > arg + 2 ? atoi(argv[arg + 2]) : 0;
+	int max_tile = tune_tiles[N_OF(tune_tiles) - 1] > tile ? tune_tiles[N_OF(tune_tiles) - 1] : tile;
+	if (!mmul_parallel_create(threads, max_tile, true)) {
+		fprintf(stderr, "Error: could not create the thread pool.\n");
+		exit(1);
+	}
+
+	if (tune) {
+		fprintf(stderr, "CASP Simple Matrix Multiplicator. Autotuning\n");
+		fprintf(stderr, "packed micro-kernel: %s\n", mmul_packed_kernel_name());
+		srand(time(NULL));
+		int rc = tune_main(argc - 2, argv + 2);
+		mmul_parallel_delete();
+		delete_testbench();
+		return rc;
+	}
+
+	int size = atoi(argv[arg]);
+	// max. size of the size sweeps on stderr (parallel scaling, Strassen crossover)
+	int report_max_size = argc > arg + 1 ? atoi(argv[arg + 1]) : size;
+	struct testbench_environment env = testbench_get_environment();
+	config.tsc_ghz = env.captured ? env.tsc_ghz : 0.0;
+	int ld = leading_dimension(size, pad);
+	fprintf(stderr, "CASP Simple Matrix Multiplicator. Matrix size: %d, leading dimension: %d\n", size, ld);
+	fprintf(stderr, "packed micro-kernel: %s\n", mmul_packed_kernel_name());
+
+	// tuned block / tile sizes of this host (mmul tune); the defaults otherwise
+	const char *tune_path = mmul_tune_default_path();
+	if (mmul_tune_load(tune_path)) {
+		fprintf(stderr, "tuning cache: %s, %d entries\n", tune_path, mmul_tune_entries());
+	}
+	else {
+		fprintf(stderr, "tuning cache: %s not available for this CPU; *_tuned use the defaults\n", tune_path);
+	}
+
+	srand(time(NULL));
+
+	int *A = randmatrix(size, ld);
+	//printmatrix(size, ld, A, 'A');
+
+	int *B = randmatrix(size, ld);
+	//printmatrix(size, ld, B, 'B');
+
+	// workspace of the checks
+	struct mmul_arena workspace;
+	if(!mmul_arena_create(&workspace, mmul_workspace_bytes(size, ld) + mmul_freivalds_workspace_bytes(size))) {
+		fprintf(stderr, "Error: could not allocate the workspace (memory?).\n");
+		exit(1);
+	}
+
+	// reference result for small sizes; Freivalds' algorithm otherwise
+	struct verification verify = {NULL, rounds, seed};
+	if(exact == 1 || (exact < 0 && size <= VERIFY_EXACT_MAX_SIZE)) {
+		fprintf(stderr, "calculating reference solution for comparison.\n");
+		verify.ref = alloc_matrix(size, ld);
+		if(!verify.ref || !mmul(size, ld, A, B, verify.ref, &workspace)) {
+			fprintf(stderr, "Memory error!\n");
+			exit(1);
+		}
+	}
+	else {
+		fprintf(stderr, "verification with Freivalds' algorithm: %d rounds, seed %llu\n", rounds,
+			(unsigned long long)seed);
+	}
+
+	int n_tests = sizeof(tests) / sizeof(tests[0]);
+
+	// check algorithms to be tested:
+	for(int i = 0; i < n_tests; i++) {
+		if(!check_algorithm(size, ld, A, B, &verify, tests[i], names[i], &workspace)) {
+			free_matrix(size, ld, B);
+			B = NULL;
+			free_matrix(size, ld, A);
+			A = NULL;
+			exit(1);
+		}
+	}
+	if(!check_transpose()) {
+		exit(1);
+	}
+	fprintf(stderr, "\n");
+	free_matrix(size, ld, B);
+	B = NULL;
+	free_matrix(size, ld, A);
+	A = NULL;
+	free_matrix(size, ld, verify.ref);
+	verify.ref = NULL;
+	mmul_arena_delete(&workspace);
+
+	// benchmark algorithms to be tested:
+	set_cache_mode(config.cold ? TESTBENCH_CACHE_COLD : TESTBENCH_CACHE_WARM);
+	testbench_prepare_cache(); // allocates the flush buffer of cold mode outside of the rss deltas
+	print_table_header(size, ld, &config);
+	struct timing_result results[sizeof(tests) / sizeof(tests[0])];
+	int n_timed = 0;
+	for(int i = 0; i < n_tests; i++) {
+		if(!time_algorithm(size, ld, tests[i], names[i], &config, &results[i])) {
+			break;
+		}
+		print_table_row(names[i], size, &config, &results[i]);
+		n_timed++;
+	}
+	print_allocation_table(size, names, results, n_timed);
+	set_cache_mode(TESTBENCH_CACHE_AS_IS);
+
+	// reports on stderr; the table on stdout is kept as is
+	if((reports & REPORT_SCALING) && !time_scaling(size)) {
+		fprintf(stderr, "Error: scaling run failed.\n");
+	}
+	if((reports & REPORT_PARALLEL) && !time_parallel_scaling(report_max_size, tile)) {
+		fprintf(stderr, "Error: parallel scaling run failed.\n");
+	}
+	if((reports & REPORT_STRASSEN) && !time_strassen_crossover(report_max_size, pad)) {
+		fprintf(stderr, "Error: Strassen crossover run failed.\n");
+	}
+	if((reports & REPORT_TRANSPOSE) && !time_transpose(report_max_size, pad)) {
+		fprintf(stderr, "Error: transpose run failed.\n");
+	}
+	if((reports & REPORT_MORTON) && !time_morton(report_max_size, pad)) {
+		fprintf(stderr, "Error: Morton order run failed.\n");
+	}
+	if((reports & REPORT_TYPES) && !time_types(size)) {
+		fprintf(stderr, "Error: element type run failed.\n");
+	}
+	if((reports & REPORT_BATCHED) && !time_batched()) {
+		fprintf(stderr, "Error: batched run failed.\n");
+	}
+	if((reports & REPORT_PADDING) && !time_padding(report_max_size)) {
+		fprintf(stderr, "Error: padding run failed.\n");
+	}
 
-	printf("\n");
+	mmul_parallel_delete();
 	delete_testbench();
 	return 0;
 }
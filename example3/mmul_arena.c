@@ -0,0 +1,47 @@
+/*  Arena for temporary matrices; see mmul_arena.h
+*/
+
+#include "benchmark.h"
+#include "mmul_arena.h"
+
+size_t mmul_arena_bytes(size_t size) {
+	return (size + MMUL_ARENA_ALIGNMENT - 1) / MMUL_ARENA_ALIGNMENT * MMUL_ARENA_ALIGNMENT;
+}
+
+bool mmul_arena_create(struct mmul_arena *arena, size_t size) {
+	// the buffers of the benchmark library are page aligned
+	arena->size = mmul_arena_bytes(size > 0 ? size : 1);
+	arena->used = 0;
+	arena->base = testbench_alloc_buffer(arena->size, NULL);
+	if (!arena->base) {
+		arena->size = 0;
+		return false;
+	}
+	return true;
+}
+
+void mmul_arena_delete(struct mmul_arena *arena) {
+	testbench_free_buffer(arena->base, arena->size);
+	arena->base = NULL;
+	arena->size = 0;
+	arena->used = 0;
+}
+
+bool mmul_arena_reserve(struct mmul_arena *arena, size_t size) {
+	if (arena->base && arena->size >= size) {
+		arena->used = 0;
+		return true;
+	}
+	mmul_arena_delete(arena);
+	return mmul_arena_create(arena, size);
+}
+
+void *mmul_arena_alloc(struct mmul_arena *arena, size_t size) {
+	size_t bytes = mmul_arena_bytes(size);
+	if (!arena->base || bytes > arena->size - arena->used) {
+		return NULL;
+	}
+	void *p = arena->base + arena->used;
+	arena->used += bytes;
+	return p;
+}
@@ -0,0 +1,55 @@
+/*  Arena for temporary matrices: one prefaulted buffer of the benchmark library,
+	allocated once and reused; allocations are 64 byte aligned (cache lines, AVX-512)
+	and released in stack order by resetting to a mark. Thus, repeated multiplications
+	do not call malloc() / free() and do not fault pages.
+*/
+
+#ifndef MMUL_ARENA_H_
+#define MMUL_ARENA_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define MMUL_ARENA_ALIGNMENT 64
+
+struct mmul_arena {
+	char *base;
+	size_t size;
+	size_t used;
+};
+
+/**
+ * returns the bytes used by an allocation of size bytes (rounded up to the alignment)
+ */
+size_t mmul_arena_bytes(size_t size);
+
+/**
+ * returns false in case of memory allocation errors; the arena is empty then
+ */
+bool mmul_arena_create(struct mmul_arena *arena, size_t size);
+
+void mmul_arena_delete(struct mmul_arena *arena);
+
+/**
+ * empties the arena; keeps the buffer if it is large enough, replaces it otherwise
+ * returns false in case of memory allocation errors
+ */
+bool mmul_arena_reserve(struct mmul_arena *arena, size_t size);
+
+/**
+ * returns NULL if the arena is full; not zeroed
+ */
+void *mmul_arena_alloc(struct mmul_arena *arena, size_t size);
+
+static inline size_t mmul_arena_mark(const struct mmul_arena *arena) {
+	return arena->used;
+}
+
+/**
+ * releases all allocations since the mark
+ */
+static inline void mmul_arena_release(struct mmul_arena *arena, size_t mark) {
+	arena->used = mark;
+}
+
+#endif // MMUL_ARENA_H_
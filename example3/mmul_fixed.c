@@ -0,0 +1,74 @@
+/*  Matrix multiplication specialized for fixed sizes; see mmul_fixed.h
+*/
+
+#include <string.h>
+
+#include "mmul_fixed.h"
+
+//--- template -----------------------------------------------------------------
+
+// inlined into each DEFINE_MMUL_FIXED(n) with a constant n <= MMUL_FIXED_MAX_SIZE; never called
+// with a variable n
+// note: no #pragma GCC unroll for j; gcc spills the fully unrolled rows to the stack then
+static inline __attribute__((always_inline)) void fixed_template(int n, const int *restrict A,
+		const int *restrict B, int *restrict C) {
+	for (int i = 0; i < n; i++) {
+		int row[MMUL_FIXED_MAX_SIZE]; // fixed bound instead of a VLA: n is a constant only after inlining
+		int a = A[i * n];
+		for (int j = 0; j < n; j++) {
+			row[j] = a * B[j];
+		}
+		for (int k = 1; k < n; k++) {
+			a = A[i * n + k];
+			for (int j = 0; j < n; j++) {
+				row[j] += a * B[k * n + j];
+			}
+		}
+		memcpy(C + i * n, row, (size_t)n * sizeof(int));
+	}
+}
+
+#define DEFINE_MMUL_FIXED(n) \
+	static void mmul_fixed_##n(const int *A, const int *B, int *C) { \
+		fixed_template(n, A, B, C); \
+	}
+
+DEFINE_MMUL_FIXED(4)
+DEFINE_MMUL_FIXED(8)
+DEFINE_MMUL_FIXED(12)
+DEFINE_MMUL_FIXED(16)
+DEFINE_MMUL_FIXED(24)
+DEFINE_MMUL_FIXED(32)
+DEFINE_MMUL_FIXED(48)
+DEFINE_MMUL_FIXED(64)
+
+//--- dispatch -----------------------------------------------------------------
+
+static const int sizes_[] = {4, 8, 12, 16, 24, 32, 48, 64};
+
+static const mmul_fixed_function kernels_[] = {
+	mmul_fixed_4,
+	mmul_fixed_8,
+	mmul_fixed_12,
+	mmul_fixed_16,
+	mmul_fixed_24,
+	mmul_fixed_32,
+	mmul_fixed_48,
+	mmul_fixed_64
+};
+
+#define N_SIZES ((int)(sizeof(sizes_) / sizeof(sizes_[0])))
+
+mmul_fixed_function mmul_fixed_kernel(int size) {
+	for (int i = 0; i < N_SIZES; i++) {
+		if (sizes_[i] == size) {
+			return kernels_[i];
+		}
+	}
+	return NULL;
+}
+
+int mmul_fixed_sizes(const int **sizes) {
+	*sizes = sizes_;
+	return N_SIZES;
+}
@@ -0,0 +1,32 @@
+/*  Matrix multiplication specialized at compile time for small fixed sizes (4 ... 64):
+	one kernel per size generated by DEFINE_MMUL_FIXED(n) from a forced inline template;
+	with n a constant, the loop bounds and index calculations are constants; the compiler
+	unrolls and vectorizes the inner loops without remainder loops or runtime checks.
+	- i-k-j order: row of C += a_ik * row k of B, kept in registers for one row of C
+	- no temporaries (no B^T, no packing), thus no workspace
+	Row-major n x n int matrices, as in mmul.c.
+*/
+
+#ifndef MMUL_FIXED_H_
+#define MMUL_FIXED_H_
+
+#include <stdbool.h>
+
+#define MMUL_FIXED_MAX_SIZE 64 // largest size with a kernel
+
+/**
+ * C = A * B (n x n); C is overwritten
+ */
+typedef void (*mmul_fixed_function)(const int *A, const int *B, int *C);
+
+/**
+ * kernel for this size; NULL if there is none (see mmul_fixed_sizes())
+ */
+mmul_fixed_function mmul_fixed_kernel(int size);
+
+/**
+ * returns the number of sizes with a kernel; *sizes points to a static table (ascending)
+ */
+int mmul_fixed_sizes(const int **sizes);
+
+#endif // MMUL_FIXED_H_
@@ -0,0 +1,162 @@
+/*  Cache-oblivious matrix multiplication in Morton order; see mmul_morton.h
+*/
+
+#include <stdint.h>
+#include <string.h>
+
+#include "mmul_morton.h"
+
+//--- layout -------------------------------------------------------------------
+
+// bits 0..15 of x to the even bits
+static uint32_t spread_bits(uint32_t x) {
+	x &= 0xffffu;
+	x = (x | (x << 8)) & 0x00ff00ffu;
+	x = (x | (x << 4)) & 0x0f0f0f0fu;
+	x = (x | (x << 2)) & 0x33333333u;
+	x = (x | (x << 1)) & 0x55555555u;
+	return x;
+}
+
+// Z-order index of a tile; the tile row in the odd bits (quadrants 0 1 / 2 3)
+static size_t tile_index(int tile_row, int tile_column) {
+	return ((size_t)spread_bits((uint32_t)tile_row) << 1) | spread_bits((uint32_t)tile_column);
+}
+
+int mmul_morton_padded_size(int size, int *tile) {
+	int levels = 0;
+	int t = size > 0 ? size : 1;
+	while (t > MMUL_MORTON_TILE) {
+		levels++;
+		t = (size + (1 << levels) - 1) >> levels;
+	}
+	*tile = t;
+	return t << levels;
+}
+
+size_t mmul_morton_bytes(int size) {
+	int tile = 0;
+	size_t p = (size_t)mmul_morton_padded_size(size, &tile);
+	return p * p * sizeof(int);
+}
+
+void mmul_morton_from_row_major(int size, const int *M, int ld, int *Z) {
+	int tile = 0;
+	int p = mmul_morton_padded_size(size, &tile);
+	int tiles = p / tile;
+	size_t tile_elements = (size_t)tile * tile;
+	for (int ti = 0; ti < tiles; ti++) {
+		for (int tj = 0; tj < tiles; tj++) {
+			int *z = Z + tile_index(ti, tj) * tile_elements;
+			int j = tj * tile;
+			int columns = size - j < tile ? (size - j > 0 ? size - j : 0) : tile;
+			for (int r = 0; r < tile; r++) {
+				int i = ti * tile + r;
+				int n = i < size ? columns : 0;
+				memcpy(z + r * tile, M + (size_t)i * ld + j, (size_t)n * sizeof(int));
+				memset(z + r * tile + n, 0, (size_t)(tile - n) * sizeof(int));
+			}
+		}
+	}
+}
+
+void mmul_morton_to_row_major(int size, const int *Z, int *M, int ld) {
+	int tile = 0;
+	int p = mmul_morton_padded_size(size, &tile);
+	int tiles = p / tile;
+	size_t tile_elements = (size_t)tile * tile;
+	for (int ti = 0; ti < tiles && ti * tile < size; ti++) {
+		for (int tj = 0; tj < tiles && tj * tile < size; tj++) {
+			const int *z = Z + tile_index(ti, tj) * tile_elements;
+			int j = tj * tile;
+			int columns = size - j < tile ? size - j : tile;
+			for (int r = 0; r < tile && ti * tile + r < size; r++) {
+				memcpy(M + (size_t)(ti * tile + r) * ld + j, z + r * tile, (size_t)columns * sizeof(int));
+			}
+		}
+	}
+}
+
+//--- recursion ----------------------------------------------------------------
+
+// C += A * B on one tile (row-major tile x tile); i-k-j for vectorization
+static inline __attribute__((always_inline)) void tile_template(int tile, const int *restrict A,
+		const int *restrict B, int *restrict C) {
+	for (int i = 0; i < tile; i++) {
+		int *c = C + i * tile;
+		for (int k = 0; k < tile; k++) {
+			int a = A[i * tile + k];
+			const int *b = B + k * tile;
+			for (int j = 0; j < tile; j++) {
+				c[j] += a * b[j];
+			}
+		}
+	}
+}
+
+// constant bounds for the full tiles (all power of two sizes)
+static void tile_kernel(int tile, const int *A, const int *B, int *C) {
+	if (tile == MMUL_MORTON_TILE) {
+		tile_template(MMUL_MORTON_TILE, A, B, C);
+	}
+	else {
+		tile_template(tile, A, B, C);
+	}
+}
+
+// C += A * B with n x n in Morton order; the quadrants 0 1 / 2 3 are contiguous
+static void recurse(int n, int tile, const int *A, const int *B, int *C) {
+	if (n == tile) {
+		tile_kernel(tile, A, B, C);
+		return;
+	}
+	int h = n / 2;
+	size_t q = (size_t)h * h;
+	const int *A00 = A;
+	const int *A01 = A + q;
+	const int *A10 = A + 2 * q;
+	const int *A11 = A + 3 * q;
+	const int *B00 = B;
+	const int *B01 = B + q;
+	const int *B10 = B + 2 * q;
+	const int *B11 = B + 3 * q;
+	// the second product of each quadrant of C reuses one operand of the first
+	recurse(h, tile, A00, B00, C);
+	recurse(h, tile, A01, B10, C);
+	recurse(h, tile, A01, B11, C + q);
+	recurse(h, tile, A00, B01, C + q);
+	recurse(h, tile, A10, B01, C + 3 * q);
+	recurse(h, tile, A11, B11, C + 3 * q);
+	recurse(h, tile, A11, B10, C + 2 * q);
+	recurse(h, tile, A10, B00, C + 2 * q);
+}
+
+void mmul_morton_gemm(int size, const int *A, const int *B, int *C) {
+	int tile = 0;
+	int p = mmul_morton_padded_size(size, &tile);
+	memset(C, 0, (size_t)p * p * sizeof(int));
+	recurse(p, tile, A, B, C);
+}
+
+//--- row-major interface ------------------------------------------------------
+
+size_t mmul_morton_workspace_bytes(int size) {
+	return 3 * mmul_arena_bytes(mmul_morton_bytes(size));
+}
+
+bool mmul_morton(int size, int ld, const int *A, const int *B, int *C, struct mmul_arena *workspace) {
+	size_t mark = mmul_arena_mark(workspace);
+	size_t bytes = mmul_morton_bytes(size);
+	int *Az = mmul_arena_alloc(workspace, bytes);
+	int *Bz = mmul_arena_alloc(workspace, bytes);
+	int *Cz = mmul_arena_alloc(workspace, bytes);
+	bool ok = Az && Bz && Cz;
+	if (ok) {
+		mmul_morton_from_row_major(size, A, ld, Az);
+		mmul_morton_from_row_major(size, B, ld, Bz);
+		mmul_morton_gemm(size, Az, Bz, Cz);
+		mmul_morton_to_row_major(size, Cz, C, ld);
+	}
+	mmul_arena_release(workspace, mark);
+	return ok;
+}
@@ -0,0 +1,60 @@
+/*  Cache-oblivious matrix multiplication on matrices in Morton (Z-order) tiles:
+	- the matrix is padded to tile * 2^d and split into tiles of tile x tile elements
+	  (row-major within a tile); the tiles are stored in Z-order, i.e. interleaved bits
+	  of tile row and tile column: each quadrant on each level is contiguous
+	- recursive quadrant decomposition C_ij += A_i0 B_0j + A_i1 B_1j down to one tile;
+	  every level of the cache hierarchy is used without a tuned block size
+	- tile: the smallest d with ceil(size / 2^d) <= MMUL_MORTON_TILE; thus the padding
+	  stays below 2^d elements per dimension (as the padding of mmul_strassen.h)
+	- tile kernel i-k-j; with constant bounds for full tiles of MMUL_MORTON_TILE
+	- conversion from and to row-major: O(size^2), copied by rows of a tile
+	Row-major size x size int matrices outside; temporaries from the arena (mmul_arena.h).
+*/
+
+#ifndef MMUL_MORTON_H_
+#define MMUL_MORTON_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "mmul_arena.h"
+
+#define MMUL_MORTON_TILE 32
+
+/**
+ * padded size (tile * 2^d) of the Morton layout for this size; tile size in *tile
+ */
+int mmul_morton_padded_size(int size, int *tile);
+
+/**
+ * bytes of one size x size matrix in the Morton layout (padded)
+ */
+size_t mmul_morton_bytes(int size);
+
+/**
+ * Z = M in the Morton layout (incl. the zero padding); M row-major size x size, rows of ld elements
+ */
+void mmul_morton_from_row_major(int size, const int *M, int ld, int *Z);
+
+/**
+ * M = Z without the padding; M row-major size x size, rows of ld elements
+ */
+void mmul_morton_to_row_major(int size, const int *Z, int *M, int ld);
+
+/**
+ * C = A * B; all in the Morton layout of this size; C is overwritten (incl. the padding)
+ */
+void mmul_morton_gemm(int size, const int *A, const int *B, int *C);
+
+/**
+ * bytes of arena needed by mmul_morton(): A, B and C in the Morton layout
+ */
+size_t mmul_morton_workspace_bytes(int size);
+
+/**
+ * C = A * B on row-major matrices with rows of ld elements: conversion, mmul_morton_gemm(),
+ * conversion back; returns false if the workspace is too small
+ */
+bool mmul_morton(int size, int ld, const int *A, const int *B, int *C, struct mmul_arena *workspace);
+
+#endif // MMUL_MORTON_H_
@@ -0,0 +1,304 @@
+/*  Packed matrix multiplication with a register-tiled micro-kernel; see mmul_packed.h
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "benchmark.h"
+#include "mmul_packed.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define MMUL_PACKED_X86 1
+#include <immintrin.h>
+#endif
+
+//--- micro-kernels ------------------------------------------------------------
+//    c[MR x NR] += a-panel (kc x MR) * b-panel (kc x NR); c with leading dimension ldc
+
+// largest tile of all micro-kernels (edge tiles)
+#define MAX_TILE (8 * 32)
+
+typedef void (*micro_kernel_function)(int kc, const int *a, const int *b, int *c, int ldc);
+
+struct micro_kernel {
+	const char *name;
+	int mr;
+	int nr;
+	micro_kernel_function f;
+};
+
+static void kernel_scalar_4x4(int kc, const int *a, const int *b, int *c, int ldc) {
+	int acc[4][4] = {{0}};
+	for (int k = 0; k < kc; k++) {
+		for (int r = 0; r < 4; r++) {
+			for (int j = 0; j < 4; j++) {
+				acc[r][j] += a[r] * b[j];
+			}
+		}
+		a += 4;
+		b += 4;
+	}
+	for (int r = 0; r < 4; r++) {
+		for (int j = 0; j < 4; j++) {
+			c[r * ldc + j] += acc[r][j];
+		}
+	}
+}
+
+#ifdef MMUL_PACKED_X86
+
+// 12 accumulators, 2 registers of B, 1 broadcast of A
+__attribute__((target("avx2")))
+static void kernel_avx2_6x16(int kc, const int *a, const int *b, int *c, int ldc) {
+	__m256i acc[6][2];
+	for (int r = 0; r < 6; r++) {
+		acc[r][0] = _mm256_setzero_si256();
+		acc[r][1] = _mm256_setzero_si256();
+	}
+	for (int k = 0; k < kc; k++) {
+		__m256i b0 = _mm256_loadu_si256((const __m256i *)b);
+		__m256i b1 = _mm256_loadu_si256((const __m256i *)(b + 8));
+		for (int r = 0; r < 6; r++) {
+			__m256i ar = _mm256_set1_epi32(a[r]);
+			acc[r][0] = _mm256_add_epi32(acc[r][0], _mm256_mullo_epi32(ar, b0));
+			acc[r][1] = _mm256_add_epi32(acc[r][1], _mm256_mullo_epi32(ar, b1));
+		}
+		a += 6;
+		b += 16;
+	}
+	for (int r = 0; r < 6; r++) {
+		__m256i *c0 = (__m256i *)(c + r * ldc);
+		__m256i *c1 = (__m256i *)(c + r * ldc + 8);
+		_mm256_storeu_si256(c0, _mm256_add_epi32(_mm256_loadu_si256(c0), acc[r][0]));
+		_mm256_storeu_si256(c1, _mm256_add_epi32(_mm256_loadu_si256(c1), acc[r][1]));
+	}
+}
+
+// 16 accumulators, 2 registers of B, 1 broadcast of A
+__attribute__((target("avx512f")))
+static void kernel_avx512_8x32(int kc, const int *a, const int *b, int *c, int ldc) {
+	__m512i acc[8][2];
+	for (int r = 0; r < 8; r++) {
+		acc[r][0] = _mm512_setzero_si512();
+		acc[r][1] = _mm512_setzero_si512();
+	}
+	for (int k = 0; k < kc; k++) {
+		__m512i b0 = _mm512_loadu_si512((const void *)b);
+		__m512i b1 = _mm512_loadu_si512((const void *)(b + 16));
+		for (int r = 0; r < 8; r++) {
+			__m512i ar = _mm512_set1_epi32(a[r]);
+			acc[r][0] = _mm512_add_epi32(acc[r][0], _mm512_mullo_epi32(ar, b0));
+			acc[r][1] = _mm512_add_epi32(acc[r][1], _mm512_mullo_epi32(ar, b1));
+		}
+		a += 8;
+		b += 32;
+	}
+	for (int r = 0; r < 8; r++) {
+		int *c0 = c + r * ldc;
+		int *c1 = c + r * ldc + 16;
+		_mm512_storeu_si512((void *)c0, _mm512_add_epi32(_mm512_loadu_si512((const void *)c0), acc[r][0]));
+		_mm512_storeu_si512((void *)c1, _mm512_add_epi32(_mm512_loadu_si512((const void *)c1), acc[r][1]));
+	}
+}
+
+#endif // MMUL_PACKED_X86
+
+static const struct micro_kernel *select_kernel(void) {
+	static const struct micro_kernel scalar = {"scalar 4x4", 4, 4, kernel_scalar_4x4};
+#ifdef MMUL_PACKED_X86
+	static const struct micro_kernel avx2 = {"avx2 6x16", 6, 16, kernel_avx2_6x16};
+	static const struct micro_kernel avx512 = {"avx512 8x32", 8, 32, kernel_avx512_8x32};
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f")) {
+		return &avx512;
+	}
+	if (__builtin_cpu_supports("avx2")) {
+		return &avx2;
+	}
+#endif
+	return &scalar;
+}
+
+static const struct micro_kernel *kernel_ = NULL;
+
+static const struct micro_kernel *get_kernel(void) {
+	if (!kernel_) {
+		kernel_ = select_kernel();
+	}
+	return kernel_;
+}
+
+//--- packing ------------------------------------------------------------------
+//    zero padding up to multiples of MR / NR; thus, the micro-kernel always runs on full panels
+
+// mc x kc block of A -> micro-panels of mr rows, k-major
+static void pack_A(int mc, int kc, const int *A, int lda, int mr, int *packed) {
+	for (int i = 0; i < mc; i += mr) {
+		for (int k = 0; k < kc; k++) {
+			for (int r = 0; r < mr; r++) {
+				*packed++ = i + r < mc ? A[(i + r) * lda + k] : 0;
+			}
+		}
+	}
+}
+
+// kc x nc panel of B -> micro-panels of nr columns, k-major
+static void pack_B(int kc, int nc, const int *B, int ldb, int nr, int *packed) {
+	for (int j = 0; j < nc; j += nr) {
+		int width = nc - j < nr ? nc - j : nr;
+		for (int k = 0; k < kc; k++) {
+			const int *row = B + k * ldb + j;
+			int c = 0;
+			for (; c < width; c++) {
+				packed[c] = row[c];
+			}
+			for (; c < nr; c++) {
+				packed[c] = 0;
+			}
+			packed += nr;
+		}
+	}
+}
+
+//--- gemm ---------------------------------------------------------------------
+
+const char *mmul_packed_kernel_name(void) {
+	return get_kernel()->name;
+}
+
+static int round_up(int value, int multiple) {
+	return (value + multiple - 1) / multiple * multiple;
+}
+
+/**
+ * blocking as used for these dimensions: rounded to the micro-kernel and limited to the matrices
+ */
+static struct mmul_packed_blocking effective_blocking(int m, int n, int k, const struct mmul_packed_blocking *blocking) {
+	const struct micro_kernel *kernel = get_kernel();
+	int mr = kernel->mr;
+	int nr = kernel->nr;
+
+	struct mmul_packed_blocking b = {MMUL_PACKED_MC, MMUL_PACKED_KC, MMUL_PACKED_NC};
+	if (blocking) {
+		b = *blocking;
+	}
+	b.mc = b.mc / mr * mr;
+	b.nc = b.nc / nr * nr;
+	if (b.mc < mr) {
+		b.mc = mr;
+	}
+	if (b.nc < nr) {
+		b.nc = nr;
+	}
+	if (b.kc < 1) {
+		b.kc = 1;
+	}
+
+	// buffers not larger than needed for small matrices
+	if (b.mc > round_up(m, mr)) {
+		b.mc = round_up(m, mr);
+	}
+	if (b.nc > round_up(n, nr)) {
+		b.nc = round_up(n, nr);
+	}
+	if (b.kc > k && k > 0) {
+		b.kc = k;
+	}
+	return b;
+}
+
+void mmul_packed_workspace_size(int m, int n, int k, const struct mmul_packed_blocking *blocking,
+		size_t *a_bytes, size_t *b_bytes) {
+	struct mmul_packed_blocking b = effective_blocking(m, n, k, blocking);
+	*a_bytes = (size_t)b.mc * b.kc * sizeof(int);
+	*b_bytes = (size_t)b.kc * b.nc * sizeof(int);
+}
+
+bool mmul_packed_alloc_workspace(struct mmul_packed_workspace *ws, int m, int n, int k,
+		const struct mmul_packed_blocking *blocking) {
+	mmul_packed_workspace_size(m, n, k, blocking, &ws->a_bytes, &ws->b_bytes);
+	ws->packed_A = testbench_alloc_buffer(ws->a_bytes, NULL);
+	ws->packed_B = testbench_alloc_buffer(ws->b_bytes, NULL);
+	if (!ws->packed_A || !ws->packed_B) {
+		mmul_packed_free_workspace(ws);
+		return false;
+	}
+	return true;
+}
+
+void mmul_packed_free_workspace(struct mmul_packed_workspace *ws) {
+	testbench_free_buffer(ws->packed_A, ws->a_bytes);
+	testbench_free_buffer(ws->packed_B, ws->b_bytes);
+	ws->packed_A = NULL;
+	ws->packed_B = NULL;
+	ws->a_bytes = 0;
+	ws->b_bytes = 0;
+}
+
+bool mmul_packed_gemm(int m, int n, int k, const int *A, int lda, const int *B, int ldb, int *C, int ldc,
+		const struct mmul_packed_blocking *blocking) {
+	struct mmul_packed_workspace ws;
+	if (!mmul_packed_alloc_workspace(&ws, m, n, k, blocking)) {
+		return false;
+	}
+	bool ok = mmul_packed_gemm_workspace(m, n, k, A, lda, B, ldb, C, ldc, blocking, &ws);
+	mmul_packed_free_workspace(&ws);
+	return ok;
+}
+
+bool mmul_packed_gemm_workspace(int m, int n, int k, const int *A, int lda, const int *B, int ldb, int *C, int ldc,
+		const struct mmul_packed_blocking *blocking, struct mmul_packed_workspace *ws) {
+	const struct micro_kernel *kernel = get_kernel();
+	int mr = kernel->mr;
+	int nr = kernel->nr;
+	struct mmul_packed_blocking b = effective_blocking(m, n, k, blocking);
+	int mc = b.mc;
+	int nc = b.nc;
+	int kc = b.kc;
+	if ((size_t)mc * kc * sizeof(int) > ws->a_bytes || (size_t)kc * nc * sizeof(int) > ws->b_bytes) {
+		return false;
+	}
+	int *packed_A = ws->packed_A;
+	int *packed_B = ws->packed_B;
+
+	// edge tiles: computed into a local tile, then the valid part is added to C
+	int edge[MAX_TILE];
+
+	for (int jc = 0; jc < n; jc += nc) {
+		int nc_cur = n - jc < nc ? n - jc : nc;
+		for (int pc = 0; pc < k; pc += kc) {
+			int kc_cur = k - pc < kc ? k - pc : kc;
+			pack_B(kc_cur, nc_cur, B + pc * ldb + jc, ldb, nr, packed_B);
+
+			for (int ic = 0; ic < m; ic += mc) {
+				int mc_cur = m - ic < mc ? m - ic : mc;
+				pack_A(mc_cur, kc_cur, A + ic * lda + pc, lda, mr, packed_A);
+
+				for (int jr = 0; jr < nc_cur; jr += nr) {
+					const int *b_panel = packed_B + jr * kc_cur;
+					int width = nc_cur - jr < nr ? nc_cur - jr : nr;
+					for (int ir = 0; ir < mc_cur; ir += mr) {
+						const int *a_panel = packed_A + ir * kc_cur;
+						int height = mc_cur - ir < mr ? mc_cur - ir : mr;
+						int *c = C + (ic + ir) * ldc + jc + jr;
+						if (width == nr && height == mr) {
+							kernel->f(kc_cur, a_panel, b_panel, c, ldc);
+							continue;
+						}
+						for (int i = 0; i < mr * nr; i++) {
+							edge[i] = 0;
+						}
+						kernel->f(kc_cur, a_panel, b_panel, edge, nr);
+						for (int r = 0; r < height; r++) {
+							for (int j = 0; j < width; j++) {
+								c[r * ldc + j] += edge[r * nr + j];
+							}
+						}
+					} // ir
+				} // jr
+			} // ic
+		} // pc
+	} // jc
+
+	return true;
+}
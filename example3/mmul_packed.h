@@ -0,0 +1,74 @@
+/*  Packed matrix multiplication in the style of GotoBLAS / BLIS:
+	- B is packed into panels of KC x NC (L3), in micro-panels of NR columns
+	- A is packed into blocks of MC x KC (L2), in micro-panels of MR rows
+	- a register-tiled micro-kernel computes MR x NR of C from one micro-panel
+	  of each (the micro-panel of B stays in L1)
+	- micro-kernel selected at runtime: AVX-512 (8 x 32), AVX2 (6 x 16), scalar (4 x 4)
+	- int elements: vpmulld / vpaddd; there is no fused multiply-add for int32
+
+	Row-major matrices with leading dimensions (elements per row in memory).
+*/
+
+#ifndef MMUL_PACKED_H_
+#define MMUL_PACKED_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// default blocking; MC and NC are rounded down to multiples of MR and NR
+#define MMUL_PACKED_MC 128
+#define MMUL_PACKED_KC 256
+#define MMUL_PACKED_NC 4096
+
+struct mmul_packed_blocking {
+	int mc;
+	int kc;
+	int nc;
+};
+
+/**
+ * name of the micro-kernel selected for this CPU, e.g. "avx2 6x16"
+ */
+const char *mmul_packed_kernel_name(void);
+
+/**
+ * C += A * B with A m x k, B k x n, C m x n
+ * blocking: NULL for the defaults
+ * returns false in case of memory allocation errors (packing buffers)
+ */
+bool mmul_packed_gemm(int m, int n, int k, const int *A, int lda, const int *B, int ldb, int *C, int ldc,
+		const struct mmul_packed_blocking *blocking);
+
+/**
+ * packing buffers; allocated once for repeated calls, e.g. one per thread
+ */
+struct mmul_packed_workspace {
+	int *packed_A;
+	int *packed_B;
+	size_t a_bytes;
+	size_t b_bytes;
+};
+
+/**
+ * bytes of the packing buffers for these dimensions and blocking (NULL: defaults)
+ */
+void mmul_packed_workspace_size(int m, int n, int k, const struct mmul_packed_blocking *blocking,
+		size_t *a_bytes, size_t *b_bytes);
+
+/**
+ * allocates a workspace for matrices of up to m x k (A) and k x n (B) with the given blocking (NULL: defaults)
+ * returns false in case of memory allocation errors
+ */
+bool mmul_packed_alloc_workspace(struct mmul_packed_workspace *ws, int m, int n, int k,
+		const struct mmul_packed_blocking *blocking);
+
+void mmul_packed_free_workspace(struct mmul_packed_workspace *ws);
+
+/**
+ * as mmul_packed_gemm() but with the packing buffers of ws
+ * returns false if the workspace is too small for these dimensions and blocking
+ */
+bool mmul_packed_gemm_workspace(int m, int n, int k, const int *A, int lda, const int *B, int ldb, int *C, int ldc,
+		const struct mmul_packed_blocking *blocking, struct mmul_packed_workspace *ws);
+
+#endif // MMUL_PACKED_H_
@@ -0,0 +1,234 @@
+/*  Multithreaded tiled matrix multiplication with work stealing; see mmul_parallel.h
+*/
+
+#include <stdint.h>
+#include <string.h>
+
+#include "mmul_packed.h"
+#include "mmul_parallel.h"
+#include "parallel_benchmark.h"
+
+//--- tiles and ranges ---------------------------------------------------------
+//    range of tile indices [head, tail) in one 64 bit word: head in the low, tail in
+//    the high 32 bits; the owner takes the head, thieves take the back half; both by CAS
+
+struct job {
+	int size;
+	int ld;
+	const int *A;
+	const int *B;
+	int *C;
+	int tile;
+	int tiles_per_row;
+	int n_tiles;
+	int n_threads;
+};
+
+struct worker {
+	uint64_t range;      // own cache line
+	int index;
+	size_t steals;
+	struct mmul_packed_workspace ws;
+	int ws_tile;         // tile size of the workspace; 0: none
+} __attribute__((aligned(64)));
+
+static struct worker workers_[MMUL_PARALLEL_MAX_THREADS];
+static struct job job_;
+static unsigned tiles_done_ = 0;
+static bool reserve_failed_ = false;
+static struct mmul_parallel_stats stats_;
+
+static inline uint64_t make_range(uint32_t head, uint32_t tail) {
+	return (uint64_t)tail << 32 | head;
+}
+
+static int pop_own(struct worker *w) {
+	uint64_t r = __atomic_load_n(&w->range, __ATOMIC_ACQUIRE);
+	for (;;) {
+		uint32_t head = (uint32_t)r;
+		uint32_t tail = (uint32_t)(r >> 32);
+		if (head >= tail) {
+			return -1;
+		}
+		if (__atomic_compare_exchange_n(&w->range, &r, make_range(head + 1, tail), false,
+				__ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+			return (int)head;
+		}
+	}
+}
+
+/**
+ * steals the back half of the range of another thread into the (empty) own range
+ * returns false if all ranges are empty
+ */
+static bool steal(struct worker *w) {
+	int n = job_.n_threads;
+	for (int v = 1; v < n; v++) {
+		struct worker *victim = &workers_[(w->index + v) % n];
+		uint64_t r = __atomic_load_n(&victim->range, __ATOMIC_ACQUIRE);
+		for (;;) {
+			uint32_t head = (uint32_t)r;
+			uint32_t tail = (uint32_t)(r >> 32);
+			if (head >= tail) {
+				break;
+			}
+			uint32_t take = (tail - head + 1) / 2;
+			if (__atomic_compare_exchange_n(&victim->range, &r, make_range(head, tail - take), false,
+					__ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+				__atomic_store_n(&w->range, make_range(tail - take, tail), __ATOMIC_RELEASE);
+				w->steals++;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+static bool compute_tile(struct worker *w, int t) {
+	const struct job *j = &job_;
+	int i0 = t / j->tiles_per_row * j->tile;
+	int j0 = t % j->tiles_per_row * j->tile;
+	int m = j->size - i0 < j->tile ? j->size - i0 : j->tile;
+	int n = j->size - j0 < j->tile ? j->size - j0 : j->tile;
+
+	int *c = j->C + (size_t)i0 * j->ld + j0;
+	for (int i = 0; i < m; i++) {
+		memset(c + (size_t)i * j->ld, 0, (size_t)n * sizeof(int));
+	}
+	return mmul_packed_gemm_workspace(m, n, j->size, j->A + (size_t)i0 * j->ld, j->ld, j->B + j0, j->ld,
+			c, j->ld, NULL, &w->ws);
+}
+
+/**
+ * packing buffers of the thread for tiles up to tile x tile; kept for the next multiplication
+ */
+static bool reserve_workspace(struct worker *w, int tile) {
+	if (w->ws_tile >= tile) {
+		return true;
+	}
+	mmul_packed_free_workspace(&w->ws);
+	w->ws_tile = 0;
+	if (!mmul_packed_alloc_workspace(&w->ws, tile, tile, MMUL_PACKED_KC, NULL)) {
+		return false;
+	}
+	w->ws_tile = tile;
+	return true;
+}
+
+static void run_tiles(struct worker *w) {
+	// normally reserved by mmul_parallel_reserve(); larger tiles allocate here
+	if (!reserve_workspace(w, job_.tile)) {
+		return; // the own tiles are stolen by the others
+	}
+
+	for (;;) {
+		int t = pop_own(w);
+		if (t < 0) {
+			if (!steal(w)) {
+				return;
+			}
+			continue;
+		}
+		if (compute_tile(w, t)) {
+			__atomic_add_fetch(&tiles_done_, 1, __ATOMIC_RELAXED);
+		}
+	}
+}
+
+// called on the threads of the pool (testbench_pool_run())
+static void run_worker(void *context, size_t thread_index, size_t n_threads) {
+	(void)context;
+	(void)n_threads;
+	run_tiles(&workers_[thread_index]);
+}
+
+// allocation by each thread itself (first touch)
+static void reserve_worker(void *context, size_t thread_index, size_t n_threads) {
+	(void)n_threads;
+	struct worker *w = &workers_[thread_index];
+	if (!reserve_workspace(w, *(const int *)context)) {
+		__atomic_store_n(&reserve_failed_, true, __ATOMIC_RELAXED);
+	}
+}
+
+//--- API ----------------------------------------------------------------------
+
+bool mmul_parallel_create(int n_threads, int tile, bool pin) {
+	mmul_packed_kernel_name(); // kernel selection before the threads start
+	if (!testbench_pool_create(n_threads > 0 ? (size_t)n_threads : 0, pin)) {
+		return false;
+	}
+	if (!mmul_parallel_reserve(tile)) {
+		mmul_parallel_delete();
+		return false;
+	}
+	return true;
+}
+
+bool mmul_parallel_reserve(int tile) {
+	if (tile <= 0) {
+		tile = MMUL_PARALLEL_TILE;
+	}
+	__atomic_store_n(&reserve_failed_, false, __ATOMIC_RELAXED);
+	testbench_pool_run(reserve_worker, &tile, 0);
+	return !__atomic_load_n(&reserve_failed_, __ATOMIC_RELAXED);
+}
+
+void mmul_parallel_delete(void) {
+	testbench_pool_delete();
+	for (int i = 0; i < MMUL_PARALLEL_MAX_THREADS; i++) {
+		mmul_packed_free_workspace(&workers_[i].ws);
+		workers_[i].ws_tile = 0;
+	}
+}
+
+int mmul_parallel_threads(void) {
+	return (int)testbench_pool_threads();
+}
+
+bool mmul_parallel_gemm(int size, int ld, const int *A, const int *B, int *C, int n_threads, int tile) {
+	if (tile <= 0) {
+		tile = MMUL_PARALLEL_TILE;
+	}
+	int tiles_per_row = (size + tile - 1) / tile;
+	int n_tiles = tiles_per_row * tiles_per_row;
+
+	int pool = testbench_pool_threads() > 0 ? (int)testbench_pool_threads() : 1; // without a pool: the calling thread only
+	if (n_threads <= 0 || n_threads > pool) {
+		n_threads = pool;
+	}
+	if (n_threads > n_tiles) {
+		n_threads = n_tiles > 0 ? n_tiles : 1;
+	}
+
+	job_.size = size;
+	job_.ld = ld;
+	job_.A = A;
+	job_.B = B;
+	job_.C = C;
+	job_.tile = tile;
+	job_.tiles_per_row = tiles_per_row;
+	job_.n_tiles = n_tiles;
+	job_.n_threads = n_threads;
+	for (int i = 0; i < n_threads; i++) {
+		uint32_t head = (uint32_t)((int64_t)n_tiles * i / n_threads);
+		uint32_t tail = (uint32_t)((int64_t)n_tiles * (i + 1) / n_threads);
+		workers_[i].index = i;
+		workers_[i].steals = 0;
+		__atomic_store_n(&workers_[i].range, make_range(head, tail), __ATOMIC_RELAXED);
+	}
+	__atomic_store_n(&tiles_done_, 0, __ATOMIC_RELAXED);
+	testbench_pool_run(run_worker, NULL, (size_t)n_threads);
+
+	stats_.threads = (size_t)n_threads;
+	stats_.tiles = (size_t)n_tiles;
+	stats_.steals = 0;
+	for (int i = 0; i < n_threads; i++) {
+		stats_.steals += workers_[i].steals;
+	}
+	return __atomic_load_n(&tiles_done_, __ATOMIC_ACQUIRE) == (unsigned)n_tiles;
+}
+
+struct mmul_parallel_stats mmul_parallel_get_stats(void) {
+	return stats_;
+}
@@ -0,0 +1,69 @@
+/*  Multithreaded matrix multiplication: C is split into tiles of tile x tile
+	elements, each computed by the packed micro-kernel (mmul_packed.h) into C.
+	The tiles are scheduled on a persistent thread pool with work stealing:
+	- each thread starts with a contiguous range of tiles (row-major order)
+	- it takes tiles from the front of its own range
+	- when its range is empty, it steals the back half of the range of another
+	  thread; thus, uneven edge tiles and slow (noisy) cores balance automatically
+	The calling thread takes part as thread 0. Each thread has its own packing
+	buffers. The threads are those of the pool of the benchmark library
+	(testbench_pool_create() in parallel_benchmark.h); needs pthreads (compile
+	and link with -pthread).
+	Not thread safe: one pool per process, used by one thread at a time.
+*/
+
+#ifndef MMUL_PARALLEL_H_
+#define MMUL_PARALLEL_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "parallel_benchmark.h"
+
+#define MMUL_PARALLEL_MAX_THREADS TESTBENCH_POOL_MAX_THREADS
+#define MMUL_PARALLEL_TILE 256
+
+struct mmul_parallel_stats {
+	size_t threads; // used by the last multiplication
+	size_t tiles;
+	size_t steals;  // successful steals (each takes half of the remaining range of the victim)
+};
+
+/**
+ * n_threads: including the calling thread; 0: number of CPUs in the affinity mask
+ * tile: the packing buffers of all threads are allocated for tiles up to this size
+ *       (see mmul_parallel_reserve())
+ * pin: pin thread i to the i-th CPU of the affinity mask (Linux), including the calling
+ *      thread (until mmul_parallel_delete())
+ * returns false if the threads or the buffers cannot be created or the pool exists already
+ */
+bool mmul_parallel_create(int n_threads, int tile, bool pin);
+
+/**
+ * allocates the packing buffers of all threads (each by the thread itself) for tiles up to
+ * tile x tile (0: MMUL_PARALLEL_TILE); a multiplication with larger tiles allocates them
+ * within the call; returns false in case of memory allocation errors
+ */
+bool mmul_parallel_reserve(int tile);
+
+void mmul_parallel_delete(void);
+
+/**
+ * returns the number of threads of the pool including the calling thread; 0 if not created
+ */
+int mmul_parallel_threads(void);
+
+/**
+ * C = A * B (size x size; rows of ld >= size elements); C is overwritten
+ * n_threads: 0 for all threads of the pool; tile: 0 for MMUL_PARALLEL_TILE
+ * without a pool, the calling thread computes all tiles
+ * returns false in case of memory allocation errors (packing buffers)
+ */
+bool mmul_parallel_gemm(int size, int ld, const int *A, const int *B, int *C, int n_threads, int tile);
+
+/**
+ * statistics of the last mmul_parallel_gemm()
+ */
+struct mmul_parallel_stats mmul_parallel_get_stats(void);
+
+#endif // MMUL_PARALLEL_H_
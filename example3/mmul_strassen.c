@@ -0,0 +1,182 @@
+/*  Strassen-Winograd matrix multiplication; see mmul_strassen.h
+*/
+
+#include <string.h>
+
+#include "mmul_packed.h"
+#include "mmul_strassen.h"
+
+#define MIN_CROSSOVER 16
+
+//--- helpers ------------------------------------------------------------------
+
+static int effective_crossover(int crossover) {
+	if (crossover <= 0) {
+		return MMUL_STRASSEN_CROSSOVER;
+	}
+	return crossover < MIN_CROSSOVER ? MIN_CROSSOVER : crossover;
+}
+
+/**
+ * padded size: base case size (<= crossover) times 2^levels
+ */
+static int padded_size(int size, int crossover, int *base) {
+	int levels = 0;
+	int b = size;
+	while (b > crossover) {
+		levels++;
+		b = (size + (1 << levels) - 1) >> levels;
+	}
+	*base = b;
+	return b << levels;
+}
+
+static size_t matrix_bytes(int n) {
+	return mmul_arena_bytes((size_t)n * n * sizeof(int));
+}
+
+// Z = X + Y and Z = X - Y on n x n with leading dimensions
+static void add(int n, const int *X, int ldx, const int *Y, int ldy, int *Z, int ldz) {
+	for (int i = 0; i < n; i++) {
+		for (int j = 0; j < n; j++) {
+			Z[i * ldz + j] = X[i * ldx + j] + Y[i * ldy + j];
+		}
+	}
+}
+
+static void sub(int n, const int *X, int ldx, const int *Y, int ldy, int *Z, int ldz) {
+	for (int i = 0; i < n; i++) {
+		for (int j = 0; j < n; j++) {
+			Z[i * ldz + j] = X[i * ldx + j] - Y[i * ldy + j];
+		}
+	}
+}
+
+//--- recursion ----------------------------------------------------------------
+
+/**
+ * C = A * B (n x n); n is even above the crossover (padding)
+ */
+static bool strassen(int n, const int *A, int lda, const int *B, int ldb, int *C, int ldc, int crossover,
+		struct mmul_packed_workspace *ws, struct mmul_arena *arena) {
+	if (n <= crossover) {
+		for (int i = 0; i < n; i++) {
+			memset(C + i * ldc, 0, (size_t)n * sizeof(int));
+		}
+		return mmul_packed_gemm_workspace(n, n, n, A, lda, B, ldb, C, ldc, NULL, ws);
+	}
+
+	int h = n / 2;
+	const int *A11 = A;
+	const int *A12 = A + h;
+	const int *A21 = A + h * lda;
+	const int *A22 = A21 + h;
+	const int *B11 = B;
+	const int *B12 = B + h;
+	const int *B21 = B + h * ldb;
+	const int *B22 = B21 + h;
+	int *C11 = C;
+	int *C12 = C + h;
+	int *C21 = C + h * ldc;
+	int *C22 = C21 + h;
+
+	size_t mark = mmul_arena_mark(arena);
+	int *X = mmul_arena_alloc(arena, (size_t)h * h * sizeof(int));
+	int *Y = mmul_arena_alloc(arena, (size_t)h * h * sizeof(int));
+	if (!X || !Y) {
+		mmul_arena_release(arena, mark);
+		return false;
+	}
+
+	bool ok = true;
+	sub(h, A11, lda, A21, lda, X, h);                                               // S3 = A11 - A21
+	sub(h, B22, ldb, B12, ldb, Y, h);                                               // T3 = B22 - B12
+	ok = ok && strassen(h, X, h, Y, h, C21, ldc, crossover, ws, arena);             // P7 = S3 T3
+	add(h, A21, lda, A22, lda, X, h);                                               // S1 = A21 + A22
+	sub(h, B12, ldb, B11, ldb, Y, h);                                               // T1 = B12 - B11
+	ok = ok && strassen(h, X, h, Y, h, C22, ldc, crossover, ws, arena);             // P5 = S1 T1
+	sub(h, X, h, A11, lda, X, h);                                                   // S2 = S1 - A11
+	sub(h, B22, ldb, Y, h, Y, h);                                                   // T2 = B22 - T1
+	ok = ok && strassen(h, X, h, Y, h, C12, ldc, crossover, ws, arena);             // P6 = S2 T2
+	sub(h, A12, lda, X, h, X, h);                                                   // S4 = A12 - S2
+	ok = ok && strassen(h, X, h, B22, ldb, C11, ldc, crossover, ws, arena);         // P3 = S4 B22
+	ok = ok && strassen(h, A11, lda, B11, ldb, X, h, crossover, ws, arena);         // P1 = A11 B11
+	add(h, X, h, C12, ldc, C12, ldc);                                               // U2 = P1 + P6
+	add(h, C12, ldc, C21, ldc, C21, ldc);                                           // U3 = U2 + P7
+	add(h, C12, ldc, C22, ldc, C12, ldc);                                           // U4 = U2 + P5
+	add(h, C21, ldc, C22, ldc, C22, ldc);                                           // U7 = U3 + P5 -> C22
+	add(h, C12, ldc, C11, ldc, C12, ldc);                                           // U5 = U4 + P3 -> C12
+	sub(h, Y, h, B21, ldb, Y, h);                                                   // T4 = T2 - B21
+	ok = ok && strassen(h, A22, lda, Y, h, C11, ldc, crossover, ws, arena);         // P4 = A22 T4
+	sub(h, C21, ldc, C11, ldc, C21, ldc);                                           // U6 = U3 - P4 -> C21
+	ok = ok && strassen(h, A12, lda, B21, ldb, C11, ldc, crossover, ws, arena);     // P2 = A12 B21
+	add(h, X, h, C11, ldc, C11, ldc);                                               // U1 = P1 + P2 -> C11
+
+	mmul_arena_release(arena, mark);
+	return ok;
+}
+
+//--- API ----------------------------------------------------------------------
+
+size_t mmul_strassen_workspace_bytes(int size, int crossover) {
+	crossover = effective_crossover(crossover);
+	int base = 0;
+	int p = padded_size(size, crossover, &base);
+	size_t a_bytes = 0;
+	size_t b_bytes = 0;
+	mmul_packed_workspace_size(base, base, base, NULL, &a_bytes, &b_bytes);
+	size_t bytes = mmul_arena_bytes(a_bytes) + mmul_arena_bytes(b_bytes);
+	if (p != size) {
+		bytes += 3 * matrix_bytes(p);
+	}
+	for (int n = p; n > crossover; n /= 2) {
+		bytes += 2 * matrix_bytes(n / 2);
+	}
+	return bytes;
+}
+
+bool mmul_strassen_gemm(int size, int ld, const int *A, const int *B, int *C, int crossover,
+		struct mmul_arena *arena) {
+	crossover = effective_crossover(crossover);
+	int base = 0;
+	int p = padded_size(size, crossover, &base);
+	if (!arena->base || arena->size - arena->used < mmul_strassen_workspace_bytes(size, crossover)) {
+		return false;
+	}
+
+	// packing buffers of the base case
+	size_t mark = mmul_arena_mark(arena);
+	struct mmul_packed_workspace ws;
+	mmul_packed_workspace_size(base, base, base, NULL, &ws.a_bytes, &ws.b_bytes);
+	ws.packed_A = mmul_arena_alloc(arena, ws.a_bytes);
+	ws.packed_B = mmul_arena_alloc(arena, ws.b_bytes);
+
+	if (p == size) {
+		bool ok = strassen(size, A, ld, B, ld, C, ld, crossover, &ws, arena);
+		mmul_arena_release(arena, mark);
+		return ok;
+	}
+
+	// zero padding to p x p
+	int *Ap = mmul_arena_alloc(arena, (size_t)p * p * sizeof(int));
+	int *Bp = mmul_arena_alloc(arena, (size_t)p * p * sizeof(int));
+	int *Cp = mmul_arena_alloc(arena, (size_t)p * p * sizeof(int));
+	for (int i = 0; i < p; i++) {
+		if (i < size) {
+			memcpy(Ap + i * p, A + i * ld, (size_t)size * sizeof(int));
+			memcpy(Bp + i * p, B + i * ld, (size_t)size * sizeof(int));
+			memset(Ap + i * p + size, 0, (size_t)(p - size) * sizeof(int));
+			memset(Bp + i * p + size, 0, (size_t)(p - size) * sizeof(int));
+		}
+		else {
+			memset(Ap + i * p, 0, (size_t)p * sizeof(int));
+			memset(Bp + i * p, 0, (size_t)p * sizeof(int));
+		}
+	}
+	bool ok = strassen(p, Ap, p, Bp, p, Cp, p, crossover, &ws, arena);
+	for (int i = 0; i < size && ok; i++) {
+		memcpy(C + i * ld, Cp + i * p, (size_t)size * sizeof(int));
+	}
+	mmul_arena_release(arena, mark);
+	return ok;
+}
@@ -0,0 +1,37 @@
+/*  Strassen-Winograd matrix multiplication: 7 multiplications and 15 additions of
+	half size matrices per level instead of 8 multiplications; O(n^2.81).
+	- recursion down to the crossover size; then the packed micro-kernel (mmul_packed.h)
+	- schedule of Boyer, Dumas, Pernet, Zhou (2009) for C = A * B: the products are
+	  computed into the quadrants of C; only 2 temporaries of half size per level
+	- sizes that do not halve down to the crossover are zero padded once at the top:
+	  p = ceil(size / 2^d) * 2^d with the smallest d such that ceil(size / 2^d) <= crossover
+	- all temporaries and the packing buffers from one arena (mmul_arena.h); no allocation
+	Exact for int: only additions, subtractions and multiplications (no division).
+*/
+
+#ifndef MMUL_STRASSEN_H_
+#define MMUL_STRASSEN_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "mmul_arena.h"
+
+#define MMUL_STRASSEN_CROSSOVER 256
+
+/**
+ * bytes of arena needed by mmul_strassen_gemm() for this size and crossover
+ */
+size_t mmul_strassen_workspace_bytes(int size, int crossover);
+
+/**
+ * C = A * B (size x size, row-major with rows of ld >= size elements); C is overwritten
+ * crossover: 0 for MMUL_STRASSEN_CROSSOVER; minimum 16
+ * arena: with at least mmul_strassen_workspace_bytes() free (incl. the packing buffers);
+ *        released again at the end; no other allocation
+ * returns false if the arena is too small
+ */
+bool mmul_strassen_gemm(int size, int ld, const int *A, const int *B, int *C, int crossover,
+		struct mmul_arena *arena);
+
+#endif // MMUL_STRASSEN_H_
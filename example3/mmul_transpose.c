@@ -0,0 +1,188 @@
+/*  Transposition with in-register tiles; see mmul_transpose.h
+*/
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "mmul_transpose.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define MMUL_TRANSPOSE_X86 1
+#include <immintrin.h>
+#endif
+
+#define SCALAR_BLOCK 64
+#define MAX_TILE 16
+
+//--- tile kernels -------------------------------------------------------------
+//    dst[tile x tile] = src[tile x tile]^T
+
+typedef void (*tile_function)(const int *src, int lds, int *dst, int ldd);
+
+struct tile_kernel {
+	const char *name;
+	int tile;
+	tile_function f;
+};
+
+static void tile_scalar_8x8(const int *src, int lds, int *dst, int ldd) {
+	for (int i = 0; i < 8; i++) {
+		for (int j = 0; j < 8; j++) {
+			dst[j * ldd + i] = src[i * lds + j];
+		}
+	}
+}
+
+#ifdef MMUL_TRANSPOSE_X86
+
+__attribute__((target("avx2")))
+static void tile_avx2_8x8(const int *src, int lds, int *dst, int ldd) {
+	__m256i r[8];
+	__m256i t[8];
+	for (int i = 0; i < 8; i++) {
+		r[i] = _mm256_loadu_si256((const __m256i *)(src + i * lds));
+	}
+	// pairs of rows: 32 bit interleaved
+	for (int i = 0; i < 8; i += 2) {
+		t[i] = _mm256_unpacklo_epi32(r[i], r[i + 1]);
+		t[i + 1] = _mm256_unpackhi_epi32(r[i], r[i + 1]);
+	}
+	// 4 rows: per 128 bit lane, one column of 4 rows each (columns k and k + 4)
+	for (int i = 0; i < 8; i += 4) {
+		r[i] = _mm256_unpacklo_epi64(t[i], t[i + 2]);
+		r[i + 1] = _mm256_unpackhi_epi64(t[i], t[i + 2]);
+		r[i + 2] = _mm256_unpacklo_epi64(t[i + 1], t[i + 3]);
+		r[i + 3] = _mm256_unpackhi_epi64(t[i + 1], t[i + 3]);
+	}
+	// 128 bit lanes of rows 0..3 and 4..7
+	for (int k = 0; k < 4; k++) {
+		_mm256_storeu_si256((__m256i *)(dst + k * ldd), _mm256_permute2x128_si256(r[k], r[k + 4], 0x20));
+		_mm256_storeu_si256((__m256i *)(dst + (k + 4) * ldd), _mm256_permute2x128_si256(r[k], r[k + 4], 0x31));
+	}
+}
+
+__attribute__((target("avx512f")))
+static void tile_avx512_16x16(const int *src, int lds, int *dst, int ldd) {
+	__m512i r[16];
+	__m512i t[16];
+	for (int i = 0; i < 16; i++) {
+		r[i] = _mm512_loadu_si512((const void *)(src + i * lds));
+	}
+	for (int i = 0; i < 16; i += 2) {
+		t[i] = _mm512_unpacklo_epi32(r[i], r[i + 1]);
+		t[i + 1] = _mm512_unpackhi_epi32(r[i], r[i + 1]);
+	}
+	// per 128 bit lane l of r[i + k]: column 4 l + k of rows i .. i + 3
+	for (int i = 0; i < 16; i += 4) {
+		r[i] = _mm512_unpacklo_epi64(t[i], t[i + 2]);
+		r[i + 1] = _mm512_unpackhi_epi64(t[i], t[i + 2]);
+		r[i + 2] = _mm512_unpacklo_epi64(t[i + 1], t[i + 3]);
+		r[i + 3] = _mm512_unpackhi_epi64(t[i + 1], t[i + 3]);
+	}
+	// lanes 0 2 / 1 3 of rows 0..7 and 8..15; then the 4 row groups of each column
+	for (int k = 0; k < 4; k++) {
+		__m512i even_low = _mm512_shuffle_i32x4(r[k], r[k + 4], 0x88);
+		__m512i odd_low = _mm512_shuffle_i32x4(r[k], r[k + 4], 0xdd);
+		__m512i even_high = _mm512_shuffle_i32x4(r[k + 8], r[k + 12], 0x88);
+		__m512i odd_high = _mm512_shuffle_i32x4(r[k + 8], r[k + 12], 0xdd);
+		_mm512_storeu_si512((void *)(dst + k * ldd), _mm512_shuffle_i32x4(even_low, even_high, 0x88));
+		_mm512_storeu_si512((void *)(dst + (k + 4) * ldd), _mm512_shuffle_i32x4(odd_low, odd_high, 0x88));
+		_mm512_storeu_si512((void *)(dst + (k + 8) * ldd), _mm512_shuffle_i32x4(even_low, even_high, 0xdd));
+		_mm512_storeu_si512((void *)(dst + (k + 12) * ldd), _mm512_shuffle_i32x4(odd_low, odd_high, 0xdd));
+	}
+}
+
+#endif // MMUL_TRANSPOSE_X86
+
+static const struct tile_kernel *select_kernel(void) {
+	static const struct tile_kernel *selected = NULL;
+	static const struct tile_kernel scalar = {"scalar 8x8", 8, tile_scalar_8x8};
+	if (selected) {
+		return selected;
+	}
+	selected = &scalar;
+#ifdef MMUL_TRANSPOSE_X86
+	static const struct tile_kernel avx2 = {"avx2 8x8", 8, tile_avx2_8x8};
+	static const struct tile_kernel avx512 = {"avx512 16x16", 16, tile_avx512_16x16};
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f")) {
+		selected = &avx512;
+	}
+	else if (__builtin_cpu_supports("avx2")) {
+		selected = &avx2;
+	}
+#endif
+	return selected;
+}
+
+//--- API ----------------------------------------------------------------------
+
+const char *mmul_transpose_kernel_name(void) {
+	return select_kernel()->name;
+}
+
+void mmul_transpose(int n, const int *src, int lds, int *dst, int ldd) {
+	const struct tile_kernel *kernel = select_kernel();
+	int tile = kernel->tile;
+	int full = n / tile * tile;
+	for (int i = 0; i < full; i += tile) {
+		for (int j = 0; j < full; j += tile) {
+			kernel->f(src + i * lds + j, lds, dst + j * ldd + i, ldd);
+		}
+	}
+	// edges: columns full .. n - 1 of all rows, rows full .. n - 1 of the other columns
+	for (int i = 0; i < n; i++) {
+		for (int j = full; j < n; j++) {
+			dst[j * ldd + i] = src[i * lds + j];
+		}
+	}
+	for (int i = full; i < n; i++) {
+		for (int j = 0; j < full; j++) {
+			dst[j * ldd + i] = src[i * lds + j];
+		}
+	}
+}
+
+void mmul_transpose_in_place(int n, int *M, int ld) {
+	const struct tile_kernel *kernel = select_kernel();
+	int tile = kernel->tile;
+	int full = n / tile * tile;
+	int buffer[MAX_TILE * MAX_TILE];
+	for (int i = 0; i < full; i += tile) {
+		// diagonal tile
+		kernel->f(M + i * ld + i, ld, buffer, tile);
+		for (int r = 0; r < tile; r++) {
+			memcpy(M + (i + r) * ld + i, buffer + r * tile, (size_t)tile * sizeof(int));
+		}
+		// pairs of tiles (i, j) and (j, i)
+		for (int j = i + tile; j < full; j += tile) {
+			kernel->f(M + j * ld + i, ld, buffer, tile);
+			kernel->f(M + i * ld + j, ld, M + j * ld + i, ld);
+			for (int r = 0; r < tile; r++) {
+				memcpy(M + (i + r) * ld + j, buffer + r * tile, (size_t)tile * sizeof(int));
+			}
+		}
+	}
+	// edges: swap the pairs with a column >= full above the diagonal
+	for (int i = 0; i < n; i++) {
+		for (int j = i + 1 > full ? i + 1 : full; j < n; j++) {
+			int x = M[i * ld + j];
+			M[i * ld + j] = M[j * ld + i];
+			M[j * ld + i] = x;
+		}
+	}
+}
+
+void mmul_transpose_scalar(int n, const int *src, int lds, int *dst, int ldd) {
+	for (int i = 0; i < n; i += SCALAR_BLOCK) {
+		int end_i = i + SCALAR_BLOCK < n ? i + SCALAR_BLOCK : n;
+		for (int j = 0; j < n; j += SCALAR_BLOCK) {
+			int end_j = j + SCALAR_BLOCK < n ? j + SCALAR_BLOCK : n;
+			for (int i1 = i; i1 < end_i; i1++) {
+				for (int j1 = j; j1 < end_j; j1++) {
+					dst[j1 * ldd + i1] = src[i1 * lds + j1];
+				}
+			}
+		}
+	}
+}
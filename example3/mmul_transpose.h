@@ -0,0 +1,33 @@
+/*  Transposition of int matrices with in-register tiles:
+	- AVX-512: 16 x 16 tiles in 16 zmm registers (unpack 32 / 64 bit, 2 x shuffle of 128 bit lanes)
+	- AVX2:    8 x 8 tiles in 8 ymm registers (unpack 32 / 64 bit, permute of 128 bit lanes)
+	- scalar:  blocked element-wise copy (the loop of the original versions in mmul.c)
+	selected at runtime; full tiles are loaded and stored by rows, i.e. without strided
+	element stores; the edges beyond the last full tile are copied element-wise.
+	Row-major n x n matrices with leading dimensions (elements per row in memory).
+*/
+
+#ifndef MMUL_TRANSPOSE_H_
+#define MMUL_TRANSPOSE_H_
+
+/**
+ * name of the tile kernel selected for this CPU, e.g. "avx512 16x16"
+ */
+const char *mmul_transpose_kernel_name(void);
+
+/**
+ * dst = src^T (n x n); src and dst must not overlap
+ */
+void mmul_transpose(int n, const int *src, int lds, int *dst, int ldd);
+
+/**
+ * M = M^T (n x n); the tiles are swapped in pairs through a buffer on the stack
+ */
+void mmul_transpose_in_place(int n, int *M, int ld);
+
+/**
+ * dst = src^T element-wise in blocks of 64; reference for the comparison
+ */
+void mmul_transpose_scalar(int n, const int *src, int lds, int *dst, int ldd);
+
+#endif // MMUL_TRANSPOSE_H_
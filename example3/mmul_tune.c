@@ -0,0 +1,185 @@
+/*  Autotuning with successive halving and a tuning cache per host; see mmul_tune.h
+*/
+
+#define _POSIX_C_SOURCE 200112L // gethostname()
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "benchmark.h"
+#include "mmul_tune.h"
+
+//--- successive halving -------------------------------------------------------
+
+static int compare_candidates(const void *a, const void *b) {
+	const struct mmul_tune_candidate *ca = a;
+	const struct mmul_tune_candidate *cb = b;
+	if (ca->median < cb->median) {
+		return -1;
+	}
+	return ca->median > cb->median;
+}
+
+int mmul_tune_halving(struct mmul_tune_candidate *candidates, int n, mmul_tune_run run, void *context, FILE *stream) {
+	int alive = n;
+	int runs = 1;
+	for (int round = 1; alive > 0; round++) {
+		for (int c = 0; c < alive; c++) {
+			reset_testbench();
+			for (int r = 0; r < runs; r++) {
+				if (!run(context, candidates[c].params)) {
+					return 0;
+				}
+			}
+			candidates[c].median = testbench_get_statistics().median;
+			candidates[c].rounds = round;
+		}
+		qsort(candidates, (size_t)alive, sizeof(*candidates), compare_candidates);
+		if (stream) {
+			fprintf(stream, "  round %d: %d candidate(s), %d run(s) each; best %d %d %d: %.0f cycles\n",
+				round, alive, runs, candidates[0].params[0], candidates[0].params[1], candidates[0].params[2],
+				candidates[0].median);
+		}
+		if (alive == 1) {
+			break;
+		}
+		alive = (alive + 1) / 2;
+		runs *= 2;
+	}
+	return alive;
+}
+
+//--- tuning cache -------------------------------------------------------------
+
+struct entry {
+	char kind[MMUL_TUNE_KIND_LEN];
+	int size;
+	int params[MMUL_TUNE_PARAMS];
+	double cycles;
+};
+
+static struct entry entries_[MMUL_TUNE_MAX_ENTRIES];
+static int n_entries_ = 0;
+
+static const char *cpu_model(void) {
+	static struct testbench_environment env;
+	static bool captured = false;
+	if (!captured) {
+		env = testbench_get_environment();
+		captured = true;
+	}
+	return env.captured && env.cpu_model[0] ? env.cpu_model : "unknown";
+}
+
+const char *mmul_tune_default_path(void) {
+	static char path[320];
+	const char *env = getenv(MMUL_TUNE_CACHE_ENV);
+	if (env && env[0]) {
+		return env;
+	}
+	char host[256];
+	if (gethostname(host, sizeof(host)) != 0) {
+		strcpy(host, "localhost");
+	}
+	host[sizeof(host) - 1] = '\0';
+	snprintf(path, sizeof(path), "mmul_tune.%s.txt", host);
+	return path;
+}
+
+bool mmul_tune_load(const char *path) {
+	FILE *f = fopen(path, "r");
+	if (!f) {
+		return false;
+	}
+
+	// parsed into a copy: the table is kept as is if the file is of another CPU
+	struct entry loaded[MMUL_TUNE_MAX_ENTRIES];
+	char line[512];
+	bool same_cpu = false;
+	int n = 0;
+	while (fgets(line, sizeof(line), f)) {
+		line[strcspn(line, "\n")] = '\0';
+		if (strncmp(line, "# cpu ", 6) == 0) {
+			same_cpu = strcmp(line + 6, cpu_model()) == 0;
+			continue;
+		}
+		if (line[0] == '#' || line[0] == '\0' || n >= MMUL_TUNE_MAX_ENTRIES) {
+			continue;
+		}
+		struct entry e;
+		if (sscanf(line, "%23s %d %d %d %d %lf", e.kind, &e.size, &e.params[0], &e.params[1], &e.params[2],
+				&e.cycles) == 6 && e.size > 0) {
+			loaded[n++] = e;
+		}
+	}
+	fclose(f);
+
+	if (!same_cpu) {
+		return false;
+	}
+	memcpy(entries_, loaded, (size_t)n * sizeof(loaded[0]));
+	n_entries_ = n;
+	return true;
+}
+
+bool mmul_tune_save(const char *path) {
+	FILE *f = fopen(path, "w");
+	if (!f) {
+		return false;
+	}
+	fprintf(f, "# mmul tuning cache: <kind> <size> <param 0> <param 1> <param 2> <median cycles>\n");
+	fprintf(f, "# cpu %s\n", cpu_model());
+	for (int i = 0; i < n_entries_; i++) {
+		const struct entry *e = &entries_[i];
+		fprintf(f, "%s %d %d %d %d %.0f\n", e->kind, e->size, e->params[0], e->params[1], e->params[2], e->cycles);
+	}
+	bool ok = !ferror(f);
+	return fclose(f) == 0 && ok;
+}
+
+bool mmul_tune_set(const char *kind, int size, const int *params, double cycles) {
+	int i = 0;
+	while (i < n_entries_ && !(entries_[i].size == size && strcmp(entries_[i].kind, kind) == 0)) {
+		i++;
+	}
+	if (i == n_entries_) {
+		if (n_entries_ >= MMUL_TUNE_MAX_ENTRIES) {
+			return false;
+		}
+		n_entries_++;
+	}
+	struct entry *e = &entries_[i];
+	snprintf(e->kind, sizeof(e->kind), "%s", kind);
+	e->size = size;
+	memcpy(e->params, params, sizeof(e->params));
+	e->cycles = cycles;
+	return true;
+}
+
+bool mmul_tune_lookup(const char *kind, int size, int *params) {
+	const struct entry *best = NULL;
+	double best_distance = 0.0;
+	for (int i = 0; i < n_entries_; i++) {
+		const struct entry *e = &entries_[i];
+		if (strcmp(e->kind, kind) != 0) {
+			continue;
+		}
+		double distance = fabs(log((double)e->size / (double)size));
+		if (!best || distance < best_distance) {
+			best = e;
+			best_distance = distance;
+		}
+	}
+	if (!best) {
+		return false;
+	}
+	memcpy(params, best->params, sizeof(best->params));
+	return true;
+}
+
+int mmul_tune_entries(void) {
+	return n_entries_;
+}
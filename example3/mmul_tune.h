@@ -0,0 +1,81 @@
+/*  Autotuning of block sizes, tile sizes and accumulator counts per matrix size
+	- successive halving: all candidates are timed with 1 run each, the faster half
+	  is kept and timed again with twice the runs, ... until one is left; thus, the
+	  slow candidates cost little and the close ones are decided by the medians of
+	  more runs
+	- tuning cache: one text file per host with the winners per kind and matrix size;
+	  loaded at startup, entries of another CPU model are ignored
+	- lookup: entry of the nearest matrix size (by ratio) of the kind
+
+	Cache file format (one winner per line; # comments):
+	# cpu <model of testbench_get_environment()>
+	<kind> <size> <param 0> <param 1> <param 2> <median cycles>
+*/
+
+#ifndef MMUL_TUNE_H_
+#define MMUL_TUNE_H_
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#define MMUL_TUNE_PARAMS 3
+#define MMUL_TUNE_MAX_ENTRIES 256
+#define MMUL_TUNE_KIND_LEN 24
+
+// environment variable with the path of the cache file (overrides the default per host)
+#define MMUL_TUNE_CACHE_ENV "MMUL_TUNE_CACHE"
+
+struct mmul_tune_candidate {
+	int params[MMUL_TUNE_PARAMS]; // meaning defined by the kind; unused ones 0
+	double median;                // cycles; median of the last round of the candidate
+	int rounds;                   // rounds survived
+};
+
+/**
+ * one timed call with the given parameters; must add exactly one measurement
+ * with add_measurement(); returns false on errors
+ */
+typedef bool (*mmul_tune_run)(void *context, const int *params);
+
+/**
+ * successive halving over the candidates (reordered: fastest first after each round)
+ * stream: optional; progress per round
+ * returns the number of candidates (>= 1) that survived the last round;
+ * the winner is candidates[0]; 0 on errors
+ */
+int mmul_tune_halving(struct mmul_tune_candidate *candidates, int n, mmul_tune_run run, void *context, FILE *stream);
+
+/**
+ * default path: $MMUL_TUNE_CACHE or mmul_tune.<hostname>.txt in the working directory
+ */
+const char *mmul_tune_default_path(void);
+
+/**
+ * replaces the entries in memory by the ones of the file
+ * returns false if the file cannot be read or was written on another CPU model; the entries
+ * in memory are kept then
+ */
+bool mmul_tune_load(const char *path);
+
+/**
+ * writes all entries in memory; returns false on I/O errors
+ */
+bool mmul_tune_save(const char *path);
+
+/**
+ * adds or replaces the entry for kind and size
+ * returns false if the table is full
+ */
+bool mmul_tune_set(const char *kind, int size, const int *params, double cycles);
+
+/**
+ * params of the entry of kind with the nearest size; returns false if there is none
+ */
+bool mmul_tune_lookup(const char *kind, int size, int *params);
+
+/**
+ * number of entries in memory
+ */
+int mmul_tune_entries(void);
+
+#endif // MMUL_TUNE_H_
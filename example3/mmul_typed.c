@@ -0,0 +1,589 @@
+/*  Element-type generic matrix multiplication; see mmul_typed.h
+*/
+
+#define _XOPEN_SOURCE 600 // random()
+
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mmul_typed.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define MMUL_TYPED_X86 1
+#include <immintrin.h>
+#endif
+
+#define STRINGIFY_(x) #x
+#define STRINGIFY(x) STRINGIFY_(x)
+#define CONCAT_(a, b) a##_##b
+#define CONCAT(a, b) CONCAT_(a, b)
+#define TYPED(name) CONCAT(name, MMUL_SUFFIX)
+
+//--- generic variants per type ------------------------------------------------
+
+#define MMUL_T int8_t
+#define MMUL_R int32_t
+#define MMUL_SUFFIX i8
+#include "mmul_typed_template.h"
+
+#define MMUL_T int16_t
+#define MMUL_R int32_t
+#define MMUL_SUFFIX i16
+#include "mmul_typed_template.h"
+
+#define MMUL_T int32_t
+#define MMUL_R int32_t
+#define MMUL_SUFFIX i32
+#include "mmul_typed_template.h"
+
+#define MMUL_T float
+#define MMUL_R float
+#define MMUL_SUFFIX f32
+#include "mmul_typed_template.h"
+
+#define MMUL_T double
+#define MMUL_R double
+#define MMUL_SUFFIX f64
+#include "mmul_typed_template.h"
+
+//--- widening SIMD kernels (int8, int16) --------------------------------------
+//    k in groups per 32 bit lane: 2 x int16 (vpmaddwd) or 4 x int8 (vpdpbusd);
+//    A packed per row (one group broadcast), B per group row (ROWS x 2 vectors of C)
+
+#define ROWS 4
+#define COLUMNS 32 // columns of B padded to a multiple of this (2 x 16 lanes of AVX-512)
+
+struct packed {
+	int kg;          // groups along k
+	int np;          // columns of B, padded
+	uint32_t *Ap;    // (size rounded up to ROWS) x kg
+	uint32_t *Bp;    // kg x np
+	int32_t *offset; // np; vpdpbusd: 128 * column sums of B (A is offset by 128)
+};
+
+static int round_up(int n, int multiple) {
+	return (n + multiple - 1) / multiple * multiple;
+}
+
+static size_t packed_bytes(int size, int group) {
+	int kg = (size + group - 1) / group;
+	int np = round_up(size, COLUMNS);
+	return mmul_arena_bytes((size_t)round_up(size, ROWS) * kg * sizeof(uint32_t))
+		+ mmul_arena_bytes((size_t)kg * np * sizeof(uint32_t)) + mmul_arena_bytes((size_t)np * sizeof(int32_t));
+}
+
+static int element(const void *M, bool int8, int index) {
+	return int8 ? ((const int8_t *)M)[index] : ((const int16_t *)M)[index];
+}
+
+// group of up to 4 elements from M[index], M[index + stride], ...; 0 beyond count
+static uint32_t lane(const void *M, bool int8, int index, int stride, int count, int group, int offset) {
+	uint32_t value = 0;
+	int bits = 32 / group;
+	uint32_t mask = (1u << bits) - 1u;
+	for (int q = 0; q < group; q++) {
+		int v = (q < count ? element(M, int8, index + q * stride) : 0) + offset;
+		value |= ((uint32_t)v & mask) << (q * bits);
+	}
+	return value;
+}
+
+/**
+ * group 2: int16 pairs (int8 sign extended); group 4: int8 quads, A offset by 128 (unsigned)
+ */
+static bool pack(int size, int group, bool int8, const void *A, const void *B, struct mmul_arena *workspace,
+		struct packed *p) {
+	p->kg = (size + group - 1) / group;
+	p->np = round_up(size, COLUMNS);
+	int mp = round_up(size, ROWS);
+	p->Ap = mmul_arena_alloc(workspace, (size_t)mp * p->kg * sizeof(uint32_t));
+	p->Bp = mmul_arena_alloc(workspace, (size_t)p->kg * p->np * sizeof(uint32_t));
+	p->offset = mmul_arena_alloc(workspace, (size_t)p->np * sizeof(int32_t));
+	if (!p->Ap || !p->Bp || !p->offset) {
+		return false;
+	}
+
+	int a_offset = group == 4 ? 128 : 0;
+	for (int i = 0; i < mp; i++) {
+		for (int g = 0; g < p->kg; g++) {
+			int count = i < size ? size - g * group : 0;
+			p->Ap[i * p->kg + g] = lane(A, int8, i * size + g * group, 1, count, group, a_offset);
+		}
+	}
+	for (int g = 0; g < p->kg; g++) {
+		for (int j = 0; j < p->np; j++) {
+			int count = j < size ? size - g * group : 0;
+			p->Bp[g * p->np + j] = lane(B, int8, g * group * size + j, size, count, group, 0);
+		}
+	}
+	for (int j = 0; j < p->np; j++) {
+		int32_t sum = 0;
+		for (int k = 0; k < size && j < size && a_offset; k++) {
+			sum += element(B, int8, k * size + j);
+		}
+		p->offset[j] = a_offset * sum;
+	}
+	return true;
+}
+
+#ifdef MMUL_TYPED_X86
+
+__attribute__((target("avx512f")))
+static inline void store_avx512(int size, int i, int j, __m512i acc[ROWS][2], const int32_t *offset, int32_t *C) {
+	__m512i o0 = _mm512_loadu_si512((const void *)(offset + j));
+	__m512i o1 = _mm512_loadu_si512((const void *)(offset + j + 16));
+	int n0 = size - j < 16 ? size - j : 16;
+	int n1 = size - j - 16 < 0 ? 0 : (size - j - 16 < 16 ? size - j - 16 : 16);
+	__mmask16 m0 = (__mmask16)((1u << n0) - 1u);
+	__mmask16 m1 = (__mmask16)((1u << n1) - 1u);
+	for (int r = 0; r < ROWS && i + r < size; r++) {
+		int32_t *c = C + (i + r) * size + j;
+		_mm512_mask_storeu_epi32((void *)c, m0, _mm512_sub_epi32(acc[r][0], o0));
+		_mm512_mask_storeu_epi32((void *)(c + 16), m1, _mm512_sub_epi32(acc[r][1], o1));
+	}
+}
+
+// s16 pairs x s16 pairs -> s32
+__attribute__((target("avx512f,avx512bw")))
+static void kernel_madd_avx512(int size, const struct packed *p, int32_t *C) {
+	for (int i = 0; i < size; i += ROWS) {
+		const uint32_t *a = p->Ap + i * p->kg;
+		for (int j = 0; j < size; j += COLUMNS) {
+			__m512i acc[ROWS][2];
+			for (int r = 0; r < ROWS; r++) {
+				acc[r][0] = _mm512_setzero_si512();
+				acc[r][1] = _mm512_setzero_si512();
+			}
+			const uint32_t *b = p->Bp + j;
+			for (int g = 0; g < p->kg; g++) {
+				__m512i b0 = _mm512_loadu_si512((const void *)b);
+				__m512i b1 = _mm512_loadu_si512((const void *)(b + 16));
+				for (int r = 0; r < ROWS; r++) {
+					__m512i ar = _mm512_set1_epi32((int)a[r * p->kg + g]);
+					acc[r][0] = _mm512_add_epi32(acc[r][0], _mm512_madd_epi16(ar, b0));
+					acc[r][1] = _mm512_add_epi32(acc[r][1], _mm512_madd_epi16(ar, b1));
+				}
+				b += p->np;
+			}
+			store_avx512(size, i, j, acc, p->offset, C);
+		}
+	}
+}
+
+// u8 quads x s8 quads -> s32, accumulated without saturation
+__attribute__((target("avx512f,avx512vnni")))
+static void kernel_vnni_avx512(int size, const struct packed *p, int32_t *C) {
+	for (int i = 0; i < size; i += ROWS) {
+		const uint32_t *a = p->Ap + i * p->kg;
+		for (int j = 0; j < size; j += COLUMNS) {
+			__m512i acc[ROWS][2];
+			for (int r = 0; r < ROWS; r++) {
+				acc[r][0] = _mm512_setzero_si512();
+				acc[r][1] = _mm512_setzero_si512();
+			}
+			const uint32_t *b = p->Bp + j;
+			for (int g = 0; g < p->kg; g++) {
+				__m512i b0 = _mm512_loadu_si512((const void *)b);
+				__m512i b1 = _mm512_loadu_si512((const void *)(b + 16));
+				for (int r = 0; r < ROWS; r++) {
+					__m512i ar = _mm512_set1_epi32((int)a[r * p->kg + g]);
+					acc[r][0] = _mm512_dpbusd_epi32(acc[r][0], ar, b0);
+					acc[r][1] = _mm512_dpbusd_epi32(acc[r][1], ar, b1);
+				}
+				b += p->np;
+			}
+			store_avx512(size, i, j, acc, p->offset, C);
+		}
+	}
+}
+
+// s16 pairs x s16 pairs -> s32; 16 columns per step
+__attribute__((target("avx2")))
+static void kernel_madd_avx2(int size, const struct packed *p, int32_t *C) {
+	for (int i = 0; i < size; i += ROWS) {
+		const uint32_t *a = p->Ap + i * p->kg;
+		for (int j = 0; j < size; j += 16) {
+			__m256i acc[ROWS][2];
+			for (int r = 0; r < ROWS; r++) {
+				acc[r][0] = _mm256_setzero_si256();
+				acc[r][1] = _mm256_setzero_si256();
+			}
+			const uint32_t *b = p->Bp + j;
+			for (int g = 0; g < p->kg; g++) {
+				__m256i b0 = _mm256_loadu_si256((const __m256i *)b);
+				__m256i b1 = _mm256_loadu_si256((const __m256i *)(b + 8));
+				for (int r = 0; r < ROWS; r++) {
+					__m256i ar = _mm256_set1_epi32((int)a[r * p->kg + g]);
+					acc[r][0] = _mm256_add_epi32(acc[r][0], _mm256_madd_epi16(ar, b0));
+					acc[r][1] = _mm256_add_epi32(acc[r][1], _mm256_madd_epi16(ar, b1));
+				}
+				b += p->np;
+			}
+			// edge tiles via a buffer; no offset for vpmaddwd
+			int n = size - j < 16 ? size - j : 16;
+			for (int r = 0; r < ROWS && i + r < size; r++) {
+				int32_t tile[16];
+				_mm256_storeu_si256((__m256i *)tile, acc[r][0]);
+				_mm256_storeu_si256((__m256i *)(tile + 8), acc[r][1]);
+				memcpy(C + (i + r) * size + j, tile, (size_t)n * sizeof(int32_t));
+			}
+		}
+	}
+}
+
+#endif // MMUL_TYPED_X86
+
+typedef void (*widening_kernel)(int size, const struct packed *p, int32_t *C);
+
+static bool widening(int size, const void *A, const void *B, void *C, struct mmul_arena *workspace, int group,
+		bool int8, widening_kernel kernel) {
+	size_t mark = mmul_arena_mark(workspace);
+	struct packed p;
+	bool ok = pack(size, group, int8, A, B, workspace, &p);
+	if (ok) {
+		kernel(size, &p, C);
+	}
+	mmul_arena_release(workspace, mark);
+	return ok;
+}
+
+#ifdef MMUL_TYPED_X86
+
+static bool vnni_i8(int size, const void *A, const void *B, void *C, struct mmul_arena *workspace) {
+	return widening(size, A, B, C, workspace, 4, true, kernel_vnni_avx512);
+}
+
+static bool madd_avx512_i8(int size, const void *A, const void *B, void *C, struct mmul_arena *workspace) {
+	return widening(size, A, B, C, workspace, 2, true, kernel_madd_avx512);
+}
+
+static bool madd_avx2_i8(int size, const void *A, const void *B, void *C, struct mmul_arena *workspace) {
+	return widening(size, A, B, C, workspace, 2, true, kernel_madd_avx2);
+}
+
+static bool madd_avx512_i16(int size, const void *A, const void *B, void *C, struct mmul_arena *workspace) {
+	return widening(size, A, B, C, workspace, 2, false, kernel_madd_avx512);
+}
+
+static bool madd_avx2_i16(int size, const void *A, const void *B, void *C, struct mmul_arena *workspace) {
+	return widening(size, A, B, C, workspace, 2, false, kernel_madd_avx2);
+}
+
+#endif // MMUL_TYPED_X86
+
+//--- FMA kernels (float, double) ----------------------------------------------
+//    i-k-j as the rows variant, register tiled: ROWS rows x 2 vectors of C accumulate
+//    a_ik (broadcast) * row k of B; no packing, unaligned loads; the sums along k keep
+//    their order (one rounding per FMA instead of two per multiply-add)
+
+#ifdef MMUL_TYPED_X86
+
+// rows i..i+rows-1, columns j..size-1 in scalar code (column edge of the AVX2 kernels)
+#define FMA_EDGE(T, FMA, size, i, rows, j, A, B, C) \
+	for (int r = 0; r < (rows); r++) { \
+		T *c = (C) + ((i) + r) * (size); \
+		for (int j1 = (j); j1 < (size); j1++) { \
+			c[j1] = 0; \
+		} \
+		for (int k = 0; k < (size); k++) { \
+			T a = (A)[((i) + r) * (size) + k]; \
+			const T *b = (B) + k * (size); \
+			for (int j1 = (j); j1 < (size); j1++) { \
+				c[j1] = FMA(a, b[j1], c[j1]); \
+			} \
+		} \
+	}
+
+__attribute__((target("avx512f")))
+static bool fma_avx512_f32(int size, const void *A_, const void *B_, void *C_, struct mmul_arena *workspace) {
+	(void)workspace;
+	const float *A = A_;
+	const float *B = B_;
+	float *C = C_;
+	for (int i = 0; i < size; i += ROWS) {
+		int rows = size - i < ROWS ? size - i : ROWS;
+		for (int j = 0; j < size; j += 32) {
+			int n0 = size - j < 16 ? size - j : 16;
+			int n1 = size - j - 16 < 0 ? 0 : (size - j - 16 < 16 ? size - j - 16 : 16);
+			__mmask16 m0 = (__mmask16)((1u << n0) - 1u);
+			__mmask16 m1 = (__mmask16)((1u << n1) - 1u);
+			__m512 acc[ROWS][2];
+			for (int r = 0; r < ROWS; r++) {
+				acc[r][0] = _mm512_setzero_ps();
+				acc[r][1] = _mm512_setzero_ps();
+			}
+			for (int k = 0; k < size; k++) {
+				const float *b = B + k * size + j;
+				__m512 b0 = _mm512_maskz_loadu_ps(m0, b);
+				__m512 b1 = _mm512_maskz_loadu_ps(m1, b + 16);
+				for (int r = 0; r < rows; r++) {
+					__m512 ar = _mm512_set1_ps(A[(i + r) * size + k]);
+					acc[r][0] = _mm512_fmadd_ps(ar, b0, acc[r][0]);
+					acc[r][1] = _mm512_fmadd_ps(ar, b1, acc[r][1]);
+				}
+			}
+			for (int r = 0; r < rows; r++) {
+				float *c = C + (i + r) * size + j;
+				_mm512_mask_storeu_ps(c, m0, acc[r][0]);
+				_mm512_mask_storeu_ps(c + 16, m1, acc[r][1]);
+			}
+		}
+	}
+	return true;
+}
+
+__attribute__((target("avx512f")))
+static bool fma_avx512_f64(int size, const void *A_, const void *B_, void *C_, struct mmul_arena *workspace) {
+	(void)workspace;
+	const double *A = A_;
+	const double *B = B_;
+	double *C = C_;
+	for (int i = 0; i < size; i += ROWS) {
+		int rows = size - i < ROWS ? size - i : ROWS;
+		for (int j = 0; j < size; j += 16) {
+			int n0 = size - j < 8 ? size - j : 8;
+			int n1 = size - j - 8 < 0 ? 0 : (size - j - 8 < 8 ? size - j - 8 : 8);
+			__mmask8 m0 = (__mmask8)((1u << n0) - 1u);
+			__mmask8 m1 = (__mmask8)((1u << n1) - 1u);
+			__m512d acc[ROWS][2];
+			for (int r = 0; r < ROWS; r++) {
+				acc[r][0] = _mm512_setzero_pd();
+				acc[r][1] = _mm512_setzero_pd();
+			}
+			for (int k = 0; k < size; k++) {
+				const double *b = B + k * size + j;
+				__m512d b0 = _mm512_maskz_loadu_pd(m0, b);
+				__m512d b1 = _mm512_maskz_loadu_pd(m1, b + 8);
+				for (int r = 0; r < rows; r++) {
+					__m512d ar = _mm512_set1_pd(A[(i + r) * size + k]);
+					acc[r][0] = _mm512_fmadd_pd(ar, b0, acc[r][0]);
+					acc[r][1] = _mm512_fmadd_pd(ar, b1, acc[r][1]);
+				}
+			}
+			for (int r = 0; r < rows; r++) {
+				double *c = C + (i + r) * size + j;
+				_mm512_mask_storeu_pd(c, m0, acc[r][0]);
+				_mm512_mask_storeu_pd(c + 8, m1, acc[r][1]);
+			}
+		}
+	}
+	return true;
+}
+
+__attribute__((target("avx2,fma")))
+static bool fma_avx2_f32(int size, const void *A_, const void *B_, void *C_, struct mmul_arena *workspace) {
+	(void)workspace;
+	const float *A = A_;
+	const float *B = B_;
+	float *C = C_;
+	int full = size - size % 16;
+	for (int i = 0; i < size; i += ROWS) {
+		int rows = size - i < ROWS ? size - i : ROWS;
+		for (int j = 0; j < full; j += 16) {
+			__m256 acc[ROWS][2];
+			for (int r = 0; r < ROWS; r++) {
+				acc[r][0] = _mm256_setzero_ps();
+				acc[r][1] = _mm256_setzero_ps();
+			}
+			for (int k = 0; k < size; k++) {
+				const float *b = B + k * size + j;
+				__m256 b0 = _mm256_loadu_ps(b);
+				__m256 b1 = _mm256_loadu_ps(b + 8);
+				for (int r = 0; r < rows; r++) {
+					__m256 ar = _mm256_set1_ps(A[(i + r) * size + k]);
+					acc[r][0] = _mm256_fmadd_ps(ar, b0, acc[r][0]);
+					acc[r][1] = _mm256_fmadd_ps(ar, b1, acc[r][1]);
+				}
+			}
+			for (int r = 0; r < rows; r++) {
+				float *c = C + (i + r) * size + j;
+				_mm256_storeu_ps(c, acc[r][0]);
+				_mm256_storeu_ps(c + 8, acc[r][1]);
+			}
+		}
+		FMA_EDGE(float, fmaf, size, i, rows, full, A, B, C)
+	}
+	return true;
+}
+
+__attribute__((target("avx2,fma")))
+static bool fma_avx2_f64(int size, const void *A_, const void *B_, void *C_, struct mmul_arena *workspace) {
+	(void)workspace;
+	const double *A = A_;
+	const double *B = B_;
+	double *C = C_;
+	int full = size - size % 8;
+	for (int i = 0; i < size; i += ROWS) {
+		int rows = size - i < ROWS ? size - i : ROWS;
+		for (int j = 0; j < full; j += 8) {
+			__m256d acc[ROWS][2];
+			for (int r = 0; r < ROWS; r++) {
+				acc[r][0] = _mm256_setzero_pd();
+				acc[r][1] = _mm256_setzero_pd();
+			}
+			for (int k = 0; k < size; k++) {
+				const double *b = B + k * size + j;
+				__m256d b0 = _mm256_loadu_pd(b);
+				__m256d b1 = _mm256_loadu_pd(b + 4);
+				for (int r = 0; r < rows; r++) {
+					__m256d ar = _mm256_set1_pd(A[(i + r) * size + k]);
+					acc[r][0] = _mm256_fmadd_pd(ar, b0, acc[r][0]);
+					acc[r][1] = _mm256_fmadd_pd(ar, b1, acc[r][1]);
+				}
+			}
+			for (int r = 0; r < rows; r++) {
+				double *c = C + (i + r) * size + j;
+				_mm256_storeu_pd(c, acc[r][0]);
+				_mm256_storeu_pd(c + 4, acc[r][1]);
+			}
+		}
+		FMA_EDGE(double, fma, size, i, rows, full, A, B, C)
+	}
+	return true;
+}
+
+#endif // MMUL_TYPED_X86
+
+//--- API ----------------------------------------------------------------------
+
+#define MAX_VARIANTS 8
+#define N_GENERIC ((int)(sizeof(generic_variants_i8) / sizeof(generic_variants_i8[0])))
+
+static const struct mmul_type_info infos[MMUL_TYPES] = {
+	{"int8", sizeof(int8_t), sizeof(int32_t), true},
+	{"int16", sizeof(int16_t), sizeof(int32_t), true},
+	{"int32", sizeof(int32_t), sizeof(int32_t), true},
+	{"float", sizeof(float), sizeof(float), false},
+	{"double", sizeof(double), sizeof(double), false}
+};
+
+static struct mmul_typed_variant variants_[MMUL_TYPES][MAX_VARIANTS];
+static int n_variants_[MMUL_TYPES];
+
+static void add_variant(enum mmul_type type, const char *name, mmul_typed_function f) {
+	struct mmul_typed_variant v = {name, f};
+	variants_[type][n_variants_[type]++] = v;
+}
+
+static void init_variants(void) {
+	static bool initialized = false;
+	if (initialized) {
+		return;
+	}
+	initialized = true;
+
+	const struct mmul_typed_variant *generic[MMUL_TYPES] = {
+		generic_variants_i8, generic_variants_i16, generic_variants_i32, generic_variants_f32, generic_variants_f64
+	};
+	for (int t = 0; t < MMUL_TYPES; t++) {
+		for (int i = 0; i < N_GENERIC; i++) {
+			add_variant(t, generic[t][i].name, generic[t][i].f);
+		}
+	}
+
+#ifdef MMUL_TYPED_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512vnni")) {
+		add_variant(MMUL_INT8, "vnni_avx512", vnni_i8);
+	}
+	if (__builtin_cpu_supports("avx512bw")) {
+		add_variant(MMUL_INT8, "madd_avx512", madd_avx512_i8);
+		add_variant(MMUL_INT16, "madd_avx512", madd_avx512_i16);
+	}
+	if (__builtin_cpu_supports("avx2")) {
+		add_variant(MMUL_INT8, "madd_avx2", madd_avx2_i8);
+		add_variant(MMUL_INT16, "madd_avx2", madd_avx2_i16);
+	}
+	if (__builtin_cpu_supports("avx512f")) {
+		add_variant(MMUL_FLOAT, "fma_avx512", fma_avx512_f32);
+		add_variant(MMUL_DOUBLE, "fma_avx512", fma_avx512_f64);
+	}
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+		add_variant(MMUL_FLOAT, "fma_avx2", fma_avx2_f32);
+		add_variant(MMUL_DOUBLE, "fma_avx2", fma_avx2_f64);
+	}
+#endif
+}
+
+const struct mmul_type_info *mmul_type_info(enum mmul_type type) {
+	return &infos[type];
+}
+
+int mmul_typed_variants(enum mmul_type type, const struct mmul_typed_variant **variants) {
+	init_variants();
+	*variants = variants_[type];
+	return n_variants_[type];
+}
+
+size_t mmul_typed_workspace_bytes(enum mmul_type type, int size) {
+	size_t bytes = mmul_arena_bytes((size_t)size * size * infos[type].element_bytes); // B^T
+	if (type == MMUL_INT8 || type == MMUL_INT16) {
+		size_t pairs = packed_bytes(size, 2);
+		size_t quads = packed_bytes(size, 4);
+		bytes = bytes > pairs ? bytes : pairs;
+		bytes = bytes > quads ? bytes : quads;
+	}
+	return bytes;
+}
+
+void mmul_typed_fill(enum mmul_type type, int size, void *M) {
+	int n = size * size;
+	for (int i = 0; i < n; i++) {
+		switch (type) {
+		case MMUL_INT8:
+			((int8_t *)M)[i] = (int8_t)(random() % 256 - 128);
+			break;
+		case MMUL_INT16:
+			((int16_t *)M)[i] = (int16_t)(random() % 512 - 256);
+			break;
+		case MMUL_INT32:
+			((int32_t *)M)[i] = (int32_t)(random() / (RAND_MAX / 100));
+			break;
+		case MMUL_FLOAT:
+			((float *)M)[i] = (float)(2.0 * random() / RAND_MAX - 1.0);
+			break;
+		default:
+			((double *)M)[i] = 2.0 * random() / RAND_MAX - 1.0;
+			break;
+		}
+	}
+}
+
+void mmul_typed_reference(enum mmul_type type, int size, const void *A, const void *B, double *ref, double *bound) {
+	switch (type) {
+	case MMUL_INT8:
+		reference_i8(size, A, B, ref, bound);
+		break;
+	case MMUL_INT16:
+		reference_i16(size, A, B, ref, bound);
+		break;
+	case MMUL_INT32:
+		reference_i32(size, A, B, ref, bound);
+		break;
+	case MMUL_FLOAT:
+		reference_f32(size, A, B, ref, bound);
+		break;
+	default:
+		reference_f64(size, A, B, ref, bound);
+		break;
+	}
+}
+
+bool mmul_typed_compare(enum mmul_type type, int size, const void *C, const double *ref, const double *bound,
+		double *max_error) {
+	switch (type) {
+	case MMUL_INT8:
+		return compare_i8(size, C, ref, bound, 0.0, max_error);
+	case MMUL_INT16:
+		return compare_i16(size, C, ref, bound, 0.0, max_error);
+	case MMUL_INT32:
+		return compare_i32(size, C, ref, bound, 0.0, max_error);
+	case MMUL_FLOAT:
+		return compare_f32(size, C, ref, bound, FLT_EPSILON, max_error);
+	default:
+		return compare_f64(size, C, ref, bound, DBL_EPSILON, max_error);
+	}
+}
@@ -0,0 +1,89 @@
+/*  Element-type generic matrix multiplication: the classic variants of mmul.c generated
+	per element type from one template (mmul_typed_template.h, included once per type)
+	- int8, int16: products accumulated in int32; C is int32 (as in quantized inference)
+	- int32: as mmul.c; float, double: accumulated in the element type
+	- variants: naive (i-j-k), transposedB (dot products along the rows of A and B^T),
+	  blocks (B^T, blocked), rows (i-k-j: row of C += a_ik * row k of B)
+	- the dot products of transposedB and blocks are reductions; the compiler vectorizes
+	  them for the integers but not for float / double without -ffast-math (no
+	  reassociation); rows vectorizes for all types
+	- widening SIMD kernels selected at runtime:
+	  int8:  VNNI vpdpbusd (u8 x s8 -> s32: A is offset by 128, which is subtracted again
+	         with the column sums of B), otherwise AVX2 vpmaddwd after sign extension
+	  int16: vpmaddwd (s16 x s16 -> s32) with AVX-512BW or AVX2
+	  note: vpmaddubsw saturates its int16 pair sums for the full int8 range; not used
+	  float, double: FMA (AVX-512F or AVX2 + FMA), the rows order register tiled; the
+	  order of the sums along k is kept, thus no -ffast-math needed
+	Row-major size x size matrices; temporaries from the workspace arena (mmul_arena.h).
+*/
+
+#ifndef MMUL_TYPED_H_
+#define MMUL_TYPED_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "mmul_arena.h"
+
+#define MMUL_TYPED_BLOCK 64
+
+enum mmul_type {
+	MMUL_INT8,
+	MMUL_INT16,
+	MMUL_INT32,
+	MMUL_FLOAT,
+	MMUL_DOUBLE,
+	MMUL_TYPES
+};
+
+struct mmul_type_info {
+	const char *name;
+	size_t element_bytes; // A, B
+	size_t result_bytes;  // C
+	bool exact;           // integer arithmetic; compared with a tolerance otherwise
+};
+
+/**
+ * C = A * B; C is overwritten; returns false if the workspace is too small
+ */
+typedef bool (*mmul_typed_function)(int size, const void *A, const void *B, void *C, struct mmul_arena *workspace);
+
+struct mmul_typed_variant {
+	const char *name;
+	mmul_typed_function f;
+};
+
+const struct mmul_type_info *mmul_type_info(enum mmul_type type);
+
+/**
+ * variants of this type available on this CPU; the first one is naive
+ * returns the number of variants; *variants points to a static table
+ */
+int mmul_typed_variants(enum mmul_type type, const struct mmul_typed_variant **variants);
+
+/**
+ * bytes of arena needed by all variants of this type for this size
+ */
+size_t mmul_typed_workspace_bytes(enum mmul_type type, int size);
+
+/**
+ * random elements: int8 -128..127 (full range), int16 -256..255, int32 0..99 (as mmul.c),
+ * float and double -1..1
+ */
+void mmul_typed_fill(enum mmul_type type, int size, void *M);
+
+/**
+ * reference of A * B in double (exact for the integer ranges of mmul_typed_fill()) and
+ * bound = sum_k |a_ik * b_kj| per element for the error bounds; size x size each; O(size^3)
+ */
+void mmul_typed_reference(enum mmul_type type, int size, const void *A, const void *B, double *ref, double *bound);
+
+/**
+ * returns true if C matches the reference: exactly for the integers; for float and double
+ * within 2 * size * epsilon * bound per element (rounding errors of the products and sums)
+ * max_error: largest error relative to that limit; 0 for the integers; may be NULL
+ */
+bool mmul_typed_compare(enum mmul_type type, int size, const void *C, const double *ref, const double *bound,
+		double *max_error);
+
+#endif // MMUL_TYPED_H_
@@ -0,0 +1,185 @@
+/*  Template of the element-type generic variants; see mmul_typed.h
+	Included by mmul_typed.c once per type with:
+	- MMUL_T:      element type of A and B
+	- MMUL_R:      accumulator and element type of C
+	- MMUL_SUFFIX: suffix of the generated names, e.g. i8 -> naive_i8, rows_i8, ...
+	No include guard on purpose.
+*/
+
+#if !defined(MMUL_T) || !defined(MMUL_R) || !defined(MMUL_SUFFIX)
+#error "mmul_typed_template.h: define MMUL_T, MMUL_R and MMUL_SUFFIX before the include"
+#endif
+
+// B^T from B (size x size)
+static void TYPED(transpose)(int size, const MMUL_T *B, MMUL_T *B_t) {
+	for (int i = 0; i < size; i += MMUL_TYPED_BLOCK) {
+		int end_i = i + MMUL_TYPED_BLOCK < size ? i + MMUL_TYPED_BLOCK : size;
+		for (int j = 0; j < size; j += MMUL_TYPED_BLOCK) {
+			int end_j = j + MMUL_TYPED_BLOCK < size ? j + MMUL_TYPED_BLOCK : size;
+			for (int i1 = i; i1 < end_i; i1++) {
+				for (int j1 = j; j1 < end_j; j1++) {
+					B_t[j1 * size + i1] = B[i1 * size + j1];
+				}
+			}
+		}
+	}
+}
+
+static bool TYPED(naive)(int size, const void *A_, const void *B_, void *C_, struct mmul_arena *workspace) {
+	(void)workspace;
+	const MMUL_T *A = A_;
+	const MMUL_T *B = B_;
+	MMUL_R *C = C_;
+
+	for (int i = 0; i < size; i++) {
+		for (int j = 0; j < size; j++) {
+			MMUL_R sum = 0;
+			for (int k = 0; k < size; k++) {
+				sum += (MMUL_R)A[i * size + k] * (MMUL_R)B[k * size + j];
+			}
+			C[i * size + j] = sum;
+		}
+	}
+	return true;
+}
+
+static bool TYPED(transposedB)(int size, const void *A_, const void *B_, void *C_, struct mmul_arena *workspace) {
+	const MMUL_T *A = A_;
+	const MMUL_T *B = B_;
+	MMUL_R *C = C_;
+	size_t mark = mmul_arena_mark(workspace);
+	MMUL_T *B_t = mmul_arena_alloc(workspace, (size_t)size * size * sizeof(MMUL_T));
+	if (!B_t) {
+		return false;
+	}
+	TYPED(transpose)(size, B, B_t);
+
+	int a_row = 0;
+	for (int i = 0; i < size; i++) {
+		int bt_row = 0;
+		for (int j = 0; j < size; j++) {
+			MMUL_R sum = 0;
+			for (int k = 0; k < size; k++) {
+				sum += (MMUL_R)A[a_row + k] * (MMUL_R)B_t[bt_row + k];
+			}
+			C[a_row + j] = sum;
+			bt_row += size;
+		}
+		a_row += size;
+	}
+
+	mmul_arena_release(workspace, mark);
+	return true;
+}
+
+static bool TYPED(blocks)(int size, const void *A_, const void *B_, void *C_, struct mmul_arena *workspace) {
+	const MMUL_T *A = A_;
+	const MMUL_T *B = B_;
+	MMUL_R *C = C_;
+	size_t mark = mmul_arena_mark(workspace);
+	MMUL_T *B_t = mmul_arena_alloc(workspace, (size_t)size * size * sizeof(MMUL_T));
+	if (!B_t) {
+		return false;
+	}
+	TYPED(transpose)(size, B, B_t);
+	memset(C, 0, (size_t)size * size * sizeof(MMUL_R));
+
+	for (int i = 0; i < size; i += MMUL_TYPED_BLOCK) {
+		int end_i = i + MMUL_TYPED_BLOCK < size ? i + MMUL_TYPED_BLOCK : size;
+		for (int j = 0; j < size; j += MMUL_TYPED_BLOCK) {
+			int end_j = j + MMUL_TYPED_BLOCK < size ? j + MMUL_TYPED_BLOCK : size;
+			for (int k = 0; k < size; k += MMUL_TYPED_BLOCK) {
+				int end_k = k + MMUL_TYPED_BLOCK < size ? k + MMUL_TYPED_BLOCK : size;
+				for (int i1 = i; i1 < end_i; i1++) {
+					for (int j1 = j; j1 < end_j; j1++) {
+						MMUL_R sum = 0;
+						for (int k1 = k; k1 < end_k; k1++) {
+							sum += (MMUL_R)A[i1 * size + k1] * (MMUL_R)B_t[j1 * size + k1];
+						}
+						C[i1 * size + j1] += sum;
+					}
+				}
+			}
+		}
+	}
+
+	mmul_arena_release(workspace, mark);
+	return true;
+}
+
+static bool TYPED(rows)(int size, const void *A_, const void *B_, void *C_, struct mmul_arena *workspace) {
+	(void)workspace;
+	const MMUL_T *A = A_;
+	const MMUL_T *B = B_;
+	MMUL_R *C = C_;
+
+	for (int i = 0; i < size; i++) {
+		MMUL_R *c = C + i * size;
+		for (int j = 0; j < size; j++) {
+			c[j] = 0;
+		}
+		for (int k = 0; k < size; k++) {
+			MMUL_R a = A[i * size + k];
+			const MMUL_T *b = B + k * size;
+			for (int j = 0; j < size; j++) {
+				c[j] += a * (MMUL_R)b[j];
+			}
+		}
+	}
+	return true;
+}
+
+static void TYPED(reference)(int size, const void *A_, const void *B_, double *ref, double *bound) {
+	const MMUL_T *A = A_;
+	const MMUL_T *B = B_;
+	for (int i = 0; i < size; i++) {
+		for (int j = 0; j < size; j++) {
+			double sum = 0.0;
+			double abs_sum = 0.0;
+			for (int k = 0; k < size; k++) {
+				double p = (double)A[i * size + k] * (double)B[k * size + j];
+				sum += p;
+				abs_sum += fabs(p);
+			}
+			ref[i * size + j] = sum;
+			bound[i * size + j] = abs_sum;
+		}
+	}
+}
+
+static bool TYPED(compare)(int size, const void *C_, const double *ref, const double *bound, double epsilon,
+		double *max_error) {
+	const MMUL_R *C = C_;
+	bool ok = true;
+	double max = 0.0;
+	for (int i = 0; i < size * size; i++) {
+		double error = fabs((double)C[i] - ref[i]);
+		if (epsilon == 0.0) {
+			ok = ok && error == 0.0;
+			continue;
+		}
+		// rounding of the products and sums in MMUL_R; of the reference in double
+		double limit = 2.0 * size * epsilon * bound[i];
+		if (error > limit) {
+			ok = false;
+		}
+		if (limit > 0.0 && error / limit > max) {
+			max = error / limit;
+		}
+	}
+	if (max_error) {
+		*max_error = max;
+	}
+	return ok;
+}
+
+static const struct mmul_typed_variant TYPED(generic_variants)[] = {
+	{"naive", TYPED(naive)},
+	{"transposedB", TYPED(transposedB)},
+	{"blocks_" STRINGIFY(MMUL_TYPED_BLOCK), TYPED(blocks)},
+	{"rows", TYPED(rows)}
+};
+
+#undef MMUL_T
+#undef MMUL_R
+#undef MMUL_SUFFIX
@@ -0,0 +1,71 @@
+/*  Freivalds' randomized verification; see mmul_verify.h
+*/
+
+#include "mmul_verify.h"
+
+//--- helpers ------------------------------------------------------------------
+
+// splitmix64 (Steele, Lea, Flood 2014): a full period generator of 64 bit state
+static uint64_t next_random(uint64_t *state) {
+	uint64_t z = (*state += 0x9e3779b97f4a7c15ull);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+	return z ^ (z >> 31);
+}
+
+// y = M x mod 2^32
+static void multiply_vector(int size, int ld, const int *M, const uint32_t *x, uint32_t *y) {
+	for (int i = 0; i < size; i++) {
+		const int *m = M + (size_t)i * ld;
+		uint32_t sum = 0;
+		for (int j = 0; j < size; j++) {
+			sum += (uint32_t)m[j] * x[j];
+		}
+		y[i] = sum;
+	}
+}
+
+//--- API ----------------------------------------------------------------------
+
+size_t mmul_freivalds_workspace_bytes(int size) {
+	return 3 * mmul_arena_bytes((size_t)size * sizeof(uint32_t));
+}
+
+bool mmul_freivalds(int size, int ld, const int *A, const int *B, const int *C, int rounds, uint64_t seed,
+		struct mmul_arena *workspace, int *error_round) {
+	if (rounds <= 0) {
+		rounds = MMUL_VERIFY_ROUNDS;
+	}
+	size_t mark = mmul_arena_mark(workspace);
+	uint32_t *r = mmul_arena_alloc(workspace, (size_t)size * sizeof(uint32_t));
+	uint32_t *x = mmul_arena_alloc(workspace, (size_t)size * sizeof(uint32_t));
+	uint32_t *y = mmul_arena_alloc(workspace, (size_t)size * sizeof(uint32_t));
+	if (!r || !x || !y) {
+		mmul_arena_release(workspace, mark);
+		if (error_round) {
+			*error_round = -1;
+		}
+		return false;
+	}
+
+	uint64_t state = seed;
+	bool ok = true;
+	int round = 0;
+	for (; round < rounds && ok; round++) {
+		for (int j = 0; j < size; j++) {
+			r[j] = (uint32_t)(next_random(&state) >> 32);
+		}
+		multiply_vector(size, ld, B, r, x); // x = B r
+		multiply_vector(size, ld, A, x, y); // y = A B r
+		multiply_vector(size, ld, C, r, x); // x = C r
+		for (int i = 0; i < size && ok; i++) {
+			ok = x[i] == y[i];
+		}
+	}
+
+	mmul_arena_release(workspace, mark);
+	if (error_round) {
+		*error_round = ok ? 0 : round - 1;
+	}
+	return ok;
+}
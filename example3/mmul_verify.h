@@ -0,0 +1,37 @@
+/*  Randomized verification of C = A * B with Freivalds' algorithm: for a random vector r,
+	A (B r) == C r holds for a correct C; 3 matrix-vector products, O(size^2) per round
+	instead of the O(size^3) reference multiplication.
+	- arithmetic mod 2^32 (uint32_t): matches the wrap-around of the int results; a wrong C
+	  passes one round with probability <= 1/2 (any error matrix, uniform r mod 2^32), thus
+	  <= 2^-rounds in total; much lower in practice (an error of an odd value is detected
+	  except with probability 2^-32)
+	- r from a seeded generator (splitmix64): the same seed reproduces the same vectors
+	- row-major size x size matrices with rows of ld elements; vectors from the arena
+*/
+
+#ifndef MMUL_VERIFY_H_
+#define MMUL_VERIFY_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mmul_arena.h"
+
+#define MMUL_VERIFY_ROUNDS 10
+
+/**
+ * bytes of arena needed by mmul_freivalds() for this size
+ */
+size_t mmul_freivalds_workspace_bytes(int size);
+
+/**
+ * returns true if C == A * B passed all rounds (always if C is correct); false for a
+ * detected error or if the workspace is too small (*error_round = -1 then)
+ * seed: of the random vectors; rounds: 0 for MMUL_VERIFY_ROUNDS
+ * error_round: round that detected the error; may be NULL
+ */
+bool mmul_freivalds(int size, int ld, const int *A, const int *B, const int *C, int rounds, uint64_t seed,
+		struct mmul_arena *workspace, int *error_round);
+
+#endif // MMUL_VERIFY_H_
@@ -1,2 +1,2 @@
 #!/bin/sh
-rm benchmark.c benchmark.h rdtsc.h
+rm benchmark.c benchmark.h rdtsc.h parallel_benchmark.c parallel_benchmark.h
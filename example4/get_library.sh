@@ -0,0 +1,4 @@
+#!/bin/sh
+cp ../benchmark/benchmark.c .
+cp ../benchmark/benchmark.h .
+cp ../benchmark/rdtsc.h .
@@ -0,0 +1,471 @@
+/* Memory hierarchy characterization: load-to-use latency by randomized pointer
+   chasing and STREAM bandwidth (copy, scale, add, triad), plus read-only and
+   write-only bandwidth. The working set is swept from 4 KiB to the given maximum
+   (2 points per octave); the plateaus of the latency curve are detected and
+   reported as cache levels / DRAM with their latency and bandwidth.
+
+   Usage: memory_hierarchy [max_working_set_MiB]   (default STD_MAX_WORKING_SET_MIB)
+
+   notes:
+   - working set: total size of all arrays of a kernel (STREAM: 3 arrays)
+   - pointer chase: one 64 byte node per cache line, linked in a random cyclic order
+     (Sattolo's algorithm) to defeat the prefetchers; the read-write variant
+     additionally increments a counter in each visited node
+   - buffers are allocated by testbench_alloc_buffer() (prefaulted, huge pages for
+     large buffers); thus TLB misses are mostly excluded
+   - bandwidth in bytes per cycle (TSC); GB/s if the TSC frequency is known
+*/
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "benchmark.h"
+
+#define STD_MAX_WORKING_SET_MIB 4096
+#define MIN_WORKING_SET (4 * 1024)
+#define MAX_POINTS 64
+
+// measurements per working set
+#define N 11
+
+#define CHASE_STEPS (1 << 16)
+
+// small working sets: several passes per measurement (denominator)
+#define BANDWIDTH_MIN_BYTES (1024 * 1024)
+
+// a point belongs to the current plateau if its latency is within +/- this tolerance
+// of the first point of the plateau; plateaus need a minimum number of points
+// (the points of the transitions between the levels are not assigned)
+#define PLATEAU_TOLERANCE 0.25
+#define PLATEAU_MIN_POINTS 2
+#define MAX_LEVELS 8
+
+#define CACHE_LINE_SIZE 64
+
+//--- kernels ------------------------------------------------------------------
+
+struct node {
+    struct node *next;
+    uint64_t counter;
+    char pad[CACHE_LINE_SIZE - sizeof(struct node *) - sizeof(uint64_t)];
+};
+
+static volatile uint64_t sink;
+
+__attribute__((noinline))
+static struct node *chase_read(struct node *n, size_t steps) {
+    for (size_t i = 0; i < steps; i++) {
+        n = n->next;
+    }
+    return n;
+}
+
+__attribute__((noinline))
+static struct node *chase_read_write(struct node *n, size_t steps) {
+    for (size_t i = 0; i < steps; i++) {
+        n->counter++;
+        n = n->next;
+    }
+    return n;
+}
+
+__attribute__((noinline))
+static uint64_t read_only(const uint64_t *restrict a, size_t n) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum += a[i];
+    }
+    return sum;
+}
+
+__attribute__((noinline))
+static void write_only(uint64_t *restrict a, size_t n, uint64_t value) {
+    for (size_t i = 0; i < n; i++) {
+        a[i] = value;
+    }
+}
+
+__attribute__((noinline))
+static void stream_copy(double *restrict c, const double *restrict a, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        c[i] = a[i];
+    }
+}
+
+__attribute__((noinline))
+static void stream_scale(double *restrict b, const double *restrict c, double s, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        b[i] = s * c[i];
+    }
+}
+
+__attribute__((noinline))
+static void stream_add(double *restrict c, const double *restrict a, const double *restrict b, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        c[i] = a[i] + b[i];
+    }
+}
+
+__attribute__((noinline))
+static void stream_triad(double *restrict a, const double *restrict b, const double *restrict c, double s, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        a[i] = b[i] + s * c[i];
+    }
+}
+
+//--- measurements -------------------------------------------------------------
+
+enum bandwidth_kernel {
+    BW_READ,
+    BW_WRITE,
+    BW_COPY,
+    BW_SCALE,
+    BW_ADD,
+    BW_TRIAD,
+    BW_N
+};
+
+static const char *bandwidth_names[BW_N] = {"read", "write", "copy", "scale", "add", "triad"};
+
+struct point {
+    size_t size;
+    double latency_read;       // cycles per load (median)
+    double latency_read_write;
+    double bandwidth[BW_N];    // bytes per cycle (median)
+};
+
+static uint64_t xorshift(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+/**
+ * random single cycle through all nodes (Sattolo's algorithm)
+ */
+static bool link_nodes(struct node *nodes, size_t n) {
+    uint32_t *order = malloc(n * sizeof(*order));
+    if (!order) {
+        return false;
+    }
+    for (size_t i = 0; i < n; i++) {
+        order[i] = (uint32_t)i;
+    }
+    uint64_t state = 0x2545f4914f6cdd1dULL;
+    for (size_t i = n - 1; i > 0; i--) {
+        size_t j = xorshift(&state) % i;
+        uint32_t t = order[i];
+        order[i] = order[j];
+        order[j] = t;
+    }
+    for (size_t i = 0; i < n; i++) {
+        nodes[order[i]].next = &nodes[order[(i + 1) % n]];
+    }
+    free(order);
+    return true;
+}
+
+static double measure_latency(struct node *start, bool write) {
+    uint64_t t_start = 0;
+    uint64_t t_stop = 0;
+    struct node *n = start;
+
+    reset_testbench();
+    set_denominator(CHASE_STEPS);
+    n = write ? chase_read_write(n, CHASE_STEPS) : chase_read(n, CHASE_STEPS); // warm up
+    for (int i = 0; i < N; i++) {
+        RDTSC_START(t_start);
+        n = write ? chase_read_write(n, CHASE_STEPS) : chase_read(n, CHASE_STEPS);
+        RDTSC_STOP(t_stop);
+        add_measurement(t_start, t_stop);
+    }
+    sink += (uint64_t)(uintptr_t)n;
+
+    struct testbench_statistics stat = testbench_get_statistics();
+    return stat.median;
+}
+
+static void run_bandwidth_kernel(enum bandwidth_kernel kernel, uint64_t *u, double *a, double *b, double *c,
+                                 size_t n_u, size_t n_d) {
+    switch (kernel) {
+        case BW_READ:
+            sink += read_only(u, n_u);
+            break;
+        case BW_WRITE:
+            write_only(u, n_u, sink);
+            break;
+        case BW_COPY:
+            stream_copy(c, a, n_d);
+            break;
+        case BW_SCALE:
+            stream_scale(b, c, 3.0, n_d);
+            break;
+        case BW_ADD:
+            stream_add(c, a, b, n_d);
+            break;
+        case BW_TRIAD:
+            stream_triad(a, b, c, 3.0, n_d);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * returns bytes per cycle (median)
+ */
+static double measure_bandwidth(enum bandwidth_kernel kernel, uint64_t *u, double *a, double *b, double *c,
+                                size_t n_u, size_t n_d) {
+    uint64_t t_start = 0;
+    uint64_t t_stop = 0;
+
+    // bytes moved per pass as counted by STREAM
+    size_t bytes = 0;
+    switch (kernel) {
+        case BW_READ:
+        case BW_WRITE:
+            bytes = n_u * sizeof(*u);
+            break;
+        case BW_COPY:
+        case BW_SCALE:
+            bytes = 2 * n_d * sizeof(*a);
+            break;
+        default:
+            bytes = 3 * n_d * sizeof(*a);
+            break;
+    }
+
+    size_t reps = BANDWIDTH_MIN_BYTES / bytes;
+    if (reps < 1) {
+        reps = 1;
+    }
+
+    reset_testbench();
+    set_denominator(reps);
+    run_bandwidth_kernel(kernel, u, a, b, c, n_u, n_d); // warm up
+    for (int i = 0; i < N; i++) {
+        RDTSC_START(t_start);
+        for (size_t r = 0; r < reps; r++) {
+            run_bandwidth_kernel(kernel, u, a, b, c, n_u, n_d);
+        }
+        RDTSC_STOP(t_stop);
+        add_measurement(t_start, t_stop);
+    }
+
+    struct testbench_statistics stat = testbench_get_statistics();
+    return stat.median > 0.0 ? (double)bytes / stat.median : 0.0;
+}
+
+static bool measure_point(size_t size, struct point *p) {
+    p->size = size;
+
+    // latency
+    size_t n_nodes = size / sizeof(struct node);
+    struct node *nodes = testbench_alloc_buffer(n_nodes * sizeof(*nodes), NULL);
+    if (!nodes || !link_nodes(nodes, n_nodes)) {
+        testbench_free_buffer(nodes, n_nodes * sizeof(*nodes));
+        return false;
+    }
+    p->latency_read = measure_latency(nodes, false);
+    p->latency_read_write = measure_latency(nodes, true);
+    testbench_free_buffer(nodes, n_nodes * sizeof(*nodes));
+
+    // bandwidth: read/write-only on one array, then STREAM on 3 arrays of size / 3;
+    // one after the other: at most size bytes are allocated at a time
+    size_t n_u = size / sizeof(uint64_t);
+    uint64_t *u = testbench_alloc_buffer(n_u * sizeof(*u), NULL);
+    if (!u) {
+        return false;
+    }
+    p->bandwidth[BW_READ] = measure_bandwidth(BW_READ, u, NULL, NULL, NULL, n_u, 0);
+    p->bandwidth[BW_WRITE] = measure_bandwidth(BW_WRITE, u, NULL, NULL, NULL, n_u, 0);
+    testbench_free_buffer(u, n_u * sizeof(*u));
+
+    size_t n_d = size / 3 / sizeof(double);
+    double *a = testbench_alloc_buffer(n_d * sizeof(*a), NULL);
+    double *b = testbench_alloc_buffer(n_d * sizeof(*b), NULL);
+    double *c = testbench_alloc_buffer(n_d * sizeof(*c), NULL);
+    bool ok = a && b && c;
+    if (ok) {
+        for (size_t i = 0; i < n_d; i++) {
+            a[i] = 1.0;
+            b[i] = 2.0;
+            c[i] = 0.0;
+        }
+        for (int k = BW_COPY; k < BW_N; k++) {
+            p->bandwidth[k] = measure_bandwidth((enum bandwidth_kernel)k, NULL, a, b, c, 0, n_d);
+        }
+    }
+    testbench_free_buffer(c, n_d * sizeof(*c));
+    testbench_free_buffer(b, n_d * sizeof(*b));
+    testbench_free_buffer(a, n_d * sizeof(*a));
+    return ok;
+}
+
+//--- plateau detection --------------------------------------------------------
+
+struct level {
+    size_t first; // index of the first and last point of the plateau
+    size_t last;
+};
+
+/**
+ * plateaus of the read latency; the points between them (transitions) are not assigned
+ */
+static size_t detect_levels(const struct point *points, size_t n_points, struct level *levels) {
+    size_t n_levels = 0;
+    size_t first = 0;
+    for (size_t i = 1; i <= n_points; i++) {
+        double ratio = i < n_points ? points[i].latency_read / points[first].latency_read : 0.0;
+        bool end = i == n_points || ratio > 1.0 + PLATEAU_TOLERANCE || ratio < 1.0 - PLATEAU_TOLERANCE;
+        if (!end) {
+            continue;
+        }
+        if (i - first >= PLATEAU_MIN_POINTS && n_levels < MAX_LEVELS) {
+            levels[n_levels].first = first;
+            levels[n_levels].last = i - 1;
+            n_levels++;
+        }
+        first = i;
+    }
+    return n_levels;
+}
+
+static double median_of(double *values, size_t n) {
+    // insertion sort; few values
+    for (size_t i = 1; i < n; i++) {
+        double v = values[i];
+        size_t j = i;
+        for (; j > 0 && values[j - 1] > v; j--) {
+            values[j] = values[j - 1];
+        }
+        values[j] = v;
+    }
+    return n % 2 ? values[n / 2] : 0.5 * (values[n / 2 - 1] + values[n / 2]);
+}
+
+static void print_size(size_t size) {
+    if (size >= 1024 * 1024 * 1024) {
+        printf("%7.1f GiB", (double)size / (1024.0 * 1024.0 * 1024.0));
+    }
+    else if (size >= 1024 * 1024) {
+        printf("%7.1f MiB", (double)size / (1024.0 * 1024.0));
+    }
+    else {
+        printf("%7.1f KiB", (double)size / 1024.0);
+    }
+}
+
+//--- main ---------------------------------------------------------------------
+
+int main(int argc, char **argv) {
+    size_t max_mib = STD_MAX_WORKING_SET_MIB;
+    if (argc == 2) {
+        max_mib = (size_t)atol(argv[1]);
+    }
+    else if (argc > 2) {
+        fprintf(stderr, "USAGE: memory_hierarchy [max_working_set_MiB]\n");
+        return 1;
+    }
+    size_t max_size = max_mib * 1024 * 1024;
+
+    set_environment_capture(true); // TSC frequency for the bandwidth
+    if (!create_testbench(N)) {
+        fprintf(stderr, "Error: could not open testbench (memory?).\n");
+        exit(1);
+    }
+
+    // scale: bytes per cycle -> GB/s
+    struct testbench_environment env = testbench_get_environment();
+    double scale = 1.0;
+    const char *bw_unit = "B/cycle";
+    if (env.captured && env.tsc_ghz > 0.0) {
+        scale = env.tsc_ghz;
+        bw_unit = "GB/s";
+    }
+
+    // 2 points per octave
+    struct point points[MAX_POINTS];
+    size_t n_points = 0;
+    for (size_t size = MIN_WORKING_SET; size <= max_size && n_points < MAX_POINTS; size *= 2) {
+        size_t sizes[2] = {size, size + size / 2};
+        for (int i = 0; i < 2 && sizes[i] <= max_size && n_points < MAX_POINTS; i++) {
+            if (!measure_point(sizes[i], &points[n_points])) {
+                fprintf(stderr, "Error: could not allocate %zu bytes.\n", sizes[i]);
+                exit(1);
+            }
+            n_points++;
+        }
+    }
+
+    printf("\nMemory hierarchy: latency [cycles per load], bandwidth [%s]\n", bw_unit);
+    printf("working set   lat ro  lat rw");
+    for (int k = 0; k < BW_N; k++) {
+        printf("  %7s", bandwidth_names[k]);
+    }
+    printf("\n");
+    for (size_t i = 0; i < n_points; i++) {
+        const struct point *p = &points[i];
+        print_size(p->size);
+        printf("  %6.1f  %6.1f", p->latency_read, p->latency_read_write);
+        for (int k = 0; k < BW_N; k++) {
+            printf("  %7.2f", p->bandwidth[k] * scale);
+        }
+        printf("\n");
+    }
+
+    // levels; the last level is named DRAM if it exceeds the largest cache
+    size_t largest_cache = 0;
+#ifdef _SC_LEVEL3_CACHE_SIZE
+    long l3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    largest_cache = (size_t)(l3 > 0 ? l3 : (l2 > 0 ? l2 : 0));
+#endif
+    struct level levels[MAX_LEVELS];
+    size_t n_levels = detect_levels(points, n_points, levels);
+    printf("\nDetected levels (plateaus of the read latency; tolerance %.0f %%):\n", 100.0 * PLATEAU_TOLERANCE);
+    for (size_t l = 0; l < n_levels; l++) {
+        const struct level *level = &levels[l];
+        size_t n = level->last - level->first + 1;
+        double values[MAX_POINTS];
+        bool dram = l == n_levels - 1 && largest_cache > 0 && points[level->first].size > largest_cache;
+
+        if (dram) {
+            printf("- DRAM: from ");
+            print_size(points[level->first].size);
+        }
+        else {
+            printf("- L%zu:   up to ", l + 1);
+            print_size(points[level->last].size);
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            values[i] = points[level->first + i].latency_read;
+        }
+        printf(", latency %.1f cycles", median_of(values, n));
+        for (size_t i = 0; i < n; i++) {
+            values[i] = points[level->first + i].latency_read_write;
+        }
+        printf(" (rw %.1f)", median_of(values, n));
+        for (int k = 0; k < BW_N; k++) {
+            for (size_t i = 0; i < n; i++) {
+                values[i] = points[level->first + i].bandwidth[k];
+            }
+            printf(", %s %.2f", bandwidth_names[k], median_of(values, n) * scale);
+        }
+        printf(" %s\n", bw_unit);
+    }
+    if (n_levels == 0) {
+        printf("- none (too few points)\n");
+    }
+
+    delete_testbench();
+    return 0;
+}
@@ -0,0 +1,2 @@
+#!/bin/sh
+rm benchmark.c benchmark.h rdtsc.h
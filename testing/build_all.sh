@@ -16,7 +16,7 @@ cd ..
 cd ../example1
 ./get_library.sh
 make
-cp test_memcpy ../testing
+cp test_memcpy copy_sweep test_parallel_copy test_zero_copy ../testing
 make clean
 cd ../testing
 #
@@ -33,3 +33,10 @@ make
 cp mmul ../testing
 make clean
 cd ../testing
+#
+cd ../example4
+./get_library.sh
+make
+cp memory_hierarchy ../testing
+make clean
+cd ../testing
@@ -24,4 +24,9 @@ make clean
 ./rm_library.sh
 cd ../testing
 #
-rm test_rdtsc_main test_stat_functions_main test_memcpy main mmul result.txt
+cd ../example4
+make clean
+./rm_library.sh
+cd ../testing
+#
+rm test_rdtsc_main test_stat_functions_main test_memcpy copy_sweep test_parallel_copy test_zero_copy main mmul memory_hierarchy result.txt mmul_tune.*.txt
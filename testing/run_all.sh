@@ -2,7 +2,20 @@
 ./test_rdtsc_main
 ./test_stat_functions_main
 ./test_memcpy
+./copy_sweep 1 256
+# sizes up to 1 MiB only; use the defaults (256 MiB, 4 KiB) for the crossovers to DRAM
+./test_parallel_copy 16
+# buffers up to 16 MiB only; use the default (4 GiB, limited by the free memory) to see the saturation of the memory bandwidth
+./test_zero_copy 4
+# buffers up to 4 MiB only; use the default (256 MiB) for the break-even sizes
 ./main
-./mmul 100 >result.txt
-# low n=100 only to avoid strain on the server
+./mmul tune 64
+# tuning cache of this host for size 64 only; used by the *_tuned columns below
+./mmul -scaling -parallel -strassen -types -batched -morton -transpose -padding 100 >result.txt
+# low n=100 only to avoid strain on the server; the reports on stderr are opt-in
 # use more interesting n=1000, 2000, .... for testing
+./mmul -r 1 -freivalds 4 -seed 1 100 >result.txt
+# the same checks with Freivalds' randomized verification (default above size 512)
+./memory_hierarchy 8
+# max. working set 8 MiB only to keep the run short
+# use the default (4 GiB) to see all cache levels and DRAM
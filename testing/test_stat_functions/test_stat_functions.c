@@ -258,6 +258,352 @@ static struct testbench_statistics reference3 = {
 	.ci95_b      =       4.5543
 };
 
+//--- data set 4 - bimodal distribution (mode detection) ----------------------
+//    constructed: 40 values in [100, 104] and 24 values in [300, 303], shuffled
+//    use a denominator = 1
+//    reference values of the modes calculated by hand (median and IQR of each group)
+
+static uint64_t data4[] = {
+302,
+102,
+103,
+102,
+104,
+300,
+102,
+102,
+301,
+300,
+301,
+101,
+302,
+300,
+302,
+301,
+100,
+302,
+104,
+100,
+100,
+101,
+102,
+102,
+100,
+104,
+103,
+101,
+302,
+303,
+102,
+302,
+301,
+301,
+303,
+101,
+101,
+301,
+300,
+302,
+101,
+101,
+303,
+101,
+101,
+102,
+103,
+103,
+101,
+100,
+301,
+101,
+103,
+303,
+100,
+100,
+100,
+100,
+303,
+102,
+301,
+100,
+101,
+102
+};
+
+static int data4_n = sizeof(data4) / sizeof(*data4);
+
+static int denominator4 = 1;
+
+// data set 1 is unimodal: its single mode matches median and IQR of reference1
+static struct testbench_modes reference1_modes = {
+	.n_modes = 1,
+	.modes = {
+		{ .location = 1011374.0, .spread = 132706.25, .weight = 1.0, .count = 101 }
+	}
+};
+
+static struct testbench_modes reference4 = {
+	.n_modes = 2,
+	.modes = {
+		{ .location = 101.0, .spread = 1.5, .weight = 0.625, .count = 40 },
+		{ .location = 301.5, .spread = 1.0, .weight = 0.375, .count = 24 }
+	}
+};
+
+//--- data set 5 - warmup prefix -----------------------------------------------
+//    constructed: 10 decreasing warmup values followed by 50 steady values
+//    use a denominator = 1
+
+static uint64_t data5[] = {
+520,
+470,
+430,
+390,
+340,
+300,
+250,
+210,
+160,
+130,
+99,
+100,
+101,
+100,
+102,
+98,
+100,
+101,
+99,
+100,
+99,
+100,
+101,
+100,
+102,
+98,
+100,
+101,
+99,
+100,
+99,
+100,
+101,
+100,
+102,
+98,
+100,
+101,
+99,
+100,
+99,
+100,
+101,
+100,
+102,
+98,
+100,
+101,
+99,
+100,
+99,
+100,
+101,
+100,
+102,
+98,
+100,
+101,
+99,
+100
+};
+
+static int data5_n = sizeof(data5) / sizeof(*data5);
+
+static int denominator5 = 1;
+
+static struct testbench_steady_state reference5 = {
+	.warmup = 10,
+	.drift = false
+};
+
+//--- data set 6 - drift -------------------------------------------------------
+//    constructed: 30 values around 100 followed by 30 values around 120
+//    use a denominator = 1
+
+static uint64_t data6[] = {
+99,
+100,
+101,
+100,
+102,
+98,
+100,
+101,
+99,
+100,
+99,
+100,
+101,
+100,
+102,
+98,
+100,
+101,
+99,
+100,
+99,
+100,
+101,
+100,
+102,
+98,
+100,
+101,
+99,
+100,
+119,
+120,
+121,
+120,
+122,
+118,
+120,
+121,
+119,
+120,
+119,
+120,
+121,
+120,
+122,
+118,
+120,
+121,
+119,
+120,
+119,
+120,
+121,
+120,
+122,
+118,
+120,
+121,
+119,
+120
+};
+
+static int data6_n = sizeof(data6) / sizeof(*data6);
+
+static int denominator6 = 1;
+
+static struct testbench_steady_state reference6 = {
+	.warmup = 0,
+	.drift = true,
+	.changepoint = 30,
+	.median_before = 100.0,
+	.median_after = 120.0
+};
+
+//--- data set 7 - granularity -------------------------------------------------
+//    constructed: 40 values in steps of 8 (timer granularity): 4 x 96, 32 x 104, 4 x 112;
+//    the rule of thumb bandwidth is below the step; unimodal with the granularity as
+//    lower bound of the bandwidth
+//    use a denominator = 1
+
+static uint64_t data7[] = {
+104,
+104,
+96,
+104,
+104,
+104,
+104,
+112,
+104,
+104,
+104,
+104,
+96,
+104,
+104,
+104,
+104,
+112,
+104,
+104,
+104,
+104,
+96,
+104,
+104,
+104,
+104,
+112,
+104,
+104,
+104,
+104,
+96,
+104,
+104,
+104,
+104,
+112,
+104,
+104
+};
+
+static int data7_n = sizeof(data7) / sizeof(*data7);
+
+static int denominator7 = 1;
+
+static struct testbench_modes reference7 = {
+	.n_modes = 1,
+	.modes = {
+		{ .location = 104.0, .spread = 0.0, .weight = 1.0, .count = 40 }
+	}
+};
+
+//--- data set 8 - large n, spread values --------------------------------------
+//    generated: 160'000 values, 2 clusters of equal weight (sum of 4 uniform values,
+//    centers 1'000'000 and 1'500'000, sd about 29'000) and 1 % outliers up to 100'000'000;
+//    almost all values are distinct. The mode detection is O(n log n); the statistics
+//    including the modes must be available within DATA8_MAX_SECONDS (about 90 s before).
+//    use a denominator = 1
+
+#define DATA8_N 160000
+#define DATA8_MAX_SECONDS 2.0
+
+static uint64_t data8[DATA8_N];
+
+static int denominator8 = 1;
+
+// xorshift64 (Marsaglia 2003): the same values on all hosts
+static uint64_t next_value8(uint64_t *state) {
+	*state ^= *state << 13;
+	*state ^= *state >> 7;
+	*state ^= *state << 17;
+	return *state;
+}
+
+static void generate_data8(void) {
+	uint64_t state = 88172645463325252ull;
+	for(int i = 0; i < DATA8_N; i++) {
+		uint64_t value = 0;
+		if(i % 100 == 99) {
+			value = 2000000 + next_value8(&state) % 98000000;
+		}
+		else {
+			for(int k = 0; k < 4; k++) {
+				value += next_value8(&state) % 50000;
+			}
+			value += i % 2 ? 1400000 : 900000;
+		}
+		data8[i] = value;
+	}
+}
+
 //--- compare data -------------------------------------------------------------
 
 // narrow relative tolerance 0.00001 (check for 0.001 % difference)
@@ -270,7 +616,7 @@ static struct testbench_statistics reference3 = {
 
 static void print_double(char *title, double value, double reference, double rtol) {
 	char *ok_str = NULL;
-	if(fabs(value - reference) < rtol * reference) {
+	if(value == reference || fabs(value - reference) < rtol * reference) {
 		ok_str = " OK  ";
 	}
 	else {
@@ -339,11 +685,119 @@ static void run_comparison(char *title, uint64_t *values, int values_n, int deno
 	print_double("ci95_b (wider RTOL)", stat.ci95_b, ref->ci95_b, RTOL_wide);
 }
 
+static void run_mode_comparison(char *title, uint64_t *values, int values_n, int denominator, struct testbench_modes *ref) {
+	printf("\nRunning test: %s\n", title);
+	reset_testbench();
+	set_denominator(denominator);
+
+	if(!development_load_raw_values(values, values_n)) {
+		fprintf(stderr, "Error while loading raw values for test %s.\n", title);
+		delete_testbench();
+		exit(1);
+	}
+
+	// standard output
+	struct testbench_modes modes = testbench_get_modes();
+	print_testbench_modes("Results", &modes, NULL);
+
+	// actual comparison
+	printf("\nComparison:\n");
+	print_int("n_modes", modes.n_modes, ref->n_modes);
+	size_t n = modes.n_modes < ref->n_modes ? modes.n_modes : ref->n_modes;
+	for(size_t i = 0; i < n; i++) {
+		print_int("count", modes.modes[i].count, ref->modes[i].count);
+		print_double("location", modes.modes[i].location, ref->modes[i].location, RTOL_narrow);
+		print_double("spread", modes.modes[i].spread, ref->modes[i].spread, RTOL_narrow);
+		print_double("weight", modes.modes[i].weight, ref->modes[i].weight, RTOL_narrow);
+	}
+}
+
+static void run_steady_state_comparison(char *title, uint64_t *values, int values_n, int denominator, struct testbench_steady_state *ref) {
+	printf("\nRunning test: %s\n", title);
+	reset_testbench();
+	set_denominator(denominator);
+
+	if(!development_load_raw_values(values, values_n)) {
+		fprintf(stderr, "Error while loading raw values for test %s.\n", title);
+		delete_testbench();
+		exit(1);
+	}
+
+	// standard output
+	struct testbench_steady_state state = testbench_get_steady_state();
+	print_testbench_steady_state("Results", &state, NULL);
+
+	// actual comparison
+	printf("\nComparison:\n");
+	print_int("warmup", state.warmup, ref->warmup);
+	print_int("drift", state.drift, ref->drift);
+	if(ref->drift) {
+		print_int("changepoint", state.changepoint, ref->changepoint);
+		print_double("median_before", state.median_before, ref->median_before, RTOL_narrow);
+		print_double("median_after", state.median_after, ref->median_after, RTOL_narrow);
+	}
+}
+
+// warmup trimming: applied once; a second call returns the same statistics
+static void run_trimming_comparison(char *title, uint64_t *values, int values_n, int denominator, struct testbench_steady_state *ref) {
+	printf("\nRunning test: %s\n", title);
+	reset_testbench();
+	set_denominator(denominator);
+	set_warmup_trimming(true);
+
+	if(!development_load_raw_values(values, values_n)) {
+		fprintf(stderr, "Error while loading raw values for test %s.\n", title);
+		delete_testbench();
+		exit(1);
+	}
+
+	struct testbench_statistics first = testbench_get_statistics();
+	struct testbench_statistics second = testbench_get_statistics();
+	set_warmup_trimming(false);
+	print_testbench_statistics("Results", &second, NULL);
+
+	printf("\nComparison:\n");
+	print_int("warmup (1st call)", first.warmup, ref->warmup);
+	print_int("warmup (2nd call)", second.warmup, ref->warmup);
+	print_int("count (1st call)", first.count, values_n - ref->warmup);
+	print_int("count (2nd call)", second.count, values_n - ref->warmup);
+	print_double("median (2nd call)", second.median, first.median, RTOL_narrow);
+	print_int("changepoint within the values", second.changepoint < second.count, 1);
+}
+
+// the statistics (including the modes) and the modes of a large set of values in limited time
+static void run_timing_comparison(char *title, uint64_t *values, int values_n, int denominator, int ref_n_modes,
+		double max_seconds) {
+	printf("\nRunning test: %s\n", title);
+	reset_testbench();
+	set_denominator(denominator);
+
+	if(!development_load_raw_values(values, values_n)) {
+		fprintf(stderr, "Error while loading raw values for test %s.\n", title);
+		delete_testbench();
+		exit(1);
+	}
+
+	clock_t start = clock();
+	struct testbench_statistics stat = testbench_get_statistics();
+	struct testbench_modes modes = testbench_get_modes();
+	double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+	print_testbench_modes("Results", &modes, NULL);
+
+	printf("\nComparison:\n");
+	printf("statistics and modes in %.3f s (limit %.1f s)\n", seconds, max_seconds);
+	print_int("within the time limit", seconds <= max_seconds, 1);
+	print_int("modes (statistics)", stat.modes, ref_n_modes);
+	print_int("n_modes", modes.n_modes, ref_n_modes);
+}
+
 //--- main ---------------------------------------------------------------------
 
 int main() {
 	// init
 	int max_n = (data1_n > data2_n) ? data1_n : data2_n;
+	max_n = (max_n > data4_n) ? max_n : data4_n;
+	max_n = (max_n > DATA8_N) ? max_n : DATA8_N;
 	if( !create_testbench(max_n) ) {
 		fprintf(stderr, "Error: could not open testbench (memory?).\n");
 		exit(1);
@@ -354,6 +808,23 @@ int main() {
 	run_comparison("Test 2. denominator=32, wider SD, fewer values.", data2, data2_n, denominator2, &reference2);
 	run_comparison("Test 3. corner case n=4.", data3, data3_n, denominator3, &reference3);
 
+	// mode detection
+	run_mode_comparison("Test 4. modes of test 1 (unimodal).", data1, data1_n, denominator1, &reference1_modes);
+	run_mode_comparison("Test 5. modes of a bimodal distribution.", data4, data4_n, denominator4, &reference4);
+
+	// steady state
+	run_steady_state_comparison("Test 6. warmup detection.", data5, data5_n, denominator5, &reference5);
+	run_steady_state_comparison("Test 7. drift detection.", data6, data6_n, denominator6, &reference6);
+	run_trimming_comparison("Test 8. warmup trimming, repeated calls.", data5, data5_n, denominator5, &reference5);
+
+	// mode detection with coarse timer granularity
+	run_mode_comparison("Test 9. modes of values in steps of 8 (unimodal).", data7, data7_n, denominator7, &reference7);
+
+	// cost of the mode detection at large n
+	generate_data8();
+	run_timing_comparison("Test 10. statistics and modes of 160000 spread values (bimodal).", data8, DATA8_N,
+		denominator8, 2, DATA8_MAX_SECONDS);
+
 	// cleanup
 	delete_testbench();
 	return 0;